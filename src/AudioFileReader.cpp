@@ -25,13 +25,110 @@
 #include "AudioProcessor.h"
 #include "Streams.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 
 //------------------------------------------------------------------------------
 
+// Passes on to another processor only the input frames from start_frame to
+// start_frame + frame_count - 1.
+
+class FrameRangeProcessor : public AudioProcessor
+{
+    public:
+        FrameRangeProcessor(
+            AudioProcessor& processor,
+            long long start_frame,
+            long long frame_count) :
+            processor_(processor),
+            start_frame_(start_frame),
+            end_frame_(start_frame + frame_count),
+            frame_(0),
+            channels_(0)
+        {
+        }
+
+        FrameRangeProcessor(const FrameRangeProcessor&) = delete;
+        FrameRangeProcessor& operator=(const FrameRangeProcessor&) = delete;
+
+    public:
+        virtual bool init(const AudioStreamInfo& info, int buffer_size)
+        {
+            channels_ = info.channels;
+
+            AudioStreamInfo range_info(info);
+
+            if (info.frame_count >= 0) {
+                range_info.frame_count = std::max(
+                    std::min(end_frame_, info.frame_count) - start_frame_,
+                    0LL
+                );
+            }
+
+            return processor_.init(range_info, buffer_size);
+        }
+
+        virtual bool acceptsSampleFormat(SampleFormat format) const
+        {
+            return processor_.acceptsSampleFormat(format);
+        }
+
+        virtual bool process(const short* input_buffer, int input_frame_count)
+        {
+            return processRange(input_buffer, input_frame_count);
+        }
+
+        virtual bool process(const int* input_buffer, int input_frame_count)
+        {
+            return processRange(input_buffer, input_frame_count);
+        }
+
+        virtual bool process(const float* input_buffer, int input_frame_count)
+        {
+            return processRange(input_buffer, input_frame_count);
+        }
+
+        virtual void done()
+        {
+            processor_.done();
+        }
+
+    private:
+        template <typename T>
+        bool processRange(const T* input_buffer, int input_frame_count)
+        {
+            const long long start = std::max(start_frame_, frame_);
+            const long long end   = std::min(end_frame_, frame_ + input_frame_count);
+
+            bool success = true;
+
+            if (start < end) {
+                success = processor_.process(
+                    input_buffer + (start - frame_) * channels_,
+                    static_cast<int>(end - start)
+                );
+            }
+
+            frame_ += input_frame_count;
+
+            return success;
+        }
+
+    private:
+        AudioProcessor& processor_;
+        const long long start_frame_;
+        const long long end_frame_;
+        long long frame_;
+        int channels_;
+};
+
+//------------------------------------------------------------------------------
+
 AudioFileReader::AudioFileReader() :
-    percent_(-1) // Force first update to display 0%
+    percent_(-1), // Force first update to display 0%
+    verbose_(true),
+    error_stream_(&error_stream)
 {
 }
 
@@ -43,6 +140,25 @@ AudioFileReader::~AudioFileReader()
 
 //------------------------------------------------------------------------------
 
+bool AudioFileReader::runRange(
+    AudioProcessor& processor,
+    const long long start_frame,
+    const long long frame_count)
+{
+    FrameRangeProcessor range_processor(processor, start_frame, frame_count);
+
+    return run(range_processor);
+}
+
+//------------------------------------------------------------------------------
+
+long long AudioFileReader::getFrameCount() const
+{
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+
 void AudioFileReader::showProgress(long long done, long long total)
 {
     int percent;
@@ -61,7 +177,7 @@ void AudioFileReader::showProgress(long long done, long long total)
         percent = 0;
     }
 
-    if (percent != percent_) {
+    if (percent != percent_ && verbose_) {
         percent_ = percent;
 
         output_stream << "\rDone: " << percent << "%" << std::flush;
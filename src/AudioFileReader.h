@@ -24,6 +24,8 @@
 #if !defined(INC_AUDIO_FILE_READER_H)
 #define INC_AUDIO_FILE_READER_H
 
+#include <iosfwd>
+
 //------------------------------------------------------------------------------
 
 class AudioProcessor;
@@ -41,11 +43,38 @@ class AudioFileReader
 
         virtual bool run(AudioProcessor& processor) = 0;
 
+        // Processes frame_count frames, starting at start_frame. The default
+        // implementation reads the whole file and passes on only the frames
+        // in the requested range; readers that can seek should override this.
+        virtual bool runRange(
+            AudioProcessor& processor,
+            long long start_frame,
+            long long frame_count
+        );
+
+        // Returns the number of frames in the open file, or -1 if this is not
+        // known until the file has been read.
+        virtual long long getFrameCount() const;
+
+        // Disables progress and file information messages, e.g., when reading
+        // several files at once.
+        void setVerbose(bool verbose) { verbose_ = verbose; }
+
+        // Sets the stream for error messages (error_stream by default), e.g.,
+        // to collect the messages when reading on a worker thread.
+        void setErrorStream(std::ostream& stream) { error_stream_ = &stream; }
+
     protected:
         void showProgress(long long done, long long total);
 
+        bool isVerbose() const { return verbose_; }
+
+        std::ostream& getErrorStream() const { return *error_stream_; }
+
     private:
         int percent_;
+        bool verbose_;
+        std::ostream* error_stream_;
 };
 
 //------------------------------------------------------------------------------
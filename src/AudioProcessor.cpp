@@ -25,8 +25,57 @@
 
 //------------------------------------------------------------------------------
 
+AudioStreamInfo::AudioStreamInfo() :
+    sample_rate(0),
+    channels(0),
+    frame_count(-1),
+    frame_count_exact(false),
+    sample_format(SAMPLE_FORMAT_UNKNOWN),
+    seekable(false)
+{
+}
+
+//------------------------------------------------------------------------------
+
+AudioStreamInfo::AudioStreamInfo(const int sample_rate_, const int channels_) :
+    sample_rate(sample_rate_),
+    channels(channels_),
+    frame_count(-1),
+    frame_count_exact(false),
+    sample_format(SAMPLE_FORMAT_UNKNOWN),
+    seekable(false)
+{
+}
+
+//------------------------------------------------------------------------------
+
 AudioProcessor::~AudioProcessor()
 {
 }
 
 //------------------------------------------------------------------------------
+
+bool AudioProcessor::acceptsSampleFormat(const SampleFormat format) const
+{
+    return format == SAMPLE_FORMAT_PCM_16;
+}
+
+//------------------------------------------------------------------------------
+
+bool AudioProcessor::process(
+    const int* /* input_buffer */,
+    int /* input_frame_count */)
+{
+    return false;
+}
+
+//------------------------------------------------------------------------------
+
+bool AudioProcessor::process(
+    const float* /* input_buffer */,
+    int /* input_frame_count */)
+{
+    return false;
+}
+
+//------------------------------------------------------------------------------
@@ -26,22 +26,78 @@
 
 //------------------------------------------------------------------------------
 
+enum SampleFormat
+{
+    SAMPLE_FORMAT_UNKNOWN,
+    SAMPLE_FORMAT_PCM_8,
+    SAMPLE_FORMAT_PCM_16,
+    SAMPLE_FORMAT_PCM_24,
+    SAMPLE_FORMAT_PCM_32,
+    SAMPLE_FORMAT_FLOAT,
+    SAMPLE_FORMAT_DOUBLE
+};
+
+//------------------------------------------------------------------------------
+
+// Describes the audio stream an AudioProcessor is about to receive, so that it
+// can allocate its output up front.
+
+struct AudioStreamInfo
+{
+    AudioStreamInfo();
+    AudioStreamInfo(int sample_rate, int channels);
+
+    int sample_rate;
+    int channels;
+
+    // Total number of frames, or -1 if not known. If frame_count_exact is
+    // false, this is an estimate (e.g., from an MP3 file's size and bitrate).
+    long long frame_count;
+    bool frame_count_exact;
+
+    // Sample format of the source audio, before conversion to the format
+    // passed to AudioProcessor::process().
+    SampleFormat sample_format;
+
+    bool seekable;
+};
+
+//------------------------------------------------------------------------------
+
 class AudioProcessor
 {
     public:
         virtual ~AudioProcessor();
 
         virtual bool init(
-            int sample_rate,
-            int channels,
+            const AudioStreamInfo& info,
             int buffer_size
         ) = 0;
 
+        // Returns true if process() accepts samples in the given format, which
+        // is SAMPLE_FORMAT_PCM_16, SAMPLE_FORMAT_PCM_32, or SAMPLE_FORMAT_FLOAT.
+        // All processors accept 16-bit samples. Readers pass the source audio
+        // in its own format, if accepted, instead of converting it to 16-bit.
+        virtual bool acceptsSampleFormat(SampleFormat format) const;
+
         virtual bool process(
             const short* input_buffer,
             int input_frame_count
         ) = 0;
 
+        // Processes 32-bit integer samples, or float samples in the range -1.0
+        // to 1.0. Only called if acceptsSampleFormat() returns true for
+        // SAMPLE_FORMAT_PCM_32 or SAMPLE_FORMAT_FLOAT.
+        virtual bool process(
+            const int* input_buffer,
+            int input_frame_count
+        );
+
+        virtual bool process(
+            const float* input_buffer,
+            int input_frame_count
+        );
+
         virtual void done() = 0;
 };
 
@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "BlockCodec.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+
+static uint16_t zigzagEncode(const int16_t delta)
+{
+    return static_cast<uint16_t>(
+        (static_cast<uint16_t>(delta) << 1) ^ static_cast<uint16_t>(delta >> 15)
+    );
+}
+
+//------------------------------------------------------------------------------
+
+static uint16_t zigzagDecode(const uint16_t value)
+{
+    return static_cast<uint16_t>((value >> 1) ^ (0U - (value & 1U)));
+}
+
+//------------------------------------------------------------------------------
+
+// Replaces the zigzag encoded deltas in values[1] to values[count - 1] with
+// the decoded values, by adding each delta to the previous value. Arithmetic
+// wraps at 16 bits, the same as when the deltas were computed. With SSE2,
+// eight deltas are decoded at a time: the prefix sum within the vector takes
+// three shifted adds, then the previous value is added to all lanes.
+
+static void decodeDeltas(short* values, const int count)
+{
+    int i = 1;
+
+#if defined(__SSE2__)
+    if (count > 8) {
+        const __m128i one = _mm_set1_epi16(1);
+
+        __m128i previous = _mm_set1_epi16(values[0]);
+
+        for (; i + 8 <= count; i += 8) {
+            const __m128i zigzag = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(values + i)
+            );
+
+            __m128i deltas = _mm_xor_si128(
+                _mm_srli_epi16(zigzag, 1),
+                _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(zigzag, one))
+            );
+
+            deltas = _mm_add_epi16(deltas, _mm_slli_si128(deltas, 2));
+            deltas = _mm_add_epi16(deltas, _mm_slli_si128(deltas, 4));
+            deltas = _mm_add_epi16(deltas, _mm_slli_si128(deltas, 8));
+
+            const __m128i result = _mm_add_epi16(deltas, previous);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), result);
+
+            // Copy the last lane to all lanes
+            previous = _mm_shuffle_epi32(_mm_shufflehi_epi16(result, 0xff), 0xff);
+        }
+    }
+#endif
+
+    uint16_t previous = static_cast<uint16_t>(values[i - 1]);
+
+    for (; i < count; ++i) {
+        previous = static_cast<uint16_t>(
+            previous + zigzagDecode(static_cast<uint16_t>(values[i]))
+        );
+
+        values[i] = static_cast<short>(previous);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+namespace BlockCodec {
+
+//------------------------------------------------------------------------------
+
+void encode(const short* values, const int count, std::vector<uint8_t>& output)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    const uint16_t first = static_cast<uint16_t>(values[0]);
+
+    output.push_back(static_cast<uint8_t>(first & 0xff));
+    output.push_back(static_cast<uint8_t>(first >> 8));
+
+    uint16_t max_zigzag = 0;
+
+    for (int i = 1; i < count; ++i) {
+        const uint16_t zigzag = zigzagEncode(static_cast<int16_t>(values[i] - values[i - 1]));
+
+        if (zigzag > max_zigzag) {
+            max_zigzag = zigzag;
+        }
+    }
+
+    int width = 0;
+
+    while (width < 16 && (max_zigzag >> width) != 0) {
+        ++width;
+    }
+
+    output.push_back(static_cast<uint8_t>(width));
+
+    uint64_t bits = 0;
+    int bit_count = 0;
+
+    for (int i = 1; i < count; ++i) {
+        const uint16_t zigzag = zigzagEncode(static_cast<int16_t>(values[i] - values[i - 1]));
+
+        bits |= static_cast<uint64_t>(zigzag) << bit_count;
+        bit_count += width;
+
+        while (bit_count >= 8) {
+            output.push_back(static_cast<uint8_t>(bits & 0xff));
+            bits >>= 8;
+            bit_count -= 8;
+        }
+    }
+
+    if (bit_count > 0) {
+        output.push_back(static_cast<uint8_t>(bits & 0xff));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+size_t decode(
+    const uint8_t* data,
+    const size_t size,
+    short* values,
+    const int count)
+{
+    if (count <= 0 || size < 3) {
+        return 0;
+    }
+
+    const int width = data[2];
+
+    if (width > 16) {
+        return 0;
+    }
+
+    const size_t packed_size =
+        (static_cast<size_t>(count - 1) * static_cast<size_t>(width) + 7) / 8;
+
+    if (size < 3 + packed_size) {
+        return 0;
+    }
+
+    values[0] = static_cast<short>(data[0] | (data[1] << 8));
+
+    // Unpack the deltas into values, to be decoded in place
+    const uint8_t* packed = data + 3;
+    const uint64_t mask = (1U << width) - 1;
+
+    uint64_t bits = 0;
+    int bit_count = 0;
+
+    for (int i = 1; i < count; ++i) {
+        while (bit_count < width) {
+            bits |= static_cast<uint64_t>(*packed++) << bit_count;
+            bit_count += 8;
+        }
+
+        values[i] = static_cast<short>(bits & mask);
+
+        bits >>= width;
+        bit_count -= width;
+    }
+
+    decodeDeltas(values, count);
+
+    return 3 + packed_size;
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace BlockCodec
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,54 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_BLOCK_CODEC_H)
+#define INC_BLOCK_CODEC_H
+
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+// Compresses a series of 16-bit values, such as the min values of a block of
+// waveform points. The first value is stored as is, followed by the width in
+// bits of the largest of the remaining deltas, then each delta from the
+// previous value, zigzag encoded (so small negative deltas are also small
+// numbers) and packed into that many bits.
+
+namespace BlockCodec {
+    // Appends the encoded values to output.
+    void encode(const short* values, int count, std::vector<uint8_t>& output);
+
+    // Decodes count values from data, and returns the number of bytes used,
+    // or zero if size is too small or the data is invalid.
+    size_t decode(const uint8_t* data, size_t size, short* values, int count);
+}
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_BLOCK_CODEC_H)
+
+//------------------------------------------------------------------------------
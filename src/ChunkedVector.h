@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_CHUNKED_VECTOR_H)
+#define INC_CHUNKED_VECTOR_H
+
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+// A sequence of values stored in fixed size chunks, so that appending never
+// moves existing values or needs more memory than one extra chunk, unlike
+// std::vector, which copies all its values each time its capacity grows.
+
+template <typename T>
+class ChunkedVector
+{
+    public:
+        // The number of values in each chunk is a power of two, so an index is
+        // split into chunk and offset with a shift and a mask, and is even, so
+        // interleaved min and max values are never split between chunks.
+        static const size_t CHUNK_SIZE_BITS = 16;
+        static const size_t CHUNK_SIZE = static_cast<size_t>(1) << CHUNK_SIZE_BITS;
+
+    public:
+        ChunkedVector() :
+            size_(0)
+        {
+        }
+
+        ChunkedVector(const ChunkedVector&) = delete;
+        ChunkedVector& operator=(const ChunkedVector&) = delete;
+
+    public:
+        size_t size() const { return size_; }
+
+        bool empty() const { return size_ == 0; }
+
+        const T& operator[](size_t index) const
+        {
+            return chunks_[index >> CHUNK_SIZE_BITS][index & (CHUNK_SIZE - 1)];
+        }
+
+        T& operator[](size_t index)
+        {
+            return chunks_[index >> CHUNK_SIZE_BITS][index & (CHUNK_SIZE - 1)];
+        }
+
+        void push_back(T value)
+        {
+            if ((size_ >> CHUNK_SIZE_BITS) == chunks_.size()) {
+                addChunk();
+            }
+
+            (*this)[size_++] = value;
+        }
+
+        size_t capacity() const { return chunks_.size() << CHUNK_SIZE_BITS; }
+
+        // New values are set to zero. Chunks no longer needed are freed.
+        void resize(size_t size)
+        {
+            reserve(size);
+
+            for (size_t i = size_; i < size; ++i) {
+                (*this)[i] = T();
+            }
+
+            chunks_.resize((size + CHUNK_SIZE - 1) >> CHUNK_SIZE_BITS);
+
+            size_ = size;
+        }
+
+        // Allocates enough chunks to hold size values, so that appending up to
+        // that many values allocates no more memory.
+        void reserve(size_t size)
+        {
+            while (capacity() < size) {
+                addChunk();
+            }
+        }
+
+        // Frees all chunks.
+        void clear()
+        {
+            std::vector<std::unique_ptr<T[]>>().swap(chunks_);
+            size_ = 0;
+        }
+
+        // Sets data to point to the value at the given index, and returns the
+        // number of values stored contiguously from there, which is at least
+        // one and extends to the end of the chunk or the last value.
+        size_t getSpan(size_t index, const T*& data) const
+        {
+            data = &(*this)[index];
+
+            const size_t chunk_end = (index | (CHUNK_SIZE - 1)) + 1;
+
+            return (chunk_end < size_ ? chunk_end : size_) - index;
+        }
+
+    private:
+        // Values are left uninitialized, so reserved memory isn't touched
+        // until it's used.
+        void addChunk()
+        {
+            chunks_.emplace_back(new T[CHUNK_SIZE]);
+        }
+
+    private:
+        std::vector<std::unique_ptr<T[]>> chunks_;
+        size_t size_;
+};
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+const size_t ChunkedVector<T>::CHUNK_SIZE_BITS;
+
+template <typename T>
+const size_t ChunkedVector<T>::CHUNK_SIZE;
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_CHUNKED_VECTOR_H)
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2013, 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+
+#include "ErrorUtil.h"
+
+#include <cstring>
+
+//------------------------------------------------------------------------------
+
+// strerror_r() returns int in its POSIX form, or the message in its GNU form,
+// which may not use the given buffer, so the result is taken from whichever
+// the overloads below receive. Only one of these is used, so they are inline
+// to avoid an unused function warning for the other.
+
+static inline std::string getMessage(const int result, const char* buffer)
+{
+    return result == 0 ? buffer : "Unknown error";
+}
+
+//------------------------------------------------------------------------------
+
+static inline std::string getMessage(const char* result, const char* /* buffer */)
+{
+    return result;
+}
+
+//------------------------------------------------------------------------------
+
+namespace ErrorUtil {
+
+//------------------------------------------------------------------------------
+
+std::string errorToString(const int error)
+{
+    char buffer[256];
+    buffer[0] = '\0';
+
+    return getMessage(strerror_r(error, buffer, sizeof(buffer)), buffer);
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace ErrorUtil
+
+//------------------------------------------------------------------------------
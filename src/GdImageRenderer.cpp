@@ -23,6 +23,7 @@
 
 #include "GdImageRenderer.h"
 #include "Array.h"
+#include "ErrorUtil.h"
 #include "MathUtil.h"
 #include "Streams.h"
 #include "TimeUtil.h"
@@ -32,6 +33,7 @@
 
 #include <gdfonts.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -44,7 +46,11 @@
 
 const int MAX_SAMPLE_RATE   = 50000;
 const int MAX_ZOOM          = 2000000;
-const double MAX_START_TIME = 12 * 60 * 60; // 12 hours
+const double MAX_START_TIME = 100.0 * 365 * 24 * 60 * 60; // 100 years
+
+// Number of image rows drawn at a time by renderToPng().
+
+const int BAND_HEIGHT = 32;
 
 //------------------------------------------------------------------------------
 
@@ -53,7 +59,11 @@ GdImageRenderer::GdImageRenderer() :
     image_width_(0),
     image_height_(0),
     start_index_(0),
-    render_axis_labels_(true)
+    buffer_start_index_(0),
+    band_y_(0),
+    render_axis_labels_(true),
+    verbose_(true),
+    error_stream_(&error_stream)
 {
 }
 
@@ -75,46 +85,152 @@ bool GdImageRenderer::create(
     const int image_width,
     const int image_height,
     const WaveformColors& colors,
+    const bool render_axis_labels,
+    const bool use_palette)
+{
+    if (!init(buffer, start_time, image_width, image_height, render_axis_labels)) {
+        return false;
+    }
+
+    // The waveform uses at most five colors, so a palette image is sufficient
+    // unless any of the colors are translucent. Palette images are smaller in
+    // memory and quicker to encode as PNG.
+    if (use_palette && !colors.hasAlpha()) {
+        image_ = gdImageCreate(image_width, image_height);
+    }
+    else {
+        image_ = gdImageCreateTrueColor(image_width, image_height);
+    }
+
+    if (image_ == nullptr) {
+        *error_stream_ << "Failed to create image\n";
+        return false;
+    }
+
+    if (colors.hasAlpha()) {
+        gdImageSaveAlpha(image_, 1);
+        gdImageAlphaBlending(image_, 0);
+    }
+
+    initColors(colors, buffer.hasRms());
+    draw(buffer);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Renders the waveform directly to a PNG file, without creating an image of
+// the full size. The image is drawn in horizontal bands of BAND_HEIGHT rows,
+// each of which is passed to the PNG encoder as soon as it is complete, so
+// memory use depends only on the image width. The output is always a palette
+// image, with the same pixel values as create() would produce.
+
+bool GdImageRenderer::renderToPng(
+    const WaveformBuffer& buffer,
+    const double start_time,
+    const int image_width,
+    const int image_height,
+    const WaveformColors& colors,
+    const bool render_axis_labels,
+    const char* filename,
+    const int compression_level,
+    const PngWriter::Filter filter)
+{
+    if (compression_level < -1 || compression_level > 9) {
+        *error_stream_ << "Invalid PNG compression level: must be between 0 and 9\n";
+        return false;
+    }
+
+    if (!init(buffer, start_time, image_width, image_height, render_axis_labels)) {
+        return false;
+    }
+
+    const int band_height = std::min(image_height, BAND_HEIGHT);
+
+    image_ = gdImageCreate(image_width, band_height);
+
+    if (image_ == nullptr) {
+        *error_stream_ << "Failed to create image\n";
+        return false;
+    }
+
+    initColors(colors, buffer.hasRms());
+
+    PngWriter writer(compression_level, filter, 1);
+    writer.setVerbose(verbose_);
+    writer.setErrorStream(*error_stream_);
+
+    if (!writer.open(filename, image_, image_height)) {
+        return false;
+    }
+
+    for (int band_y = 0; band_y < image_height; band_y += band_height) {
+        band_y_ = band_y;
+        draw(buffer);
+
+        const int rows = std::min(band_height, image_height - band_y);
+
+        for (int y = 0; y < rows; ++y) {
+            if (!writer.writeRow(image_->pixels[y])) {
+                // The writer's destructor closes the incomplete file
+                band_y_ = 0;
+                return false;
+            }
+        }
+    }
+
+    band_y_ = 0;
+
+    return writer.close();
+}
+
+//------------------------------------------------------------------------------
+
+bool GdImageRenderer::init(
+    const WaveformBuffer& buffer,
+    const double start_time,
+    const int image_width,
+    const int image_height,
     const bool render_axis_labels)
 {
+    // Discard the image from any previous call, so the renderer can be reused
+    if (image_ != nullptr) {
+        gdImageDestroy(image_);
+        image_ = nullptr;
+    }
+
     if (start_time < 0.0) {
-        error_stream << "Invalid start time: minimum 0\n";
+        *error_stream_ << "Invalid start time: minimum 0\n";
         return false;
     }
     else if (start_time > MAX_START_TIME) {
-        error_stream << "Invalid start time: maximum " << MAX_START_TIME << '\n';
+        *error_stream_ << "Invalid start time: maximum " << static_cast<long long>(MAX_START_TIME) << '\n';
         return false;
     }
 
     if (image_width < 1) {
-        error_stream << "Invalid image width: minimum 1\n";
+        *error_stream_ << "Invalid image width: minimum 1\n";
         return false;
     }
 
     if (image_height < 1) {
-        error_stream << "Invalid image height: minimum 1\n";
+        *error_stream_ << "Invalid image height: minimum 1\n";
         return false;
     }
 
     const int sample_rate = buffer.getSampleRate();
 
     if (sample_rate > MAX_SAMPLE_RATE) {
-        error_stream << "Invalid sample rate: " << sample_rate
-                     << " Hz, maximum " << MAX_SAMPLE_RATE << " Hz\n";
+        *error_stream_ << "Invalid sample rate: " << sample_rate
+                       << " Hz, maximum " << MAX_SAMPLE_RATE << " Hz\n";
         return false;
     }
 
     const int samples_per_pixel = buffer.getSamplesPerPixel();
 
     if (samples_per_pixel > MAX_ZOOM) {
-        error_stream << "Invalid zoom: maximum " << MAX_ZOOM << '\n';
-        return false;
-    }
-
-    image_ = gdImageCreateTrueColor(image_width, image_height);
-
-    if (image_ == nullptr) {
-        error_stream << "Failed to create image\n";
+        *error_stream_ << "Invalid zoom: maximum " << MAX_ZOOM << '\n';
         return false;
     }
 
@@ -128,21 +244,25 @@ bool GdImageRenderer::create(
     samples_per_pixel_  = samples_per_pixel;
     start_index_        = secondsToPixels(start_time);
     render_axis_labels_ = render_axis_labels;
+    band_y_             = 0;
+
+    if (verbose_) {
+        output_stream << "Image dimensions: " << image_width_ << "x" << image_height_ << " pixels"
+                      << "\nSample rate: " << sample_rate_ << " Hz"
+                      << "\nSamples per pixel: " << samples_per_pixel_
+                      << "\nStart time: " << start_time_ << " seconds"
+                      << "\nStart index: " << start_index_
+                      << "\nBuffer size: " << buffer.getSize()
+                      << "\nAxis labels: " << (render_axis_labels_ ? "yes" : "no") << std::endl;
+    }
 
-    output_stream << "Image dimensions: " << image_width_ << "x" << image_height_ << " pixels"
-                  << "\nSample rate: " << sample_rate_ << " Hz"
-                  << "\nSamples per pixel: " << samples_per_pixel_
-                  << "\nStart time: " << start_time_ << " seconds"
-                  << "\nStart index: " << start_index_
-                  << "\nBuffer size: " << buffer.getSize()
-                  << "\nAxis labels: " << (render_axis_labels_ ? "yes" : "no") << std::endl;
+    return true;
+}
 
-    if (colors.hasAlpha()) {
-        gdImageSaveAlpha(image_, 1);
-        gdImageAlphaBlending(image_, 0);
-    }
+//------------------------------------------------------------------------------
 
-    initColors(colors);
+void GdImageRenderer::draw(const WaveformBuffer& buffer) const
+{
     drawBackground();
 
     if (render_axis_labels_) {
@@ -154,8 +274,6 @@ bool GdImageRenderer::create(
     if (render_axis_labels_) {
         drawTimeAxisLabels();
     }
-
-    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -172,26 +290,34 @@ int GdImageRenderer::createColor(const RGBA& color)
 
 //------------------------------------------------------------------------------
 
-void GdImageRenderer::initColors(const WaveformColors& colors)
+// The RMS color is only allocated if used, so that images of waveform data
+// without RMS values have the same palette as before.
+
+void GdImageRenderer::initColors(const WaveformColors& colors, const bool rms)
 {
     border_color_     = createColor(colors.border_color);
     background_color_ = createColor(colors.background_color);
     waveform_color_   = createColor(colors.waveform_color);
     axis_label_color_ = createColor(colors.axis_label_color);
+    rms_color_        = rms ? createColor(colors.rms_color) : waveform_color_;
 }
 
 //------------------------------------------------------------------------------
 
+// All drawing functions use image coordinates, offset by band_y_ so that
+// renderToPng() can draw one band of the image at a time. libgd clips anything
+// outside the band.
+
 void GdImageRenderer::drawBackground() const
 {
-    gdImageFilledRectangle(image_, 0, 0, image_width_ - 1, image_height_ - 1, background_color_);
+    gdImageFilledRectangle(image_, 0, 0, gdImageSX(image_) - 1, gdImageSY(image_) - 1, background_color_);
 }
 
 //------------------------------------------------------------------------------
 
 void GdImageRenderer::drawBorder() const
 {
-    gdImageRectangle(image_, 0, 0, image_width_ - 1, image_height_ - 1, border_color_);
+    gdImageRectangle(image_, 0, -band_y_, image_width_ - 1, image_height_ - 1 - band_y_, border_color_);
 }
 
 //------------------------------------------------------------------------------
@@ -205,22 +331,53 @@ void GdImageRenderer::drawWaveform(const WaveformBuffer& buffer) const
     const int wave_bottom_y   = render_axis_labels_ ? image_height_ - 2 : image_height_ - 1;
     const int max_wave_height = render_axis_labels_ ? image_height_ - 2 : image_height_;
 
-    const int buffer_size = buffer.getSize();
+    const long long buffer_end = buffer_start_index_ + buffer.getSize();
 
     // Avoid drawing over the left border
     int x = render_axis_labels_ ? 1 : 0;
-    int i = render_axis_labels_ ? start_index_ + 1 : start_index_;
+    long long i = render_axis_labels_ ? start_index_ + 1 : start_index_;
+
+    assert(i >= buffer_start_index_);
+
+    const bool has_rms = buffer.hasRms();
+
+    // Multi-channel data is drawn as one band per channel, the first channel
+    // at the top
+    const int channels = buffer.getChannels();
+    const int channel_height = max_wave_height / channels;
+
+    for (; x < max_x && i < buffer_end; ++i, ++x) {
+        for (int channel = 0; channel < channels; ++channel) {
+            const short min = buffer.getMinSample(channel, i - buffer_start_index_);
+            const short max = buffer.getMaxSample(channel, i - buffer_start_index_);
 
-    for (; x < max_x && i < buffer_size; ++i, ++x) {
-        // convert range [-32768, 32727] to [0, 65535]
-        int low  = buffer.getMinSample(i) + 32768;
-        int high = buffer.getMaxSample(i) + 32768;
+            const int bottom_y = wave_bottom_y - (channels - 1 - channel) * channel_height;
 
-        // scale to fit the bitmap
-        int low_y  = wave_bottom_y - low  * max_wave_height / 65536;
-        int high_y = wave_bottom_y - high * max_wave_height / 65536;
+            // convert range [-32768, 32727] to [0, 65535]
+            int low  = min + 32768;
+            int high = max + 32768;
 
-        gdImageLine(image_, x, low_y, x, high_y, waveform_color_);
+            // scale to fit the bitmap
+            int low_y  = bottom_y - low  * channel_height / 65536;
+            int high_y = bottom_y - high * channel_height / 65536;
+
+            gdImageLine(image_, x, low_y - band_y_, x, high_y - band_y_, waveform_color_);
+
+            if (has_rms) {
+                // Draw an inner band from -rms to +rms, within the min and max
+                const int rms = buffer.getRmsSample(i - buffer_start_index_);
+
+                low  = std::max(-rms, static_cast<int>(min)) + 32768;
+                high = std::min(rms, static_cast<int>(max)) + 32768;
+
+                if (low <= high) {
+                    low_y  = bottom_y - low  * channel_height / 65536;
+                    high_y = bottom_y - high * channel_height / 65536;
+
+                    gdImageLine(image_, x, low_y - band_y_, x, high_y - band_y_, rms_color_);
+                }
+            }
+        }
     }
 }
 
@@ -234,43 +391,48 @@ void GdImageRenderer::drawTimeAxisLabels() const
     const int axis_label_interval_secs = getAxisLabelScale();
 
     // Distance between axis markers (pixels)
-    const int axis_label_interval_pixels = secondsToPixels(axis_label_interval_secs);
+    const long long axis_label_interval_pixels = secondsToPixels(axis_label_interval_secs);
 
     // Time of first axis marker (seconds)
-    const int first_axis_label_secs = MathUtil::roundUpToNearest(start_time_, axis_label_interval_secs);
+    const long long first_axis_label_secs = MathUtil::roundUpToNearest(start_time_, axis_label_interval_secs);
 
     // Distance between waveform start time and first axis marker (seconds)
-    const double axis_label_offset_secs = first_axis_label_secs - start_time_;
+    const double axis_label_offset_secs = static_cast<double>(first_axis_label_secs) - start_time_;
 
     // Distance between waveform start time and first axis marker (samples)
-    const int axis_label_offset_samples = secondsToSamples(axis_label_offset_secs);
+    const long long axis_label_offset_samples = secondsToSamples(axis_label_offset_secs);
 
     // Distance between waveform start time and first axis marker (pixels)
-    const int axis_label_offset_pixels = axis_label_offset_samples / samples_per_pixel_;
+    const int axis_label_offset_pixels =
+        static_cast<int>(axis_label_offset_samples / samples_per_pixel_);
 
     assert(axis_label_offset_pixels >= 0);
 
-    output_stream << "Axis label interval: " << axis_label_interval_secs << " secs\n"
-                  << "Axis label interval: " << axis_label_interval_pixels << " pixels\n"
-                  << "First axis label: " << first_axis_label_secs << " secs\n"
-                  << "Axis label offset: " << axis_label_offset_pixels << " pixels\n";
+    if (verbose_ && band_y_ == 0) {
+        output_stream << "Axis label interval: " << axis_label_interval_secs << " secs\n"
+                      << "Axis label interval: " << axis_label_interval_pixels << " pixels\n"
+                      << "First axis label: " << first_axis_label_secs << " secs\n"
+                      << "Axis label offset: " << axis_label_offset_pixels << " pixels\n";
+    }
 
     gdFontPtr font = gdFontGetSmall();
 
-    int secs = first_axis_label_secs;
+    long long secs = first_axis_label_secs;
 
     for (;;) {
-        const int x = axis_label_offset_pixels +
+        const long long label_offset_pixels =
             (secs - first_axis_label_secs) * sample_rate_ / samples_per_pixel_;
 
-        assert(x >= 0);
-
-        if (x >= image_width_) {
+        if (axis_label_offset_pixels + label_offset_pixels >= image_width_) {
             break;
         }
 
-        gdImageLine(image_, x, 0, x, marker_height, border_color_);
-        gdImageLine(image_, x, image_height_ - 1, x, image_height_ - 1 - marker_height, border_color_);
+        const int x = axis_label_offset_pixels + static_cast<int>(label_offset_pixels);
+
+        assert(x >= 0);
+
+        gdImageLine(image_, x, -band_y_, x, marker_height - band_y_, border_color_);
+        gdImageLine(image_, x, image_height_ - 1 - band_y_, x, image_height_ - 1 - marker_height - band_y_, border_color_);
 
         char label[50];
         const int label_length = TimeUtil::secondsToString(label, ARRAY_LENGTH(label), secs);
@@ -284,7 +446,7 @@ void GdImageRenderer::drawTimeAxisLabels() const
                 image_,
                 font,
                 label_x,
-                label_y,
+                label_y - band_y_,
                 reinterpret_cast<unsigned char*>(label),
                 axis_label_color_
             );
@@ -317,7 +479,7 @@ int GdImageRenderer::getAxisLabelScale() const
     for (;;) {
         secs = base_secs * steps[index];
 
-        int pixels = secondsToPixels(secs);
+        long long pixels = secondsToPixels(secs);
 
         if (pixels < MIN_SPACING) {
             if (++index == ARRAY_LENGTH(steps)) {
@@ -336,23 +498,46 @@ int GdImageRenderer::getAxisLabelScale() const
 
 //------------------------------------------------------------------------------
 
-bool GdImageRenderer::saveAsPng(const char* filename) const
+bool GdImageRenderer::saveAsPng(
+    const char* filename,
+    const int compression_level,
+    const PngWriter::Filter filter,
+    const int threads) const
 {
+    if (compression_level < -1 || compression_level > 9) {
+        *error_stream_ << "Invalid PNG compression level: must be between 0 and 9\n";
+        return false;
+    }
+
+    // libgd compresses on a single thread and doesn't allow the row filter to
+    // be chosen, so use our own encoder for large images or if a specific
+    // filter is requested.
+
+    PngWriter writer(compression_level, filter, threads);
+    writer.setVerbose(verbose_);
+    writer.setErrorStream(*error_stream_);
+
+    if (filter != PngWriter::FILTER_DEFAULT || writer.getSegmentCount(image_) > 1) {
+        return writer.write(image_, filename);
+    }
+
     bool success = true;
 
     FILE* output_file = fopen(filename, "wb");
 
     if (output_file != nullptr) {
-        output_stream << "Writing PNG file: " << filename << std::endl;
+        if (verbose_) {
+            output_stream << "Writing PNG file: " << filename << std::endl;
+        }
 
-        gdImagePng(image_, output_file);
+        gdImagePngEx(image_, output_file, compression_level);
 
         fclose(output_file);
         output_file = nullptr;
     }
     else {
-        error_stream << "Failed to write PNG file: " << filename << '\n'
-                     << strerror(errno) << '\n';
+        *error_stream_ << "Failed to write PNG file: " << filename << '\n'
+                       << ErrorUtil::errorToString(errno) << '\n';
 
         success = false;
     }
@@ -362,9 +547,9 @@ bool GdImageRenderer::saveAsPng(const char* filename) const
 
 //------------------------------------------------------------------------------
 
-int GdImageRenderer::secondsToPixels(const double seconds) const
+long long GdImageRenderer::secondsToPixels(const double seconds) const
 {
-    return static_cast<int>(seconds * sample_rate_ / samples_per_pixel_);
+    return static_cast<long long>(seconds * sample_rate_ / samples_per_pixel_);
 }
 
 //------------------------------------------------------------------------------
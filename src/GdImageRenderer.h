@@ -26,6 +26,8 @@
 
 //------------------------------------------------------------------------------
 
+#include "PngWriter.h"
+
 #include <gd.h>
 
 //------------------------------------------------------------------------------
@@ -52,17 +54,54 @@ class GdImageRenderer
             int image_width,
             int image_height,
             const WaveformColors& colors,
-            bool render_axis_labels
+            bool render_axis_labels,
+            bool use_palette = false
+        );
+
+        bool renderToPng(
+            const WaveformBuffer& buffer,
+            double start_time,
+            int image_width,
+            int image_height,
+            const WaveformColors& colors,
+            bool render_axis_labels,
+            const char* filename,
+            int compression_level = -1,
+            PngWriter::Filter filter = PngWriter::FILTER_DEFAULT
         );
 
         int createColor(const RGBA& color);
 
+        // Enables or disables progress messages (enabled by default)
+        void setVerbose(bool verbose) { verbose_ = verbose; }
+
+        // Sets the stream for error messages (error_stream by default), e.g.,
+        // to collect the messages from a worker thread
+        void setErrorStream(std::ostream& stream) { error_stream_ = &stream; }
+
+        // Sets the waveform data index of the buffer's first point, for
+        // buffers that hold only the part of the waveform shown in the image
+        void setBufferStartIndex(long long index) { buffer_start_index_ = index; }
+
         bool saveAsPng(
-            const char* filename
+            const char* filename,
+            int compression_level = -1,
+            PngWriter::Filter filter = PngWriter::FILTER_DEFAULT,
+            int threads = 1
         ) const;
 
     private:
-        void initColors(const WaveformColors& colors);
+        bool init(
+            const WaveformBuffer& buffer,
+            double start_time,
+            int image_width,
+            int image_height,
+            bool render_axis_labels
+        );
+
+        void initColors(const WaveformColors& colors, bool rms);
+
+        void draw(const WaveformBuffer& buffer) const;
 
         void drawBackground() const;
         void drawBorder() const;
@@ -74,12 +113,12 @@ class GdImageRenderer
         int getAxisLabelScale() const;
 
         template<typename T>
-        int secondsToSamples(T seconds) const
+        long long secondsToSamples(T seconds) const
         {
-            return static_cast<int>(sample_rate_ * seconds);
+            return static_cast<long long>(sample_rate_ * seconds);
         }
 
-        int secondsToPixels(const double seconds) const;
+        long long secondsToPixels(const double seconds) const;
 
     private:
         gdImagePtr image_;
@@ -89,14 +128,22 @@ class GdImageRenderer
         double start_time_;
         int sample_rate_;
         int samples_per_pixel_;
-        int start_index_;
+        long long start_index_;
+        long long buffer_start_index_;
+
+        // First image row of the band being drawn by renderToPng()
+        int band_y_;
 
         int border_color_;
         int background_color_;
         int waveform_color_;
         int axis_label_color_;
+        int rms_color_;
 
         bool render_axis_labels_;
+
+        bool verbose_;
+        std::ostream* error_stream_;
 };
 
 //------------------------------------------------------------------------------
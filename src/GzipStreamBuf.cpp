@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "GzipStreamBuf.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------
+
+const size_t BUFFER_SIZE = 64 * 1024;
+
+//------------------------------------------------------------------------------
+
+GzipStreamBuf::GzipStreamBuf(std::ostream& output, const int compression_level) :
+    output_(output),
+    input_(BUFFER_SIZE),
+    output_buffer_(BUFFER_SIZE),
+    finished_(false)
+{
+    memset(&stream_, 0, sizeof(stream_));
+
+    const int result = deflateInit2(
+        &stream_,
+        compression_level,
+        Z_DEFLATED,
+        15 + 16, // gzip format, 32 KB window
+        8,
+        Z_DEFAULT_STRATEGY
+    );
+
+    if (result != Z_OK) {
+        throw std::runtime_error("Invalid compression level");
+    }
+
+    setp(&input_[0], &input_[0] + input_.size());
+}
+
+//------------------------------------------------------------------------------
+
+GzipStreamBuf::~GzipStreamBuf()
+{
+    deflateEnd(&stream_);
+}
+
+//------------------------------------------------------------------------------
+
+// Compresses the buffered data, and with Z_FINISH, writes the end of the
+// stream.
+
+void GzipStreamBuf::deflateToOutput(const int flush)
+{
+    stream_.next_in  = reinterpret_cast<Bytef*>(pbase());
+    stream_.avail_in = static_cast<uInt>(pptr() - pbase());
+
+    do {
+        stream_.next_out  = reinterpret_cast<Bytef*>(&output_buffer_[0]);
+        stream_.avail_out = static_cast<uInt>(output_buffer_.size());
+
+        const int result = deflate(&stream_, flush);
+
+        assert(result != Z_STREAM_ERROR);
+
+        const size_t length = output_buffer_.size() - stream_.avail_out;
+
+        if (length > 0) {
+            output_.write(&output_buffer_[0], static_cast<std::streamsize>(length));
+        }
+    }
+    while (stream_.avail_out == 0);
+
+    setp(&input_[0], &input_[0] + input_.size());
+}
+
+//------------------------------------------------------------------------------
+
+GzipStreamBuf::int_type GzipStreamBuf::overflow(const int_type c)
+{
+    if (finished_) {
+        return traits_type::eof();
+    }
+
+    deflateToOutput(Z_NO_FLUSH);
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+//------------------------------------------------------------------------------
+
+// Compresses any buffered data. The compressed data is only complete once
+// finish() is called.
+
+int GzipStreamBuf::sync()
+{
+    if (!finished_) {
+        deflateToOutput(Z_NO_FLUSH);
+    }
+
+    return output_.good() ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+
+void GzipStreamBuf::finish()
+{
+    if (!finished_) {
+        deflateToOutput(Z_FINISH);
+        finished_ = true;
+    }
+}
+
+//------------------------------------------------------------------------------
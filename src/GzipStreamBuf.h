@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_GZIP_STREAM_BUF_H)
+#define INC_GZIP_STREAM_BUF_H
+
+//------------------------------------------------------------------------------
+
+#include <zlib.h>
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+// A stream buffer that compresses everything written to it in gzip format, and
+// writes the compressed data to another stream as it goes, so that text output
+// can be compressed without first writing it uncompressed. Call finish() after
+// writing everything, to write the end of the gzip stream.
+
+class GzipStreamBuf : public std::streambuf
+{
+    public:
+        GzipStreamBuf(std::ostream& output, int compression_level);
+        ~GzipStreamBuf();
+
+        GzipStreamBuf(const GzipStreamBuf&) = delete;
+        GzipStreamBuf& operator=(const GzipStreamBuf&) = delete;
+
+    public:
+        void finish();
+
+    protected:
+        virtual int_type overflow(int_type c);
+        virtual int sync();
+
+    private:
+        void deflateToOutput(int flush);
+
+    private:
+        std::ostream& output_;
+
+        z_stream stream_;
+
+        std::vector<char> input_;
+        std::vector<char> output_buffer_;
+
+        bool finished_;
+};
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_GZIP_STREAM_BUF_H)
+
+//------------------------------------------------------------------------------
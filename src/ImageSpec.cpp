@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "ImageSpec.h"
+
+#include <boost/regex.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------
+
+ImageSpec::ImageSpec() :
+    width(0),
+    height(0),
+    samples_per_pixel(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+ImageSpec::ImageSpec(
+    int w,
+    int h,
+    int spp,
+    const std::string& name) :
+    width(w),
+    height(h),
+    samples_per_pixel(spp),
+    filename(name)
+{
+}
+
+//------------------------------------------------------------------------------
+
+std::istream& operator>>(std::istream& stream, ImageSpec& image_spec)
+{
+    std::string value;
+    stream >> value;
+
+    static const boost::regex regex("^([0-9]{1,6})x([0-9]{1,6})x([0-9]{1,8}):(.+)$");
+
+    boost::smatch match;
+
+    if (boost::regex_match(value, match, regex)) {
+        image_spec.width             = atoi(match[1].str().c_str());
+        image_spec.height            = atoi(match[2].str().c_str());
+        image_spec.samples_per_pixel = atoi(match[3].str().c_str());
+        image_spec.filename          = match[4].str();
+    }
+    else {
+        throw std::runtime_error("Invalid image: must be <width>x<height>x<zoom>:<filename>");
+    }
+
+    return stream;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_IMAGE_SPEC_H)
+#define INC_IMAGE_SPEC_H
+
+//------------------------------------------------------------------------------
+
+#include <iosfwd>
+#include <string>
+
+//------------------------------------------------------------------------------
+
+// Describes one of several images to be rendered from the same waveform data,
+// given on the command line as <width>x<height>x<zoom>:<filename>, for example:
+// 800x150x1024:card.png
+
+class ImageSpec
+{
+    public:
+        ImageSpec();
+        ImageSpec(int width, int height, int samples_per_pixel, const std::string& filename);
+
+    public:
+        int width;
+        int height;
+        int samples_per_pixel;
+        std::string filename;
+};
+
+//------------------------------------------------------------------------------
+
+std::istream& operator>>(std::istream& stream, ImageSpec& image_spec);
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_IMAGE_SPEC_H)
+
+//------------------------------------------------------------------------------
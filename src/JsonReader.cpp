@@ -0,0 +1,312 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "JsonReader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+
+const size_t BUFFER_SIZE = 64 * 1024;
+
+// Number of bytes examined at once when scanning the digits of a number. The
+// buffer has this many zero bytes (plus one for a sign) after the data read,
+// so that a number at the end of the data can be scanned without bounds
+// checks.
+const size_t SCAN_SIZE = 16;
+const size_t PADDING = SCAN_SIZE + 1;
+
+//------------------------------------------------------------------------------
+
+static void throwError(const char* message)
+{
+    throw std::runtime_error(std::string("Invalid JSON: ") + message);
+}
+
+//------------------------------------------------------------------------------
+
+JsonReader::JsonReader(std::istream& stream) :
+    stream_(stream),
+    buffer_(BUFFER_SIZE + PADDING),
+    pos_(0),
+    end_(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+// Reads more input if fewer than count bytes are buffered, and returns the
+// number of bytes buffered, which is less than count only at the end of the
+// input.
+
+size_t JsonReader::fill(const size_t count)
+{
+    if (end_ - pos_ < count) {
+        memmove(&buffer_[0], &buffer_[pos_], end_ - pos_);
+        end_ -= pos_;
+        pos_ = 0;
+
+        while (end_ < count && stream_.good()) {
+            stream_.read(&buffer_[end_], static_cast<std::streamsize>(BUFFER_SIZE - end_));
+            end_ += static_cast<size_t>(stream_.gcount());
+        }
+
+        memset(&buffer_[end_], 0, PADDING);
+
+        if (stream_.bad()) {
+            throw std::runtime_error(strerror(errno));
+        }
+    }
+
+    return end_ - pos_;
+}
+
+//------------------------------------------------------------------------------
+
+char JsonReader::get()
+{
+    if (fill(1) == 0) {
+        throwError("unexpected end of file");
+    }
+
+    return buffer_[pos_++];
+}
+
+//------------------------------------------------------------------------------
+
+void JsonReader::skipWhitespace()
+{
+    while (fill(1) > 0) {
+        const char c = buffer_[pos_];
+
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+
+        pos_++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool JsonReader::consume(const char c)
+{
+    skipWhitespace();
+
+    if (pos_ < end_ && buffer_[pos_] == c) {
+        pos_++;
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+
+void JsonReader::expect(const char c)
+{
+    if (!consume(c)) {
+        const char message[] = { 'e', 'x', 'p', 'e', 'c', 't', 'e', 'd', ' ', c, '\0' };
+        throwError(message);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool JsonReader::atEnd()
+{
+    skipWhitespace();
+
+    return pos_ == end_;
+}
+
+//------------------------------------------------------------------------------
+
+// Escape sequences are kept as they are, except for escaped quotes and
+// backslashes, as only the waveform data field names need to be compared.
+
+std::string JsonReader::readString()
+{
+    expect('"');
+
+    std::string value;
+
+    for (;;) {
+        char c = get();
+
+        if (c == '"') {
+            break;
+        }
+        else if (c == '\\') {
+            c = get();
+
+            if (c != '"' && c != '\\') {
+                value += '\\';
+            }
+        }
+
+        value += c;
+    }
+
+    return value;
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the number of decimal digits at the start of data, which has at
+// least SCAN_SIZE bytes. With SSE2, all the bytes are compared at once, and
+// the first non-digit is found from the comparison mask.
+
+static size_t countDigits(const char* data)
+{
+#if defined(__SSE2__) && defined(__GNUC__)
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+    // Digits become 0 to 9, other bytes 10 to 255 (unsigned)
+    const __m128i values = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+
+    const __m128i digits = _mm_cmpeq_epi8(
+        _mm_min_epu8(values, _mm_set1_epi8(9)),
+        values
+    );
+
+    const unsigned int mask = ~static_cast<unsigned int>(_mm_movemask_epi8(digits));
+
+    // Bit 16 is always set, so the count is at most SCAN_SIZE
+    return static_cast<size_t>(__builtin_ctz(mask));
+#else
+    size_t count = 0;
+
+    while (count < SCAN_SIZE && data[count] >= '0' && data[count] <= '9') {
+        count++;
+    }
+
+    return count;
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+long long JsonReader::readInteger()
+{
+    skipWhitespace();
+    fill(PADDING);
+
+    const char* p = &buffer_[pos_];
+
+    const bool negative = *p == '-';
+
+    if (negative) {
+        p++;
+    }
+
+    const size_t digits = countDigits(p);
+
+    if (digits == 0) {
+        throwError("expected number");
+    }
+    else if (digits == SCAN_SIZE) {
+        throwError("number out of range");
+    }
+
+    long long value = 0;
+
+    for (size_t i = 0; i < digits; ++i) {
+        value = value * 10 + (p[i] - '0');
+    }
+
+    p += digits;
+
+    if (*p == '.' || *p == 'e' || *p == 'E') {
+        throwError("expected integer");
+    }
+
+    pos_ = static_cast<size_t>(p - &buffer_[0]);
+
+    return negative ? -value : value;
+}
+
+//------------------------------------------------------------------------------
+
+void JsonReader::skipValue()
+{
+    skipWhitespace();
+
+    if (fill(1) == 0) {
+        throwError("unexpected end of file");
+    }
+
+    const char c = buffer_[pos_];
+
+    if (c == '"') {
+        readString();
+    }
+    else if (c == '{' || c == '[') {
+        const char close = c == '{' ? '}' : ']';
+
+        pos_++;
+
+        if (!consume(close)) {
+            do {
+                if (c == '{') {
+                    readString();
+                    expect(':');
+                }
+
+                skipValue();
+            }
+            while (consume(','));
+
+            expect(close);
+        }
+    }
+    else {
+        // Number, true, false, or null
+        size_t count = 0;
+
+        while (fill(1) > 0) {
+            const char value_char = buffer_[pos_];
+
+            if (value_char == ',' || value_char == '}' || value_char == ']' ||
+                value_char == ' ' || value_char == '\t' ||
+                value_char == '\n' || value_char == '\r') {
+                break;
+            }
+
+            pos_++;
+            count++;
+        }
+
+        if (count == 0) {
+            throwError("expected value");
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
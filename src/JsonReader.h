@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_JSON_READER_H)
+#define INC_JSON_READER_H
+
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+// Reads JSON values from a stream a token at a time, through a fixed size
+// buffer, so that large arrays of numbers can be read without holding the
+// whole file or building a document tree in memory. Reading a token that
+// doesn't match the expected type throws std::runtime_error.
+
+class JsonReader
+{
+    public:
+        explicit JsonReader(std::istream& stream);
+
+        JsonReader(const JsonReader&) = delete;
+        JsonReader& operator=(const JsonReader&) = delete;
+
+    public:
+        // Skips whitespace, then consumes the next character if it is c.
+        bool consume(char c);
+
+        // Skips whitespace, then consumes the next character, which must be c.
+        void expect(char c);
+
+        // Returns true if there is nothing but whitespace left in the input.
+        bool atEnd();
+
+        std::string readString();
+
+        // Reads an integer value. Fractions and exponents aren't supported.
+        long long readInteger();
+
+        // Skips over a value of any type.
+        void skipValue();
+
+    private:
+        void skipWhitespace();
+        size_t fill(size_t count);
+        char get();
+
+    private:
+        std::istream& stream_;
+
+        std::vector<char> buffer_;
+
+        // Range of buffer_ not yet read
+        size_t pos_;
+        size_t end_;
+};
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_JSON_READER_H)
+
+//------------------------------------------------------------------------------
@@ -37,13 +37,13 @@ namespace MathUtil {
 //      roundDownToNearest(141.0, 10) returns 140
 //      roundDownToNearest(-5.5, 3) returns -3
 
-int roundDownToNearest(double value, int multiple)
+long long roundDownToNearest(double value, int multiple)
 {
     if (multiple == 0) {
         return 0;
     }
 
-    return multiple * (static_cast<int>(value) / multiple);
+    return multiple * (static_cast<long long>(value) / multiple);
 }
 
 //------------------------------------------------------------------------------
@@ -53,20 +53,20 @@ int roundDownToNearest(double value, int multiple)
 //      roundUpToNearest(141.0, 10) returns 150
 //      roundUpToNearest(-5.5, 3) returns -6
 
-int roundUpToNearest(double value, int multiple)
+long long roundUpToNearest(double value, int multiple)
 {
     if (multiple == 0) {
         return 0;
     }
 
-    int multiplier = 1;
+    long long multiplier = 1;
 
     if (value < 0.0) {
         multiplier = -1;
         value = -value;
     }
 
-    const int rounded_up = static_cast<int>(ceil(value));
+    const long long rounded_up = static_cast<long long>(ceil(value));
 
     return multiplier * ((rounded_up + multiple - 1) / multiple) * multiple;
 }
@@ -27,8 +27,8 @@
 //------------------------------------------------------------------------------
 
 namespace MathUtil {
-    int roundDownToNearest(double value, int multiple);
-    int roundUpToNearest(double value, int multiple);
+    long long roundDownToNearest(double value, int multiple);
+    long long roundUpToNearest(double value, int multiple);
 }
 
 //------------------------------------------------------------------------------
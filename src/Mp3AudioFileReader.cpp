@@ -52,6 +52,7 @@
 
 #include "Mp3AudioFileReader.h"
 #include "AudioProcessor.h"
+#include "ErrorUtil.h"
 #include "Streams.h"
 #include "nullptr.h"
 
@@ -67,6 +68,7 @@ extern "C" {
 #include <cstring>
 #include <errno.h>
 #include <iostream>
+#include <vector>
 
 //------------------------------------------------------------------------------
 
@@ -168,10 +170,10 @@ static void dumpInfo(std::ostream& stream, const struct mad_header& header)
 
 //------------------------------------------------------------------------------
 
-// Converts a sample from libmad's fixed point number format to a signed short
-// (16 bits).
+// Converts a sample from libmad's fixed point number format to a signed 32-bit
+// integer.
 
-static short MadFixedToSshort(mad_fixed_t fixed)
+static int MadFixedToInt(mad_fixed_t fixed)
 {
     // A fixed point number is formed of the following bit pattern:
 
@@ -187,24 +189,51 @@ static short MadFixedToSshort(mad_fixed_t fixed)
     // not guaranteed to be constant over the different platforms supported by
     // libmad.
     //
-    // The signed short value is formed, after clipping, by the least
-    // significant whole part bit, followed by the 15 most significant
-    // fractional part bits. Warning: this is a quick and dirty way to compute
-    // the 16-bit number, madplay includes much better algorithms.
+    // The 32-bit value is formed, after clipping, by the least significant
+    // whole part bit, followed by the 31 most significant fractional part
+    // bits. Its upper 16 bits are the same as the 16-bit value formed from the
+    // 15 most significant fractional part bits, and clipping is to the 16-bit
+    // range, so processors that convert to 16-bit by discarding the lower 16
+    // bits get the same values as before. Warning: this is a quick and dirty
+    // way to compute the number, madplay includes much better algorithms.
 
     // Clipping
     if (fixed >= MAD_F_ONE) {
-        return SHRT_MAX;
+        return SHRT_MAX * 65536;
     }
 
     if (fixed <= -MAD_F_ONE) {
-        return -SHRT_MAX;
+        return -SHRT_MAX * 65536;
     }
 
     // Conversion
-    fixed >>= (MAD_F_FRACBITS - 15);
+    return static_cast<int>(fixed * (1 << (31 - MAD_F_FRACBITS)));
+}
+
+//------------------------------------------------------------------------------
+
+// Passes sample_count interleaved 32-bit samples to the processor. If the
+// processor doesn't accept 32-bit samples, short_buffer is not empty, and the
+// samples are first converted to 16-bit in short_buffer.
+
+static bool processSamples(
+    AudioProcessor& processor,
+    const int* samples,
+    const int sample_count,
+    const int channels,
+    std::vector<short>& short_buffer)
+{
+    const int frame_count = sample_count / channels;
 
-    return static_cast<short>(fixed);
+    if (short_buffer.empty()) {
+        return processor.process(samples, frame_count);
+    }
+
+    for (int i = 0; i < sample_count; ++i) {
+        short_buffer[static_cast<size_t>(i)] = static_cast<short>(samples[i] >> 16);
+    }
+
+    return processor.process(short_buffer.data(), frame_count);
 }
 
 //------------------------------------------------------------------------------
@@ -229,7 +258,9 @@ bool Mp3AudioFileReader::open(const char* filename)
     file_ = fopen(filename, "rb");
 
     if (file_ != nullptr) {
-        output_stream << "Input file: " << filename << std::endl;
+        if (isVerbose()) {
+            output_stream << "Input file: " << filename << std::endl;
+        }
 
         // Get the file size, so we can show a progress indicator.
 
@@ -238,8 +269,8 @@ bool Mp3AudioFileReader::open(const char* filename)
         int descriptor = fileno(file_);
 
         if (descriptor == -1 || fstat(descriptor, &stat_buf) != 0) {
-            error_stream << "Failed to determine file size: "
-                         << strerror(errno) << '\n';
+            getErrorStream() << "Failed to determine file size: "
+                             << ErrorUtil::errorToString(errno) << '\n';
 
             close();
 
@@ -249,8 +280,8 @@ bool Mp3AudioFileReader::open(const char* filename)
         file_size_ = stat_buf.st_size;
     }
     else {
-        error_stream << "Failed to read file: " << filename << '\n'
-                     << strerror(errno) << '\n';
+        getErrorStream() << "Failed to read file: " << filename << '\n'
+                         << ErrorUtil::errorToString(errno) << '\n';
     }
 
     return file_ != nullptr;
@@ -285,9 +316,15 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
     unsigned char* guard_ptr = nullptr;
     unsigned long frame_count = 0;
 
-    short output_buffer[OUTPUT_BUFFER_SIZE];
-    short* output_ptr = output_buffer;
-    const short* const output_buffer_end = output_buffer + OUTPUT_BUFFER_SIZE;
+    int output_buffer[OUTPUT_BUFFER_SIZE];
+    int* output_ptr = output_buffer;
+    const int* const output_buffer_end = output_buffer + OUTPUT_BUFFER_SIZE;
+
+    std::vector<short> short_buffer;
+
+    if (!processor.acceptsSampleFormat(SAMPLE_FORMAT_PCM_32)) {
+        short_buffer.resize(OUTPUT_BUFFER_SIZE);
+    }
 
     int channels = 0;
 
@@ -303,8 +340,8 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
 
     bstdfile_t* bstd_file = NewBstdFile(file_);
     if (bstd_file == nullptr) {
-        error_stream << "Can't create a new bstdfile_t: "
-                     << strerror(errno) << '\n';
+        getErrorStream() << "Can't create a new bstdfile_t: "
+                         << ErrorUtil::errorToString(errno) << '\n';
 
         status = STATUS_INIT_ERROR;
         goto exit;
@@ -369,8 +406,8 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
 
             if (read_size <= 0) {
                 if (ferror(file_)) {
-                    error_stream << "\nRead error on bit-stream: "
-                                 << strerror(errno) << '\n';
+                    getErrorStream() << "\nRead error on bit-stream: "
+                                     << ErrorUtil::errorToString(errno) << '\n';
                     status = STATUS_READ_ERROR;
                 }
 
@@ -449,8 +486,8 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
                     // This seems to be OK, so don't print these
 
                     if (frame_count != 0) {
-                        error_stream << "\nRecoverable frame level error: "
-                                     << mad_stream_errorstr(&stream) << '\n';
+                        getErrorStream() << "\nRecoverable frame level error: "
+                                         << mad_stream_errorstr(&stream) << '\n';
                     }
                 }
 
@@ -461,8 +498,8 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
                     continue;
                 }
                 else {
-                    error_stream << "\nUnrecoverable frame level error: "
-                                 << mad_stream_errorstr(&stream) << '\n';
+                    getErrorStream() << "\nUnrecoverable frame level error: "
+                                     << mad_stream_errorstr(&stream) << '\n';
                     status = STATUS_READ_ERROR;
                     break;
                 }
@@ -476,9 +513,23 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
             const int sample_rate = frame.header.samplerate;
             channels = MAD_NCHANNELS(&frame.header);
 
-            dumpInfo(output_stream, frame.header);
+            if (isVerbose()) {
+                dumpInfo(output_stream, frame.header);
+            }
+
+            AudioStreamInfo stream_info(sample_rate, channels);
+
+            // Estimate the length from the first frame's bitrate. This is
+            // only approximate for VBR files.
+
+            if (file_size_ > 0 && frame.header.bitrate > 0) {
+                stream_info.frame_count = static_cast<long long>(
+                    static_cast<double>(file_size_) * 8.0 * sample_rate /
+                    static_cast<double>(frame.header.bitrate)
+                );
+            }
 
-            if (!processor.init(sample_rate, channels, OUTPUT_BUFFER_SIZE)) {
+            if (!processor.init(stream_info, OUTPUT_BUFFER_SIZE)) {
                 status = STATUS_PROCESS_ERROR;
                 break;
             }
@@ -503,13 +554,13 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
         mad_synth_frame(&synth, &frame);
 
         // Synthesized samples must be converted from libmad's fixed point
-        // number to the consumer format. Here we use signed 16 bit integers on
+        // number to the consumer format. Here we use signed 32 bit integers on
         // two channels. Integer samples are temporarily stored in a buffer that
         // is flushed when full.
 
         for (int i = 0; i < synth.pcm.length; i++) {
             // Left channel
-            short sample = MadFixedToSshort(synth.pcm.samples[0][i]);
+            int sample = MadFixedToInt(synth.pcm.samples[0][i]);
 
             *output_ptr++ = sample;
 
@@ -517,7 +568,7 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
             // output channel is the same as the left one.
 
             if (MAD_NCHANNELS(&frame.header) == 2) {
-                sample = MadFixedToSshort(synth.pcm.samples[1][i]);
+                sample = MadFixedToInt(synth.pcm.samples[1][i]);
                 *output_ptr++ = sample;
             }
 
@@ -528,9 +579,12 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
 
                 showProgress(pos, file_size_);
 
-                bool success = processor.process(
+                bool success = processSamples(
+                    processor,
                     output_buffer,
-                    OUTPUT_BUFFER_SIZE / channels
+                    OUTPUT_BUFFER_SIZE,
+                    channels,
+                    short_buffer
                 );
 
                 if (!success) {
@@ -559,7 +613,13 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
     if (output_ptr != output_buffer && status != STATUS_PROCESS_ERROR) {
         int buffer_size = static_cast<int>(output_ptr - output_buffer);
 
-        bool success = processor.process(output_buffer, buffer_size / channels);
+        bool success = processSamples(
+            processor,
+            output_buffer,
+            buffer_size,
+            channels,
+            short_buffer
+        );
 
         if (!success) {
             status = STATUS_PROCESS_ERROR;
@@ -568,7 +628,7 @@ bool Mp3AudioFileReader::run(AudioProcessor& processor)
 
     // Accounting report if no error occurred.
 
-    if (status == STATUS_OK) {
+    if (status == STATUS_OK && isVerbose()) {
         // Report 100% done.
         showProgress(file_size_, file_size_);
 
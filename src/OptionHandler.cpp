@@ -28,19 +28,27 @@
 #include "GdImageRenderer.h"
 #include "Mp3AudioFileReader.h"
 #include "Options.h"
+#include "PngWriter.h"
+#include "SegmentedWaveformGenerator.h"
 #include "SndFileAudioFileReader.h"
 #include "Streams.h"
+#include "TileRenderer.h"
 #include "WaveformBuffer.h"
 #include "WaveformColors.h"
 #include "WaveformGenerator.h"
+#include "WaveformIndex.h"
 #include "WaveformRescaler.h"
 #include "WavFileWriter.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <fstream>
+#include <limits>
 #include <string>
+#include <vector>
 
 //------------------------------------------------------------------------------
 
@@ -70,6 +78,39 @@ static std::unique_ptr<AudioFileReader> createAudioFileReader(
 
 //------------------------------------------------------------------------------
 
+// A playlist lists audio files that are treated as one continuous stream.
+
+static bool isPlaylist(const boost::filesystem::path& filename)
+{
+    const boost::filesystem::path ext = filename.extension();
+
+    return ext == ".m3u" || ext == ".m3u8";
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the extension that decides the kind of output file. JSON and text
+// output files may have a further .gz extension, in which case they are gzip
+// compressed.
+
+static boost::filesystem::path getOutputFileExtension(
+    const boost::filesystem::path& filename)
+{
+    const boost::filesystem::path ext = filename.extension();
+
+    if (ext == ".gz") {
+        const boost::filesystem::path stem_ext = filename.stem().extension();
+
+        if (stem_ext == ".json" || stem_ext == ".txt") {
+            return stem_ext;
+        }
+    }
+
+    return ext;
+}
+
+//------------------------------------------------------------------------------
+
 static std::unique_ptr<ScaleFactor> createScaleFactor(const Options& options)
 {
     std::unique_ptr<ScaleFactor> scale_factor;
@@ -104,6 +145,234 @@ static std::unique_ptr<ScaleFactor> createScaleFactor(const Options& options)
 
 //------------------------------------------------------------------------------
 
+static PngWriter::Filter getPngFilter(const Options& options)
+{
+    if (!options.hasPngFilter()) {
+        return PngWriter::FILTER_DEFAULT;
+    }
+
+    const std::string& name = options.getPngFilter();
+
+    if (name == "none") {
+        return PngWriter::FILTER_NONE;
+    }
+    else if (name == "sub") {
+        return PngWriter::FILTER_SUB;
+    }
+    else if (name == "up") {
+        return PngWriter::FILTER_UP;
+    }
+    else if (name == "average") {
+        return PngWriter::FILTER_AVERAGE;
+    }
+    else if (name == "paeth") {
+        return PngWriter::FILTER_PAETH;
+    }
+    else if (name == "adaptive") {
+        return PngWriter::FILTER_ADAPTIVE;
+    }
+    else {
+        const std::string message = boost::str(
+            boost::format("Unknown PNG filter: %1%") % name
+        );
+
+        throw std::runtime_error(message);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+static WaveformColors createWaveformColors(const Options& options)
+{
+    const std::string& color_scheme = options.getColorScheme();
+
+    WaveformColors colors;
+
+    if (color_scheme == "audacity") {
+        colors = audacity_waveform_colors;
+    }
+    else if (color_scheme == "audition") {
+        colors = audition_waveform_colors;
+    }
+    else {
+        const std::string message = boost::str(
+            boost::format("Unknown color scheme: %1%") % color_scheme
+        );
+
+        throw std::runtime_error(message);
+    }
+
+    if (options.hasBorderColor()) {
+        colors.border_color = options.getBorderColor();
+    }
+
+    if (options.hasBackgroundColor()) {
+        colors.background_color = options.getBackgroundColor();
+    }
+
+    if (options.hasWaveformColor()) {
+        colors.waveform_color = options.getWaveformColor();
+    }
+
+    if (options.hasAxisLabelColor()) {
+        colors.axis_label_color = options.getAxisLabelColor();
+    }
+
+    if (options.hasRmsColor()) {
+        colors.rms_color = options.getRmsColor();
+    }
+
+    return colors;
+}
+
+//------------------------------------------------------------------------------
+
+// Returns true if the file holds waveform data, either binary (.dat) or JSON,
+// rather than audio.
+
+static bool isWaveformDataFile(const boost::filesystem::path& filename)
+{
+    const boost::filesystem::path ext = filename.extension();
+
+    return ext == ".dat" || ext == ".json";
+}
+
+//------------------------------------------------------------------------------
+
+static bool loadWaveformDataFile(
+    const boost::filesystem::path& filename,
+    WaveformBuffer& buffer)
+{
+    if (filename.extension() == ".json") {
+        return buffer.loadJson(filename.string().c_str());
+    }
+    else {
+        return buffer.load(filename.string().c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Loads waveform data from a .dat or .json file, or generates it from an audio
+// file at the given zoom level, with RMS values or split channels if requested.
+
+static bool loadWaveformData(
+    const boost::filesystem::path& input_filename,
+    const int samples_per_pixel,
+    const Options& options,
+    WaveformBuffer& buffer)
+{
+    if (isWaveformDataFile(input_filename)) {
+        return loadWaveformDataFile(input_filename, buffer);
+    }
+
+    std::unique_ptr<AudioFileReader> audio_file_reader(
+        createAudioFileReader(input_filename)
+    );
+
+    if (!audio_file_reader->open(input_filename.string().c_str())) {
+        return false;
+    }
+
+    SamplesPerPixelScaleFactor scale_factor(samples_per_pixel);
+
+    buffer.setRms(options.getRms());
+
+    WaveformGenerator processor(buffer, scale_factor);
+    processor.setSplitChannels(options.getSplitChannels());
+
+    return audio_file_reader->run(processor);
+}
+
+//------------------------------------------------------------------------------
+
+static std::string getIndexFilename(const boost::filesystem::path& data_filename)
+{
+    return data_filename.string() + ".idx";
+}
+
+//------------------------------------------------------------------------------
+
+// Loads the index saved next to the given .dat file, or builds and saves a new
+// index if there isn't one, or if it is older than the .dat file. If the index
+// can't be saved, e.g., as the .dat file is on a read-only file system, the
+// built index is still used.
+
+static void loadIndex(
+    const boost::filesystem::path& data_filename,
+    WaveformIndex& index)
+{
+    const boost::filesystem::path index_filename = getIndexFilename(data_filename);
+
+    boost::system::error_code error_code;
+
+    const bool is_current =
+        boost::filesystem::exists(index_filename, error_code) &&
+        boost::filesystem::last_write_time(index_filename, error_code) >=
+        boost::filesystem::last_write_time(data_filename, error_code);
+
+    if (is_current && !error_code && index.load(index_filename.string().c_str())) {
+        return;
+    }
+
+    index.build();
+
+    if (!index.save(index_filename.string().c_str())) {
+        error_stream << "Continuing without saving the index file\n";
+    }
+}
+
+//------------------------------------------------------------------------------
+
+static bool renderImage(
+    const WaveformBuffer& buffer,
+    const long long buffer_start_index,
+    const WaveformColors& colors,
+    const int image_width,
+    const int image_height,
+    const boost::filesystem::path& output_filename,
+    const PngWriter::Filter png_filter,
+    const Options& options)
+{
+    GdImageRenderer renderer;
+    renderer.setBufferStartIndex(buffer_start_index);
+
+    if (options.getPngStream()) {
+        return renderer.renderToPng(
+            buffer,
+            options.getStartTime(),
+            image_width,
+            image_height,
+            colors,
+            options.getRenderAxisLabels(),
+            output_filename.string().c_str(),
+            options.getPngCompressionLevel(),
+            png_filter
+        );
+    }
+
+    if (!renderer.create(
+        buffer,
+        options.getStartTime(),
+        image_width,
+        image_height,
+        colors,
+        options.getRenderAxisLabels(),
+        options.getPngPalette()))
+    {
+        return false;
+    }
+
+    return renderer.saveAsPng(
+        output_filename.string().c_str(),
+        options.getPngCompressionLevel(),
+        png_filter,
+        options.getPngThreads()
+    );
+}
+
+//------------------------------------------------------------------------------
+
 OptionHandler::OptionHandler()
 {
 }
@@ -127,6 +396,236 @@ bool OptionHandler::convertAudioFormat(
 
 //------------------------------------------------------------------------------
 
+static std::string getSourceFilename(const boost::filesystem::path& data_filename)
+{
+    return data_filename.string() + ".src";
+}
+
+//------------------------------------------------------------------------------
+
+// Saves the name of the audio file that a .dat file was generated from, so
+// that images at finer zoom levels than the .dat file can be rendered from
+// the audio.
+
+static bool saveSourceFilename(
+    const boost::filesystem::path& data_filename,
+    const boost::filesystem::path& audio_filename)
+{
+    const std::string source_filename = getSourceFilename(data_filename);
+
+    std::ofstream stream(source_filename.c_str());
+
+    stream << boost::filesystem::absolute(audio_filename).string() << '\n';
+
+    if (!stream) {
+        error_stream << "Failed to write source file: " << source_filename << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+static bool loadSourceFilename(
+    const boost::filesystem::path& data_filename,
+    boost::filesystem::path& audio_filename)
+{
+    std::ifstream stream(getSourceFilename(data_filename).c_str());
+
+    std::string line;
+
+    if (!std::getline(stream, line) || line.empty()) {
+        return false;
+    }
+
+    audio_filename = line;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Where generating a .dat file stopped, saved next to it so that a later run
+// with --resume can continue from the next input frame, and so that merging
+// .dat files knows how many input frames each one covers.
+
+struct ResumeState
+{
+    long long length;      // Number of points in the .dat file
+    long long frame_count; // Number of input frames read
+    int min;               // Min and max of the last point, if incomplete
+    int max;
+    int count;             // Input samples in the last point, or 0 if complete
+};
+
+//------------------------------------------------------------------------------
+
+static std::string getResumeFilename(const boost::filesystem::path& data_filename)
+{
+    return data_filename.string() + ".resume";
+}
+
+//------------------------------------------------------------------------------
+
+static bool saveResumeState(
+    const boost::filesystem::path& data_filename,
+    const ResumeState& state)
+{
+    const std::string resume_filename = getResumeFilename(data_filename);
+
+    std::ofstream stream(resume_filename.c_str());
+
+    stream << state.length << ' '
+           << state.frame_count << ' '
+           << state.min << ' '
+           << state.max << ' '
+           << state.count << '\n';
+
+    if (!stream) {
+        error_stream << "Failed to write resume file: " << resume_filename << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Returns false if there is no resume file, so the data file is generated from
+// the start.
+
+static bool loadResumeState(
+    const boost::filesystem::path& data_filename,
+    ResumeState& state)
+{
+    std::ifstream stream(getResumeFilename(data_filename).c_str());
+
+    stream >> state.length
+           >> state.frame_count
+           >> state.min
+           >> state.max
+           >> state.count;
+
+    return !stream.fail() &&
+        state.length >= 0 && state.frame_count >= 0 && state.count >= 0;
+}
+
+//------------------------------------------------------------------------------
+
+// Saves the resume state of a .dat file if --resume is used, or if its last
+// point is incomplete, so that merging the .dat file with others uses the
+// number of input frames it covers. Otherwise removes any earlier resume file,
+// so that a later run doesn't resume from an earlier data file.
+
+static bool updateResumeState(
+    const boost::filesystem::path& data_filename,
+    const ResumeState& state,
+    const bool resume)
+{
+    if (resume || state.count > 0) {
+        return saveResumeState(data_filename, state);
+    }
+
+    boost::system::error_code error_code;
+    boost::filesystem::remove(getResumeFilename(data_filename), error_code);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Generates the waveform data shown in an image directly from an audio file,
+// reading only the audio from the image start time, and sets start_index to
+// the index of the first point relative to the start of the audio. The data
+// has the same bits, RMS values, and channels as input_buffer, the waveform
+// data previously generated from the audio file.
+
+static bool generateWaveformDataRange(
+    const boost::filesystem::path& audio_filename,
+    const WaveformBuffer& input_buffer,
+    const int samples_per_pixel,
+    const Options& options,
+    WaveformBuffer& buffer,
+    long long& start_index)
+{
+    std::unique_ptr<AudioFileReader> audio_file_reader(
+        createAudioFileReader(audio_filename)
+    );
+
+    if (!audio_file_reader->open(audio_filename.string().c_str())) {
+        return false;
+    }
+
+    const int sample_rate = input_buffer.getSampleRate();
+
+    // Computed the same way as in GdImageRenderer, and limited so an invalid
+    // start time is still reported by the renderer
+    const double start = options.getStartTime() * sample_rate / samples_per_pixel;
+
+    start_index = 0;
+
+    if (start > 0.0) {
+        start_index = static_cast<long long>(std::min(
+            start,
+            static_cast<double>(std::numeric_limits<long long>::max() / samples_per_pixel)
+        ));
+    }
+
+    SamplesPerPixelScaleFactor scale_factor(samples_per_pixel);
+
+    buffer.setBits(input_buffer.getBits());
+    buffer.setRms(input_buffer.hasRms());
+
+    WaveformGenerator processor(buffer, scale_factor);
+    processor.setSplitChannels(input_buffer.getChannels() > 1);
+
+    if (!audio_file_reader->runRange(
+        processor,
+        start_index * samples_per_pixel,
+        static_cast<long long>(options.getImageWidth()) * samples_per_pixel))
+    {
+        return false;
+    }
+
+    if (buffer.getSampleRate() != sample_rate) {
+        error_stream << "Audio file sample rate does not match waveform data: "
+                     << audio_filename << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Generates waveform data from a playlist's audio files, as if they were one
+// continuous stream.
+
+static bool generateWaveformDataFromPlaylist(
+    const std::vector<boost::filesystem::path>& filenames,
+    const ScaleFactor& scale_factor,
+    const Options& options,
+    WaveformBuffer& buffer,
+    long long& frame_count)
+{
+    SegmentedWaveformGenerator generator(createAudioFileReader, scale_factor, 0);
+
+    if (options.hasSegmentCache()) {
+        generator.setCacheDirectory(options.getSegmentCache());
+    }
+
+    if (!generator.generate(filenames, buffer)) {
+        return false;
+    }
+
+    frame_count = generator.getFrameCount();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
 bool OptionHandler::generateWaveformData(
     const boost::filesystem::path& input_filename,
     const boost::filesystem::path& output_filename,
@@ -134,37 +633,412 @@ bool OptionHandler::generateWaveformData(
 {
     const std::unique_ptr<ScaleFactor> scale_factor = createScaleFactor(options);
 
-    const boost::filesystem::path output_file_ext = output_filename.extension();
+    const boost::filesystem::path output_file_ext = getOutputFileExtension(output_filename);
+
+    assert(
+        output_file_ext == ".dat" ||
+        output_file_ext == ".json" ||
+        output_file_ext == ".msgpack" ||
+        output_file_ext == ".cbor"
+    );
+
+    const int bits = options.getBits();
+
+    WaveformBuffer buffer;
+
+    // Store the data at the output resolution, to halve memory use for 8-bit
+    // output
+    buffer.setBits(bits);
+    buffer.setRms(options.getRms());
+
+    WaveformGenerator processor(buffer, *scale_factor);
+    processor.setSplitChannels(options.getSplitChannels());
 
-    const std::unique_ptr<AudioFileReader> audio_file_reader =
-        createAudioFileReader(input_filename);
+    const bool playlist = isPlaylist(input_filename);
 
-    if (audio_file_reader == nullptr) {
-        error_stream << "Unknown file type: " << input_filename << '\n';
+    if (playlist && (options.getResume() || options.getLinkAudio())) {
+        error_stream << "Can't use --resume or --link-audio with a playlist input file\n";
         return false;
     }
 
-    if (!audio_file_reader->open(input_filename.string().c_str())) {
+    if (options.getCompress() && options.getResume()) {
+        // Compressed data files can't be appended to
+        error_stream << "Can't use --compress with --resume\n";
         return false;
     }
 
-    WaveformBuffer buffer;
-    WaveformGenerator processor(buffer, *scale_factor);
+    if (options.getRms() && (playlist || options.getResume())) {
+        // The RMS of a partial point can't be continued
+        error_stream << "Can't use --rms with --resume or a playlist input file\n";
+        return false;
+    }
 
-    if (!audio_file_reader->run(processor)) {
+    if (options.getSplitChannels() &&
+        (playlist || options.getResume() || options.getRms() || options.getIndex())) {
+        // Resume files, merged data files, and indexes hold a single channel
+        error_stream << "Can't use --split-channels with --resume, --rms, --index, or a playlist input file\n";
         return false;
     }
 
-    assert(output_file_ext == ".dat" || output_file_ext == ".json");
+    std::vector<boost::filesystem::path> segment_filenames;
 
-    const int bits = options.getBits();
+    if (playlist) {
+        if (!SegmentedWaveformGenerator::readPlaylist(input_filename, segment_filenames)) {
+            return false;
+        }
+
+        const auto data_file_count = std::count_if(
+            segment_filenames.begin(),
+            segment_filenames.end(),
+            [](const boost::filesystem::path& filename) {
+                return filename.extension() == ".dat";
+            }
+        );
+
+        if (data_file_count > 0) {
+            if (static_cast<size_t>(data_file_count) != segment_filenames.size()) {
+                error_stream << "Can't mix audio and waveform data files in a playlist\n";
+                return false;
+            }
+
+            if (output_file_ext != ".dat") {
+                error_stream << "Can only merge waveform data files to a .dat file\n";
+                return false;
+            }
+
+            if (options.getCompress()) {
+                error_stream << "Can't use --compress when merging waveform data files\n";
+                return false;
+            }
+
+            return mergeWaveformData(segment_filenames, output_filename, options);
+        }
+    }
+
+    ResumeState resume_state;
+
+    const bool resume =
+        output_file_ext == ".dat" &&
+        options.getResume() &&
+        loadResumeState(output_filename, resume_state);
+
+    // Number of input frames in the playlist's audio files
+    long long playlist_frame_count = 0;
+
+    if (playlist) {
+        if (!generateWaveformDataFromPlaylist(
+            segment_filenames,
+            *scale_factor,
+            options,
+            buffer,
+            playlist_frame_count))
+        {
+            return false;
+        }
+    }
+    else {
+        const std::unique_ptr<AudioFileReader> audio_file_reader =
+            createAudioFileReader(input_filename);
+
+        if (audio_file_reader == nullptr) {
+            error_stream << "Unknown file type: " << input_filename << '\n';
+            return false;
+        }
+
+        if (!audio_file_reader->open(input_filename.string().c_str())) {
+            return false;
+        }
+
+        if (resume) {
+            // Continue the last point in the .dat file, and read only the
+            // audio after the last frame used
+            processor.setPartialPoint(
+                resume_state.min,
+                resume_state.max,
+                resume_state.count
+            );
+
+            if (!audio_file_reader->runRange(
+                processor,
+                resume_state.frame_count,
+                std::numeric_limits<long long>::max() - resume_state.frame_count))
+            {
+                return false;
+            }
+        }
+        else if (!audio_file_reader->run(processor)) {
+            return false;
+        }
+    }
 
     if (output_file_ext == ".dat") {
-        return buffer.save(output_filename.string().c_str(), bits);
+        const int samples_per_pixel = buffer.getSamplesPerPixel();
+
+        // Index in the .dat file of the first point in the buffer
+        long long start_index = 0;
+
+        if (resume) {
+            // An incomplete last point is replaced by the first new point
+            start_index = resume_state.count > 0 ?
+                resume_state.length - 1 : resume_state.length;
+
+            if (resume_state.frame_count !=
+                start_index * samples_per_pixel + resume_state.count) {
+                error_stream << "Resume file does not match waveform data: "
+                             << getResumeFilename(output_filename) << '\n';
+                return false;
+            }
+
+            if (!buffer.appendToFile(output_filename.string().c_str(), start_index)) {
+                return false;
+            }
+        }
+        else if (!buffer.save(output_filename.string().c_str(), bits, options.getCompress())) {
+            return false;
+        }
+
+        ResumeState state;
+
+        if (playlist) {
+            const long long size = buffer.getSize();
+
+            state.count = size > 0 ?
+                static_cast<int>(playlist_frame_count % samples_per_pixel) : 0;
+            state.min   = size > 0 ? buffer.getMinSample(size - 1) : 0;
+            state.max   = size > 0 ? buffer.getMaxSample(size - 1) : 0;
+        }
+        else {
+            processor.getPartialPoint(state.min, state.max, state.count);
+        }
+
+        state.length = start_index + buffer.getSize();
+        state.frame_count =
+            (state.count > 0 ? state.length - 1 : state.length) * samples_per_pixel +
+            state.count;
+
+        if (!updateResumeState(output_filename, state, options.getResume())) {
+            return false;
+        }
+
+        if (options.getLinkAudio() &&
+            !saveSourceFilename(output_filename, input_filename)) {
+            return false;
+        }
+
+        if (options.getIndex()) {
+            // The index covers the whole file, not just the points appended
+            WaveformBuffer data_buffer;
+
+            if (resume && !data_buffer.load(output_filename.string().c_str())) {
+                return false;
+            }
+
+            WaveformIndex index(resume ? data_buffer : buffer);
+            index.build();
+
+            return index.save(getIndexFilename(output_filename).c_str());
+        }
+
+        return true;
+    }
+    else if (output_file_ext == ".msgpack") {
+        return buffer.saveAsMsgPack(output_filename.string().c_str(), bits);
+    }
+    else if (output_file_ext == ".cbor") {
+        return buffer.saveAsCbor(output_filename.string().c_str(), bits);
     }
     else {
-        return buffer.saveAsJson(output_filename.string().c_str(), bits);
+        return buffer.saveAsJson(
+            output_filename.string().c_str(),
+            bits,
+            options.getGzipCompressionLevel()
+        );
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the number of audio frames that a .dat file was generated from, as
+// saved in its resume file. Without a resume file, the last point is complete.
+
+static long long getDataFileFrameCount(
+    const boost::filesystem::path& data_filename,
+    const WaveformBuffer& buffer)
+{
+    const long long size = buffer.getSize();
+    const long long samples_per_pixel = buffer.getSamplesPerPixel();
+
+    ResumeState state;
+
+    if (loadResumeState(data_filename, state) &&
+        state.length == size &&
+        state.frame_count > (size - 1) * samples_per_pixel &&
+        state.frame_count <= size * samples_per_pixel) {
+        return state.frame_count;
+    }
+
+    return size * samples_per_pixel;
+}
+
+//------------------------------------------------------------------------------
+
+// Concatenates .dat files generated from consecutive audio files, without
+// decoding the audio. Each output point covers the same audio frames as if
+// the waveform data had been generated from the whole audio in one go, and
+// has the min and max values of the input points that overlap it. Where an
+// input file ends part way through a point, the points of the files after it
+// don't line up with the output points, so each output point combines two
+// input points. Only one input file is held in memory at a time, and its
+// points are appended to the output file.
+
+bool OptionHandler::mergeWaveformData(
+    const std::vector<boost::filesystem::path>& input_filenames,
+    const boost::filesystem::path& output_filename,
+    const Options& options)
+{
+    int sample_rate = 0;
+    int samples_per_pixel = 0;
+    int bits = 16;
+
+    // Number of points written to the output file, and the number of audio
+    // frames they cover
+    long long length = 0;
+    long long frame_count = 0;
+
+    // Last point written, which the next file may continue
+    short last_min = 0;
+    short last_max = 0;
+
+    bool created = false;
+
+    for (const auto& input_filename : input_filenames) {
+        WaveformBuffer input_buffer;
+
+        if (!input_buffer.load(input_filename.string().c_str())) {
+            return false;
+        }
+
+        if (input_buffer.getChannels() > 1) {
+            error_stream << "Can't merge multi-channel waveform data files: "
+                         << input_filename.string() << '\n';
+            return false;
+        }
+
+        if (input_buffer.hasRms()) {
+            // The RMS values of points that span two files can't be combined,
+            // as the sums of squares aren't stored
+            error_stream << "Can't merge waveform data files with RMS values: "
+                         << input_filename.string() << '\n';
+            return false;
+        }
+
+        if (sample_rate == 0) {
+            sample_rate       = input_buffer.getSampleRate();
+            samples_per_pixel = input_buffer.getSamplesPerPixel();
+            bits              = options.hasBits() ? options.getBits() : input_buffer.getBits();
+        }
+        else if (input_buffer.getSampleRate() != sample_rate ||
+                 input_buffer.getSamplesPerPixel() != samples_per_pixel) {
+            error_stream << "Sample rate or zoom level does not match previous files: "
+                         << input_filename.string() << '\n';
+            return false;
+        }
+
+        const long long start = frame_count;
+        const long long end   = start + getDataFileFrameCount(input_filename, input_buffer);
+
+        WaveformBuffer buffer;
+        buffer.setSampleRate(sample_rate);
+        buffer.setSamplesPerPixel(samples_per_pixel);
+        buffer.setBits(bits);
+
+        // Output points from first_index that cover this file's audio
+        const long long first_index = start / samples_per_pixel;
+        const long long end_index   = (end + samples_per_pixel - 1) / samples_per_pixel;
+
+        if (end > start) {
+            buffer.reserve(end_index - first_index);
+        }
+
+        for (long long index = first_index; end > start && index < end_index; ++index) {
+            // Range of frames covered by the output point, relative to the
+            // start of the input file
+            const long long point_start =
+                std::max(index * samples_per_pixel, start) - start;
+
+            const long long point_end =
+                std::min((index + 1) * samples_per_pixel, end) - start;
+
+            long long input_index = point_start / samples_per_pixel;
+            const long long last_input_index = (point_end - 1) / samples_per_pixel;
+
+            short min = input_buffer.getMinSample(input_index);
+            short max = input_buffer.getMaxSample(input_index);
+
+            while (++input_index <= last_input_index) {
+                min = std::min(min, input_buffer.getMinSample(input_index));
+                max = std::max(max, input_buffer.getMaxSample(input_index));
+            }
+
+            buffer.appendSamples(min, max);
+        }
+
+        if (first_index < length && buffer.getSize() > 0) {
+            // The first point continues the last point written
+            buffer.setSamples(
+                0,
+                std::min(buffer.getMinSample(0), last_min),
+                std::max(buffer.getMaxSample(0), last_max)
+            );
+        }
+
+        if (!created) {
+            if (!buffer.save(output_filename.string().c_str(), bits)) {
+                return false;
+            }
+
+            created = true;
+        }
+        else if (buffer.getSize() > 0 &&
+                 !buffer.appendToFile(output_filename.string().c_str(), first_index)) {
+            return false;
+        }
+
+        if (buffer.getSize() > 0) {
+            last_min = buffer.getMinSample(buffer.getSize() - 1);
+            last_max = buffer.getMaxSample(buffer.getSize() - 1);
+        }
+
+        length      = std::max(length, end_index);
+        frame_count = end;
+    }
+
+    // Save the number of frames, in case the output file is merged again
+    ResumeState state;
+    state.length      = length;
+    state.frame_count = frame_count;
+    state.min         = last_min;
+    state.max         = last_max;
+    state.count       = static_cast<int>(frame_count % samples_per_pixel);
+
+    if (!updateResumeState(output_filename, state, false)) {
+        return false;
+    }
+
+    if (options.getIndex()) {
+        WaveformBuffer buffer;
+
+        if (!buffer.load(output_filename.string().c_str())) {
+            return false;
+        }
+
+        WaveformIndex index(buffer);
+        index.build();
+
+        return index.save(getIndexFilename(output_filename).c_str());
     }
+
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -176,7 +1050,7 @@ bool OptionHandler::convertWaveformData(
 {
     WaveformBuffer buffer;
 
-    if (!buffer.load(input_filename.string().c_str())) {
+    if (!loadWaveformDataFile(input_filename, buffer)) {
         return false;
     }
 
@@ -184,13 +1058,34 @@ bool OptionHandler::convertWaveformData(
 
     bool success = true;
 
-    const boost::filesystem::path output_file_ext = output_filename.extension();
+    const boost::filesystem::path output_file_ext = getOutputFileExtension(output_filename);
 
-    if (output_file_ext == ".json") {
-        success = buffer.saveAsJson(output_filename.string().c_str(), bits);
+    if (output_file_ext == ".dat") {
+        success = buffer.save(
+            output_filename.string().c_str(),
+            bits,
+            options.getCompress()
+        );
+    }
+    else if (output_file_ext == ".json") {
+        success = buffer.saveAsJson(
+            output_filename.string().c_str(),
+            bits,
+            options.getGzipCompressionLevel()
+        );
     }
     else if (output_file_ext == ".txt") {
-        success = buffer.saveAsText(output_filename.string().c_str(), bits);
+        success = buffer.saveAsText(
+            output_filename.string().c_str(),
+            bits,
+            options.getGzipCompressionLevel()
+        );
+    }
+    else if (output_file_ext == ".msgpack") {
+        success = buffer.saveAsMsgPack(output_filename.string().c_str(), bits);
+    }
+    else if (output_file_ext == ".cbor") {
+        success = buffer.saveAsCbor(output_filename.string().c_str(), bits);
     }
 
     return success;
@@ -205,14 +1100,16 @@ bool OptionHandler::renderWaveformImage(
 {
     const std::unique_ptr<ScaleFactor> scale_factor = createScaleFactor(options);
 
+    const PngWriter::Filter png_filter = getPngFilter(options);
+
     int output_samples_per_pixel = 0;
 
     WaveformBuffer input_buffer;
 
     const boost::filesystem::path input_file_ext = input_filename.extension();
 
-    if (input_file_ext == ".dat") {
-        if (!input_buffer.load(input_filename.string().c_str())) {
+    if (isWaveformDataFile(input_filename)) {
+        if (!loadWaveformDataFile(input_filename, input_buffer)) {
             return false;
         }
 
@@ -229,7 +1126,10 @@ bool OptionHandler::renderWaveformImage(
             return false;
         }
 
+        input_buffer.setRms(options.getRms());
+
         WaveformGenerator processor(input_buffer, *scale_factor);
+        processor.setSplitChannels(options.getSplitChannels());
 
         if (!audio_file_reader->run(processor)) {
             return false;
@@ -243,17 +1143,73 @@ bool OptionHandler::renderWaveformImage(
 
     const int input_samples_per_pixel = input_buffer.getSamplesPerPixel();
 
+    // Index of the first point in render_buffer, relative to the start of the
+    // waveform
+    long long buffer_start_index = 0;
+
+    boost::filesystem::path audio_filename;
+
     if (output_samples_per_pixel == input_samples_per_pixel) {
         // No need to rescale
         render_buffer = &input_buffer;
     }
     else if (output_samples_per_pixel > input_samples_per_pixel) {
+        // Rescale only the points shown in the image. The start index is
+        // computed the same way as in GdImageRenderer, and limited to the
+        // number of output points, so an invalid start time is still reported
+        // by the renderer.
+        const long long max_index =
+            input_buffer.getSize() * input_samples_per_pixel / output_samples_per_pixel + 1;
+
+        const double start_index =
+            options.getStartTime() * input_buffer.getSampleRate() / output_samples_per_pixel;
+
+        if (start_index > 0.0) {
+            buffer_start_index = static_cast<long long>(
+                std::min(start_index, static_cast<double>(max_index))
+            );
+        }
+
         WaveformRescaler rescaler;
 
-        if (!rescaler.rescale(
+        if (input_file_ext == ".dat" && options.getIndex()) {
+            WaveformIndex index(input_buffer);
+            loadIndex(input_filename, index);
+
+            if (!rescaler.rescale(
+                input_buffer,
+                index,
+                output_buffer,
+                output_samples_per_pixel,
+                buffer_start_index,
+                options.getImageWidth()))
+            {
+                return false;
+            }
+        }
+        else if (!rescaler.rescale(
+            input_buffer,
+            output_buffer,
+            output_samples_per_pixel,
+            buffer_start_index,
+            options.getImageWidth()))
+        {
+            return false;
+        }
+
+        render_buffer = &output_buffer;
+    }
+    else if (input_file_ext == ".dat" &&
+             loadSourceFilename(input_filename, audio_filename)) {
+        // Zoom is finer than the waveform data, so read the part of the audio
+        // shown in the image instead
+        if (!generateWaveformDataRange(
+            audio_filename,
             input_buffer,
+            output_samples_per_pixel,
+            options,
             output_buffer,
-            output_samples_per_pixel))
+            buffer_start_index))
         {
             return false;
         }
@@ -265,51 +1221,138 @@ bool OptionHandler::renderWaveformImage(
         return false;
     }
 
-    const std::string& color_scheme = options.getColorScheme();
+    const WaveformColors colors = createWaveformColors(options);
 
-    WaveformColors colors;
+    return renderImage(
+        *render_buffer,
+        buffer_start_index,
+        colors,
+        options.getImageWidth(),
+        options.getImageHeight(),
+        output_filename,
+        png_filter,
+        options
+    );
+}
 
-    if (color_scheme == "audacity") {
-        colors = audacity_waveform_colors;
-    }
-    else if (color_scheme == "audition") {
-        colors = audition_waveform_colors;
-    }
-    else {
-        error_stream << "Unknown color scheme: " << color_scheme << '\n';
+//------------------------------------------------------------------------------
+
+bool OptionHandler::renderWaveformTiles(
+    const boost::filesystem::path& input_filename,
+    const boost::filesystem::path& output_path,
+    const Options& options)
+{
+    const std::vector<int>& zoom_levels = options.getTileZoomLevels();
+
+    assert(!zoom_levels.empty());
+
+    const PngWriter::Filter png_filter = getPngFilter(options);
+
+    const WaveformColors colors = createWaveformColors(options);
+
+    WaveformBuffer buffer;
+
+    // Audio files are analysed at the most detailed zoom level, from which all
+    // the others can be rescaled
+    const int samples_per_pixel = *std::min_element(zoom_levels.begin(), zoom_levels.end());
+
+    if (!loadWaveformData(input_filename, samples_per_pixel, options, buffer)) {
         return false;
     }
 
-    GdImageRenderer renderer;
+    TileRenderer renderer(
+        options.getTileWidth(),
+        options.getImageHeight(),
+        colors,
+        options.getRenderAxisLabels(),
+        options.getPngPalette(),
+        options.getPngCompressionLevel(),
+        png_filter,
+        options.getPngThreads()
+    );
+
+    return renderer.render(buffer, zoom_levels, output_path);
+}
 
-    if (options.hasBorderColor()) {
-        colors.border_color = options.getBorderColor();
-    }
+//------------------------------------------------------------------------------
 
-    if (options.hasBackgroundColor()) {
-        colors.background_color = options.getBackgroundColor();
+// Renders several images, of different sizes and zoom levels, from the same
+// waveform data. The data is rescaled once for each distinct zoom level.
+
+bool OptionHandler::renderWaveformImages(
+    const boost::filesystem::path& input_filename,
+    const Options& options)
+{
+    const std::vector<ImageSpec>& images = options.getOutputImages();
+
+    assert(!images.empty());
+
+    std::vector<int> zoom_levels;
+
+    for (const auto& image : images) {
+        if (boost::filesystem::path(image.filename).extension() != ".png") {
+            error_stream << "Can't generate " << image.filename
+                         << " from " << input_filename << '\n';
+            return false;
+        }
+
+        zoom_levels.push_back(image.samples_per_pixel);
     }
 
-    if (options.hasWaveformColor()) {
-        colors.waveform_color = options.getWaveformColor();
+    const int samples_per_pixel = *std::min_element(zoom_levels.begin(), zoom_levels.end());
+
+    const PngWriter::Filter png_filter = getPngFilter(options);
+
+    const WaveformColors colors = createWaveformColors(options);
+
+    WaveformBuffer input_buffer;
+
+    // Audio files are analysed at the most detailed zoom level, from which all
+    // the others can be rescaled
+    if (!loadWaveformData(
+        input_filename,
+        samples_per_pixel,
+        options,
+        input_buffer))
+    {
+        return false;
     }
 
-    if (options.hasAxisLabelColor()) {
-        colors.axis_label_color = options.getAxisLabelColor();
+    const int input_samples_per_pixel = input_buffer.getSamplesPerPixel();
+
+    if (samples_per_pixel < input_samples_per_pixel) {
+        error_stream << "Invalid zoom, minimum: " << input_samples_per_pixel << '\n';
+        return false;
     }
 
-    if (!renderer.create(
-        *render_buffer,
-        options.getStartTime(),
-        options.getImageWidth(),
-        options.getImageHeight(),
-        colors,
-        options.getRenderAxisLabels()))
-    {
+    // Rescale to all the zoom levels in one go, so that each can be computed
+    // from a more detailed one
+    std::vector<const WaveformBuffer*> zoom_buffers;
+
+    WaveformRescaler rescaler;
+
+    if (!rescaler.rescale(input_buffer, zoom_levels, zoom_buffers)) {
         return false;
     }
 
-    return renderer.saveAsPng(output_filename.string().c_str());
+    for (size_t i = 0; i < images.size(); ++i) {
+        const ImageSpec& image = images[i];
+
+        if (!renderImage(
+            *zoom_buffers[i],
+            0,
+            colors,
+            image.width,
+            image.height,
+            image.filename,
+            png_filter,
+            options))
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -329,12 +1372,33 @@ bool OptionHandler::run(const Options& options)
     const boost::filesystem::path output_filename = options.getOutputFilename();
 
     const boost::filesystem::path input_file_ext  = input_filename.extension();
-    const boost::filesystem::path output_file_ext = output_filename.extension();
+    const boost::filesystem::path output_file_ext = getOutputFileExtension(output_filename);
 
     bool success;
 
     try {
-        if (input_file_ext == ".mp3" && output_file_ext == ".wav") {
+        if (!options.getOutputImages().empty() &&
+            (isWaveformDataFile(input_filename) ||
+             input_file_ext == ".mp3" ||
+             input_file_ext == ".wav" ||
+             input_file_ext == ".flac")) {
+            success = renderWaveformImages(
+                input_filename,
+                options
+            );
+        }
+        else if (!options.getTileZoomLevels().empty() &&
+            (isWaveformDataFile(input_filename) ||
+             input_file_ext == ".mp3" ||
+             input_file_ext == ".wav" ||
+             input_file_ext == ".flac")) {
+            success = renderWaveformTiles(
+                input_filename,
+                output_filename,
+                options
+            );
+        }
+        else if (input_file_ext == ".mp3" && output_file_ext == ".wav") {
             success = convertAudioFormat(
                 input_filename,
                 output_filename
@@ -342,23 +1406,31 @@ bool OptionHandler::run(const Options& options)
         }
         else if ((input_file_ext == ".mp3" ||
                   input_file_ext == ".wav" ||
-                  input_file_ext == ".flac") &&
-                 (output_file_ext == ".dat" || output_file_ext == ".json")) {
+                  input_file_ext == ".flac" ||
+                  isPlaylist(input_filename)) &&
+                 (output_file_ext == ".dat" ||
+                  output_file_ext == ".json" ||
+                  output_file_ext == ".msgpack" ||
+                  output_file_ext == ".cbor")) {
             success = generateWaveformData(
                 input_filename,
                 output_filename,
                 options
             );
         }
-        else if (input_file_ext == ".dat" &&
-                 (output_file_ext == ".txt" || output_file_ext == ".json")) {
+        else if (isWaveformDataFile(input_filename) &&
+                 (output_file_ext == ".dat" ||
+                  output_file_ext == ".txt" ||
+                  output_file_ext == ".json" ||
+                  output_file_ext == ".msgpack" ||
+                  output_file_ext == ".cbor")) {
             success = convertWaveformData(
                 input_filename,
                 output_filename,
                 options
             );
         }
-        else if ((input_file_ext == ".dat" ||
+        else if ((isWaveformDataFile(input_filename) ||
                   input_file_ext == ".mp3" ||
                   input_file_ext == ".wav" ||
                   input_file_ext == ".flac") && output_file_ext == ".png") {
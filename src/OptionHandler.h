@@ -28,6 +28,8 @@
 
 #include <boost/filesystem.hpp>
 
+#include <vector>
+
 //------------------------------------------------------------------------------
 
 class Options;
@@ -57,6 +59,12 @@ class OptionHandler
             const Options& options
         );
 
+        bool mergeWaveformData(
+            const std::vector<boost::filesystem::path>& input_filenames,
+            const boost::filesystem::path& output_filename,
+            const Options& options
+        );
+
         bool convertWaveformData(
             const boost::filesystem::path& input_filename,
             const boost::filesystem::path& output_filename,
@@ -68,6 +76,17 @@ class OptionHandler
             const boost::filesystem::path& output_filename,
             const Options& options
         );
+
+        bool renderWaveformImages(
+            const boost::filesystem::path& input_filename,
+            const Options& options
+        );
+
+        bool renderWaveformTiles(
+            const boost::filesystem::path& input_filename,
+            const boost::filesystem::path& output_path,
+            const Options& options
+        );
 };
 
 //------------------------------------------------------------------------------
@@ -49,7 +49,21 @@ Options::Options() :
     image_height_(0),
     bits_(16),
     has_bits_(false),
-    render_axis_labels_(true)
+    render_axis_labels_(true),
+    png_palette_(false),
+    png_compression_level_(-1),
+    has_png_filter_(false),
+    png_threads_(0),
+    png_stream_(false),
+    tile_width_(256),
+    index_(false),
+    link_audio_(false),
+    resume_(false),
+    compress_(false),
+    gzip_compression_level_(-1),
+    rms_(false),
+    split_channels_(false),
+    has_segment_cache_(false)
 {
 }
 
@@ -131,12 +145,72 @@ bool Options::parseCommandLine(int argc, char *argv[])
         "axis-label-color",
         po::value<RGBA>(&axis_label_color_),
         "axis label color (rrggbb[aa])"
+    )(
+        "rms-color",
+        po::value<RGBA>(&rms_color_),
+        "RMS color (rrggbb[aa])"
     )(
         "no-axis-labels",
         "render waveform image without axis labels"
     )(
         "with-axis-labels",
         "render waveform image with axis labels (default)"
+    )(
+        "png-palette",
+        "render waveform image using an indexed color palette"
+    )(
+        "png-compression",
+        po::value<int>(&png_compression_level_)->default_value(-1),
+        "PNG compression level (0 to 9, or -1 for default)"
+    )(
+        "png-filter",
+        po::value<std::string>(&png_filter_),
+        "PNG row filter (none, sub, up, average, paeth, or adaptive)"
+    )(
+        "png-threads",
+        po::value<int>(&png_threads_)->default_value(0),
+        "number of threads used to encode large PNG images (0 for one per CPU)"
+    )(
+        "png-stream",
+        "render waveform image one band of rows at a time, to reduce memory use"
+    )(
+        "tile-zoom",
+        po::value<std::vector<int>>(&tile_zoom_levels_)->multitoken(),
+        "render waveform image tiles at the given zoom levels (samples per pixel)"
+    )(
+        "tile-width",
+        po::value<int>(&tile_width_)->default_value(256),
+        "width of waveform image tiles (pixels)"
+    )(
+        "output-image",
+        po::value<std::vector<ImageSpec>>(&output_images_)->multitoken(),
+        "render waveform images, each given as <width>x<height>x<zoom>:<filename>"
+    )(
+        "index",
+        "save or use a min/max index file (.dat.idx) next to the waveform data file"
+    )(
+        "link-audio",
+        "save the input audio file name (.dat.src) next to the waveform data file"
+    )(
+        "resume",
+        "append to an existing waveform data file from where it was last generated, using its resume file (.dat.resume)"
+    )(
+        "compress",
+        "compress output waveform data (.dat) files"
+    )(
+        "gzip-compression",
+        po::value<int>(&gzip_compression_level_)->default_value(-1),
+        "compression level of gzip compressed (.json.gz or .txt.gz) output files (0 to 9, or -1 for default)"
+    )(
+        "rms",
+        "include the RMS of each point's audio samples in output waveform data and images"
+    )(
+        "split-channels",
+        "output the waveform of each audio channel separately, instead of combining them"
+    )(
+        "segment-cache",
+        po::value<std::string>(&segment_cache_),
+        "directory in which to cache the waveform data for each file in a playlist (.m3u) input file"
     );
 
     po::variables_map variables_map;
@@ -154,6 +228,15 @@ bool Options::parseCommandLine(int argc, char *argv[])
         }
 
         render_axis_labels_ = variables_map.count("no-axis-labels") == 0;
+        png_palette_ = variables_map.count("png-palette") != 0;
+        png_stream_  = variables_map.count("png-stream") != 0;
+        index_       = variables_map.count("index") != 0;
+        link_audio_  = variables_map.count("link-audio") != 0;
+        resume_      = variables_map.count("resume") != 0;
+        compress_    = variables_map.count("compress") != 0;
+        rms_         = variables_map.count("rms") != 0;
+
+        split_channels_ = variables_map.count("split-channels") != 0;
 
         const auto& end_option = variables_map["end"];
         has_end_time_ = !end_option.defaulted();
@@ -173,17 +256,50 @@ bool Options::parseCommandLine(int argc, char *argv[])
         has_background_color_ = hasOptionValue(variables_map, "background-color");
         has_waveform_color_   = hasOptionValue(variables_map, "waveform-color");
         has_axis_label_color_ = hasOptionValue(variables_map, "axis-label-color");
+        has_rms_color_        = hasOptionValue(variables_map, "rms-color");
+        has_png_filter_       = hasOptionValue(variables_map, "png-filter");
+        has_segment_cache_    = hasOptionValue(variables_map, "segment-cache");
 
         if (bits_ != 8 && bits_ != 16) {
             error_stream << "Invalid bits: must be either 8 or 16\n";
             success = false;
         }
 
+        if (png_compression_level_ < -1 || png_compression_level_ > 9) {
+            error_stream << "Invalid PNG compression level: must be between 0 and 9\n";
+            success = false;
+        }
+
+        if (gzip_compression_level_ < -1 || gzip_compression_level_ > 9) {
+            error_stream << "Invalid gzip compression level: must be between 0 and 9\n";
+            success = false;
+        }
+
+        if (png_threads_ < 0) {
+            error_stream << "Invalid PNG threads: must be zero or greater\n";
+            success = false;
+        }
+
+        if (tile_width_ < 1) {
+            error_stream << "Invalid tile width: minimum 1\n";
+            success = false;
+        }
+
+        for (const int zoom : tile_zoom_levels_) {
+            if (zoom < 2) {
+                error_stream << "Invalid tile zoom: minimum 2\n";
+                success = false;
+                break;
+            }
+        }
+
         if(input_filename_.empty()) {
             //error_stream << "Missing input filename\n";
             throw(std::runtime_error("Missing input filename\n"));
-        } else if(output_filename_.empty()) {
+        } else if(output_filename_.empty() && output_images_.empty()) {
             throw(std::runtime_error("Missing output filename\n"));
+        } else if(!output_filename_.empty() && !output_images_.empty()) {
+            throw(std::runtime_error("Specify either output filename or output images, but not both\n"));
         }
     }
     catch (std::runtime_error& e) {
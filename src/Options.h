@@ -26,6 +26,7 @@
 
 //------------------------------------------------------------------------------
 
+#include "ImageSpec.h"
 #include "Rgba.h"
 
 #include <boost/program_options.hpp>
@@ -33,6 +34,7 @@
 #include <iosfwd>
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 //------------------------------------------------------------------------------
 
@@ -78,14 +80,47 @@ class Options
         const RGBA& getBackgroundColor() const { return background_color_; }
         const RGBA& getWaveformColor() const { return waveform_color_; }
         const RGBA& getAxisLabelColor() const { return axis_label_color_; }
+        const RGBA& getRmsColor() const { return rms_color_; }
 
         bool hasBorderColor() const { return has_border_color_; }
         bool hasBackgroundColor() const { return has_background_color_; }
         bool hasWaveformColor() const { return has_waveform_color_; }
         bool hasAxisLabelColor() const { return has_axis_label_color_; }
+        bool hasRmsColor() const { return has_rms_color_; }
 
         bool getRenderAxisLabels() const { return render_axis_labels_; }
 
+        bool getPngPalette() const { return png_palette_; }
+        int getPngCompressionLevel() const { return png_compression_level_; }
+
+        const std::string& getPngFilter() const { return png_filter_; }
+        bool hasPngFilter() const { return has_png_filter_; }
+
+        int getPngThreads() const { return png_threads_; }
+
+        bool getPngStream() const { return png_stream_; }
+
+        const std::vector<int>& getTileZoomLevels() const { return tile_zoom_levels_; }
+        int getTileWidth() const { return tile_width_; }
+
+        const std::vector<ImageSpec>& getOutputImages() const { return output_images_; }
+
+        bool getIndex() const { return index_; }
+
+        bool getLinkAudio() const { return link_audio_; }
+
+        bool getResume() const { return resume_; }
+
+        bool getCompress() const { return compress_; }
+        int getGzipCompressionLevel() const { return gzip_compression_level_; }
+
+        bool getRms() const { return rms_; }
+
+        bool getSplitChannels() const { return split_channels_; }
+
+        const std::string& getSegmentCache() const { return segment_cache_; }
+        bool hasSegmentCache() const { return has_segment_cache_; }
+
         bool getHelp() const { return help_; }
         bool getVersion() const { return version_; }
 
@@ -126,13 +161,46 @@ class Options
         RGBA background_color_;
         RGBA waveform_color_;
         RGBA axis_label_color_;
+        RGBA rms_color_;
 
         bool has_border_color_;
         bool has_background_color_;
         bool has_waveform_color_;
         bool has_axis_label_color_;
+        bool has_rms_color_;
 
         bool render_axis_labels_;
+
+        bool png_palette_;
+        int png_compression_level_;
+
+        std::string png_filter_;
+        bool has_png_filter_;
+
+        int png_threads_;
+
+        bool png_stream_;
+
+        std::vector<int> tile_zoom_levels_;
+        int tile_width_;
+
+        std::vector<ImageSpec> output_images_;
+
+        bool index_;
+
+        bool link_audio_;
+
+        bool resume_;
+
+        bool compress_;
+        int gzip_compression_level_;
+
+        bool rms_;
+
+        bool split_channels_;
+
+        std::string segment_cache_;
+        bool has_segment_cache_;
 };
 
 //------------------------------------------------------------------------------
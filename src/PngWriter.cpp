@@ -0,0 +1,835 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "PngWriter.h"
+#include "ErrorUtil.h"
+#include "Streams.h"
+#include "nullptr.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+//------------------------------------------------------------------------------
+
+// Minimum amount of scanline data compressed by each thread. Below this, the
+// cost of starting threads outweighs any benefit.
+
+const std::size_t MIN_SEGMENT_SIZE = 1024 * 1024;
+
+// Maximum size of the deflate sliding window, used as the preset dictionary
+// for each segment.
+
+const std::size_t DICTIONARY_SIZE = 32768;
+
+// Maximum number of bytes written in each IDAT chunk.
+
+const std::size_t MAX_CHUNK_SIZE = 256 * 1024;
+
+const int COLOR_TYPE_RGB       = 2;
+const int COLOR_TYPE_PALETTE   = 3;
+const int COLOR_TYPE_RGB_ALPHA = 6;
+
+//------------------------------------------------------------------------------
+
+static void writeUInt32(unsigned char* p, uint32_t value)
+{
+    p[0] = static_cast<unsigned char>(value >> 24);
+    p[1] = static_cast<unsigned char>(value >> 16);
+    p[2] = static_cast<unsigned char>(value >> 8);
+    p[3] = static_cast<unsigned char>(value);
+}
+
+//------------------------------------------------------------------------------
+
+// Converts a libgd alpha value (0 opaque, 127 transparent) to a PNG alpha value
+// (255 opaque, 0 transparent), as done by gdImagePng.
+
+static unsigned char convertAlpha(int alpha)
+{
+    return static_cast<unsigned char>(255 - ((alpha << 1) + (alpha >> 6)));
+}
+
+//------------------------------------------------------------------------------
+
+static unsigned char paethPredictor(int a, int b, int c)
+{
+    const int p  = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+
+    if (pa <= pb && pa <= pc) {
+        return static_cast<unsigned char>(a);
+    }
+    else if (pb <= pc) {
+        return static_cast<unsigned char>(b);
+    }
+    else {
+        return static_cast<unsigned char>(c);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Applies the given PNG filter type to a single scanline. The prev pointer
+// refers to the preceding unfiltered scanline, or is nullptr for the first row.
+// Returns the sum of absolute values of the filtered bytes, treated as signed,
+// which is the heuristic used to select a filter in adaptive mode.
+
+static unsigned long filterRow(
+    int filter,
+    const unsigned char* row,
+    const unsigned char* prev,
+    std::size_t row_bytes,
+    std::size_t pixel_bytes,
+    unsigned char* output)
+{
+    unsigned long sum = 0;
+
+    for (std::size_t i = 0; i < row_bytes; ++i) {
+        const int a = i >= pixel_bytes ? row[i - pixel_bytes] : 0;
+        const int b = prev != nullptr ? prev[i] : 0;
+        const int c = (prev != nullptr && i >= pixel_bytes) ? prev[i - pixel_bytes] : 0;
+
+        int predictor;
+
+        switch (filter) {
+            case PngWriter::FILTER_SUB:
+                predictor = a;
+                break;
+
+            case PngWriter::FILTER_UP:
+                predictor = b;
+                break;
+
+            case PngWriter::FILTER_AVERAGE:
+                predictor = (a + b) / 2;
+                break;
+
+            case PngWriter::FILTER_PAETH:
+                predictor = paethPredictor(a, b, c);
+                break;
+
+            default:
+                predictor = 0;
+                break;
+        }
+
+        const unsigned char value = static_cast<unsigned char>(row[i] - predictor);
+
+        output[i] = value;
+
+        sum += static_cast<unsigned long>(value < 128 ? value : 256 - value);
+    }
+
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+
+PngWriter::PngWriter(
+    const int compression_level,
+    const Filter filter,
+    const int threads) :
+    compression_level_(compression_level),
+    filter_(filter),
+    threads_(threads),
+    width_(0),
+    height_(0),
+    bit_depth_(8),
+    color_type_(COLOR_TYPE_RGB),
+    pixel_bytes_(0),
+    row_bytes_(0),
+    verbose_(true),
+    error_stream_(&error_stream),
+    file_(nullptr),
+    rows_written_(0)
+{
+    if (threads_ < 1) {
+        threads_ = static_cast<int>(std::thread::hardware_concurrency());
+
+        if (threads_ < 1) {
+            threads_ = 1;
+        }
+    }
+
+    memset(&stream_, 0, sizeof(stream_));
+}
+
+//------------------------------------------------------------------------------
+
+PngWriter::~PngWriter()
+{
+    if (file_ != nullptr) {
+        deflateEnd(&stream_);
+
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the PNG bit depth: 8 for true color images, or the smallest that can
+// index all the palette entries.
+
+static int getBitDepth(gdImagePtr image)
+{
+    if (gdImageTrueColor(image)) {
+        return 8;
+    }
+
+    const int colors = gdImageColorsTotal(image);
+
+    return colors <= 2 ? 1 : colors <= 4 ? 2 : colors <= 16 ? 4 : 8;
+}
+
+//------------------------------------------------------------------------------
+
+static std::size_t getPixelBytes(gdImagePtr image)
+{
+    if (gdImageTrueColor(image)) {
+        return image->saveAlphaFlag ? 4 : 3;
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the size of each scanline, without the filter type byte.
+
+static std::size_t getRowBytes(gdImagePtr image)
+{
+    const std::size_t width = static_cast<std::size_t>(gdImageSX(image));
+
+    if (gdImageTrueColor(image)) {
+        return getPixelBytes(image) * width;
+    }
+
+    return (width * static_cast<std::size_t>(getBitDepth(image)) + 7) / 8;
+}
+
+//------------------------------------------------------------------------------
+
+void PngWriter::setImageFormat(gdImagePtr image)
+{
+    width_  = gdImageSX(image);
+    height_ = gdImageSY(image);
+
+    if (gdImageTrueColor(image)) {
+        color_type_ = image->saveAlphaFlag ? COLOR_TYPE_RGB_ALPHA : COLOR_TYPE_RGB;
+    }
+    else {
+        color_type_ = COLOR_TYPE_PALETTE;
+    }
+
+    bit_depth_   = getBitDepth(image);
+    pixel_bytes_ = getPixelBytes(image);
+    row_bytes_   = getRowBytes(image);
+}
+
+//------------------------------------------------------------------------------
+
+// As recommended by the PNG specification, palette images are best left
+// unfiltered, while true color images compress best with adaptive filtering.
+
+PngWriter::Filter PngWriter::getFilter() const
+{
+    if (filter_ != FILTER_DEFAULT) {
+        return filter_;
+    }
+
+    return color_type_ == COLOR_TYPE_PALETTE ? FILTER_NONE : FILTER_ADAPTIVE;
+}
+
+//------------------------------------------------------------------------------
+
+int PngWriter::getSegmentCount(gdImagePtr image) const
+{
+    const std::size_t size =
+        (getRowBytes(image) + 1) * static_cast<std::size_t>(gdImageSY(image));
+
+    const std::size_t max_segments = std::max<std::size_t>(size / MIN_SEGMENT_SIZE, 1);
+
+    return static_cast<int>(std::min<std::size_t>(static_cast<std::size_t>(threads_), max_segments));
+}
+
+//------------------------------------------------------------------------------
+
+void PngWriter::writeChunk(
+    FILE* file,
+    const char* type,
+    const unsigned char* data,
+    const std::size_t length)
+{
+    unsigned char header[8];
+    writeUInt32(header, static_cast<uint32_t>(length));
+    memcpy(header + 4, type, 4);
+
+    uLong crc = crc32(0, Z_NULL, 0);
+    crc = crc32(crc, header + 4, 4);
+
+    if (length > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(length));
+    }
+
+    unsigned char trailer[4];
+    writeUInt32(trailer, static_cast<uint32_t>(crc));
+
+    fwrite(header, 1, sizeof(header), file);
+
+    if (length > 0) {
+        fwrite(data, 1, length, file);
+    }
+
+    fwrite(trailer, 1, sizeof(trailer), file);
+}
+
+//------------------------------------------------------------------------------
+
+void PngWriter::writeHeader(FILE* file, gdImagePtr image) const
+{
+    static const unsigned char signature[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+    };
+
+    fwrite(signature, 1, sizeof(signature), file);
+
+    unsigned char ihdr[13];
+    writeUInt32(ihdr, static_cast<uint32_t>(width_));
+    writeUInt32(ihdr + 4, static_cast<uint32_t>(height_));
+    ihdr[8]  = static_cast<unsigned char>(bit_depth_);
+    ihdr[9]  = static_cast<unsigned char>(color_type_);
+    ihdr[10] = 0; // Compression method: deflate
+    ihdr[11] = 0; // Filter method: adaptive
+    ihdr[12] = 0; // Interlace method: none
+
+    writeChunk(file, "IHDR", ihdr, sizeof(ihdr));
+
+    if (color_type_ == COLOR_TYPE_PALETTE) {
+        const int colors = gdImageColorsTotal(image);
+        const int transparent = gdImageGetTransparent(image);
+
+        std::vector<unsigned char> palette;
+        std::vector<unsigned char> alpha;
+
+        bool has_alpha = false;
+
+        for (int i = 0; i < colors; ++i) {
+            palette.push_back(static_cast<unsigned char>(gdImageRed(image, i)));
+            palette.push_back(static_cast<unsigned char>(gdImageGreen(image, i)));
+            palette.push_back(static_cast<unsigned char>(gdImageBlue(image, i)));
+
+            if (i == transparent) {
+                alpha.push_back(0);
+                has_alpha = true;
+            }
+            else {
+                const int value = gdImageAlpha(image, i);
+                alpha.push_back(convertAlpha(value));
+
+                if (value != 0) {
+                    has_alpha = true;
+                }
+            }
+        }
+
+        writeChunk(file, "PLTE", &palette[0], palette.size());
+
+        if (has_alpha) {
+            writeChunk(file, "tRNS", &alpha[0], alpha.size());
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Packs a row of palette indices, one per byte, into a PNG scanline at the
+// image bit depth.
+
+void PngWriter::packRow(
+    const unsigned char* indices,
+    unsigned char* output) const
+{
+    if (bit_depth_ == 8) {
+        memcpy(output, indices, static_cast<std::size_t>(width_));
+    }
+    else {
+        memset(output, 0, row_bytes_);
+
+        const int pixels_per_byte = 8 / bit_depth_;
+
+        for (int x = 0; x < width_; ++x) {
+            const int shift = 8 - bit_depth_ * (x % pixels_per_byte + 1);
+
+            output[x / pixels_per_byte] |= static_cast<unsigned char>(indices[x] << shift);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Converts the image to unfiltered PNG scanlines, without the leading filter
+// type bytes.
+
+void PngWriter::getScanlines(
+    gdImagePtr image,
+    std::vector<unsigned char>& scanlines) const
+{
+    scanlines.assign(row_bytes_ * static_cast<std::size_t>(height_), 0);
+
+    for (int y = 0; y < height_; ++y) {
+        unsigned char* row = &scanlines[row_bytes_ * static_cast<std::size_t>(y)];
+
+        if (color_type_ == COLOR_TYPE_PALETTE) {
+            packRow(image->pixels[y], row);
+        }
+        else {
+            for (int x = 0; x < width_; ++x) {
+                const int color = gdImageTrueColorPixel(image, x, y);
+
+                *row++ = static_cast<unsigned char>(gdTrueColorGetRed(color));
+                *row++ = static_cast<unsigned char>(gdTrueColorGetGreen(color));
+                *row++ = static_cast<unsigned char>(gdTrueColorGetBlue(color));
+
+                if (color_type_ == COLOR_TYPE_RGB_ALPHA) {
+                    *row++ = convertAlpha(gdTrueColorGetAlpha(color));
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Filters a single scanline, writing the filter type byte followed by the
+// filtered data to output. The candidate buffer must hold row_bytes_ bytes,
+// and is used to try each filter type in adaptive mode.
+
+void PngWriter::filterScanline(
+    const unsigned char* row,
+    const unsigned char* prev,
+    unsigned char* output,
+    unsigned char* candidate) const
+{
+    const Filter filter = getFilter();
+
+    if (filter == FILTER_ADAPTIVE) {
+        unsigned long best_sum = 0;
+
+        for (int type = FILTER_NONE; type <= FILTER_PAETH; ++type) {
+            const unsigned long sum = filterRow(
+                type, row, prev, row_bytes_, pixel_bytes_, candidate
+            );
+
+            if (type == FILTER_NONE || sum < best_sum) {
+                best_sum = sum;
+                output[0] = static_cast<unsigned char>(type);
+                memcpy(output + 1, candidate, row_bytes_);
+            }
+        }
+    }
+    else {
+        output[0] = static_cast<unsigned char>(filter);
+        filterRow(filter, row, prev, row_bytes_, pixel_bytes_, output + 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void PngWriter::filterRows(
+    const std::vector<unsigned char>& scanlines,
+    std::vector<unsigned char>& filtered,
+    const int first_row,
+    const int last_row) const
+{
+    std::vector<unsigned char> candidate(row_bytes_);
+
+    for (int y = first_row; y < last_row; ++y) {
+        const std::size_t index = static_cast<std::size_t>(y);
+
+        const unsigned char* row  = &scanlines[index * row_bytes_];
+        const unsigned char* prev = y > 0 ? row - row_bytes_ : nullptr;
+
+        filterScanline(row, prev, &filtered[index * (row_bytes_ + 1)], &candidate[0]);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Compresses the filtered data from start to end as a raw deflate stream. All
+// but the last segment end with a sync flush rather than a final block, so the
+// segments can be concatenated into a single valid stream.
+
+void PngWriter::compressSegment(
+    const std::vector<unsigned char>& filtered,
+    const std::size_t start,
+    const std::size_t end,
+    const bool last,
+    std::vector<unsigned char>& output) const
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    const int strategy = getFilter() == FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+
+    int result = deflateInit2(
+        &stream,
+        compression_level_,
+        Z_DEFLATED,
+        -15, // Raw deflate, 32 KB window
+        8,
+        strategy
+    );
+
+    assert(result == Z_OK);
+
+    if (start > 0) {
+        const std::size_t dictionary_size = std::min(start, DICTIONARY_SIZE);
+
+        result = deflateSetDictionary(
+            &stream,
+            &filtered[start - dictionary_size],
+            static_cast<uInt>(dictionary_size)
+        );
+
+        assert(result == Z_OK);
+    }
+
+    output.resize(deflateBound(&stream, static_cast<uLong>(end - start)) + 16);
+
+    stream.next_in   = const_cast<Bytef*>(&filtered[start]);
+    stream.avail_in  = static_cast<uInt>(end - start);
+    stream.next_out  = &output[0];
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+
+    for (;;) {
+        result = deflate(&stream, flush);
+
+        assert(result != Z_STREAM_ERROR);
+
+        if (last ? result == Z_STREAM_END : stream.avail_out != 0) {
+            break;
+        }
+
+        // Output buffer full, so grow it and continue
+        const std::size_t used = output.size();
+        output.resize(used * 2);
+
+        stream.next_out  = &output[used];
+        stream.avail_out = static_cast<uInt>(output.size() - used);
+    }
+
+    output.resize(output.size() - stream.avail_out);
+
+    deflateEnd(&stream);
+}
+
+//------------------------------------------------------------------------------
+
+bool PngWriter::write(gdImagePtr image, const char* filename)
+{
+    setImageFormat(image);
+
+    const int segment_count = getSegmentCount(image);
+
+    FILE* output_file = fopen(filename, "wb");
+
+    if (output_file == nullptr) {
+        *error_stream_ << "Failed to write PNG file: " << filename << '\n'
+                       << ErrorUtil::errorToString(errno) << '\n';
+
+        return false;
+    }
+
+    if (verbose_) {
+        output_stream << "Writing PNG file: " << filename
+                      << "\nPNG encoder threads: " << segment_count << std::endl;
+    }
+
+    writeHeader(output_file, image);
+
+    std::vector<unsigned char> scanlines;
+    getScanlines(image, scanlines);
+
+    std::vector<unsigned char> filtered((row_bytes_ + 1) * static_cast<std::size_t>(height_));
+
+    // Each segment covers a band of whole rows, so that the filter type byte
+    // and the row it applies to are compressed together.
+
+    std::vector<int> first_rows;
+
+    for (int i = 0; i <= segment_count; ++i) {
+        first_rows.push_back(static_cast<int>(
+            static_cast<long long>(height_) * i / segment_count
+        ));
+    }
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < segment_count; ++i) {
+        threads.push_back(std::thread(
+            &PngWriter::filterRows,
+            this,
+            std::cref(scanlines),
+            std::ref(filtered),
+            first_rows[i],
+            first_rows[i + 1]
+        ));
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    threads.clear();
+
+    std::vector<std::vector<unsigned char>> segments(static_cast<std::size_t>(segment_count));
+
+    for (int i = 0; i < segment_count; ++i) {
+        const std::size_t start = static_cast<std::size_t>(first_rows[i]) * (row_bytes_ + 1);
+        const std::size_t end   = static_cast<std::size_t>(first_rows[i + 1]) * (row_bytes_ + 1);
+
+        threads.push_back(std::thread(
+            &PngWriter::compressSegment,
+            this,
+            std::cref(filtered),
+            start,
+            end,
+            i == segment_count - 1,
+            std::ref(segments[static_cast<std::size_t>(i)])
+        ));
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Assemble the zlib stream: header, concatenated deflate segments, and
+    // Adler-32 checksum of the uncompressed data
+
+    std::vector<unsigned char> data;
+
+    const int level = compression_level_ == Z_DEFAULT_COMPRESSION ? 6 : compression_level_;
+    const int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+
+    const int cmf = 0x78;
+    int flg = flevel << 6;
+    flg += 31 - (cmf * 256 + flg) % 31;
+
+    data.push_back(static_cast<unsigned char>(cmf));
+    data.push_back(static_cast<unsigned char>(flg));
+
+    for (const auto& segment : segments) {
+        data.insert(data.end(), segment.begin(), segment.end());
+    }
+
+    uLong adler = adler32(0, Z_NULL, 0);
+
+    for (std::size_t offset = 0; offset < filtered.size(); offset += MAX_CHUNK_SIZE) {
+        const std::size_t length = std::min(MAX_CHUNK_SIZE, filtered.size() - offset);
+        adler = adler32(adler, &filtered[offset], static_cast<uInt>(length));
+    }
+
+    unsigned char checksum[4];
+    writeUInt32(checksum, static_cast<uint32_t>(adler));
+    data.insert(data.end(), checksum, checksum + sizeof(checksum));
+
+    for (std::size_t offset = 0; offset < data.size(); offset += MAX_CHUNK_SIZE) {
+        const std::size_t length = std::min(MAX_CHUNK_SIZE, data.size() - offset);
+        writeChunk(output_file, "IDAT", &data[offset], length);
+    }
+
+    writeChunk(output_file, "IEND", nullptr, 0);
+
+    bool success = ferror(output_file) == 0;
+
+    if (fclose(output_file) != 0) {
+        success = false;
+    }
+
+    if (!success) {
+        *error_stream_ << "Failed to write PNG file: " << filename << '\n'
+                       << ErrorUtil::errorToString(errno) << '\n';
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+// Starts writing a palette image row by row. The image width and palette are
+// taken from palette_image, whose pixel data is not used.
+
+bool PngWriter::open(
+    const char* filename,
+    gdImagePtr palette_image,
+    const int height)
+{
+    assert(file_ == nullptr);
+    assert(!gdImageTrueColor(palette_image));
+
+    setImageFormat(palette_image);
+    height_ = height;
+
+    file_ = fopen(filename, "wb");
+
+    if (file_ == nullptr) {
+        *error_stream_ << "Failed to write PNG file: " << filename << '\n'
+                       << ErrorUtil::errorToString(errno) << '\n';
+
+        return false;
+    }
+
+    filename_ = filename;
+
+    if (verbose_) {
+        output_stream << "Writing PNG file: " << filename << std::endl;
+    }
+
+    writeHeader(file_, palette_image);
+
+    memset(&stream_, 0, sizeof(stream_));
+
+    const int strategy = getFilter() == FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+
+    const int result = deflateInit2(
+        &stream_,
+        compression_level_,
+        Z_DEFLATED,
+        15, // zlib format, 32 KB window
+        8,
+        strategy
+    );
+
+    assert(result == Z_OK);
+
+    rows_written_ = 0;
+
+    row_.assign(row_bytes_, 0);
+    prev_row_.assign(row_bytes_, 0);
+    filtered_.assign(row_bytes_ + 1, 0);
+    candidate_.assign(row_bytes_, 0);
+    output_.resize(MAX_CHUNK_SIZE);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Writes the next row of the image, given as one palette index per pixel.
+
+bool PngWriter::writeRow(const unsigned char* indices)
+{
+    assert(file_ != nullptr);
+    assert(rows_written_ < height_);
+
+    packRow(indices, &row_[0]);
+
+    filterScanline(
+        &row_[0],
+        rows_written_ > 0 ? &prev_row_[0] : nullptr,
+        &filtered_[0],
+        &candidate_[0]
+    );
+
+    stream_.next_in  = &filtered_[0];
+    stream_.avail_in = static_cast<uInt>(filtered_.size());
+
+    deflateToFile(Z_NO_FLUSH);
+
+    row_.swap(prev_row_);
+    rows_written_++;
+
+    if (ferror(file_) != 0) {
+        *error_stream_ << "Failed to write PNG file: " << filename_ << '\n'
+                       << ErrorUtil::errorToString(errno) << '\n';
+
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool PngWriter::close()
+{
+    assert(file_ != nullptr);
+    assert(rows_written_ == height_);
+
+    deflateToFile(Z_FINISH);
+    deflateEnd(&stream_);
+
+    writeChunk(file_, "IEND", nullptr, 0);
+
+    bool success = ferror(file_) == 0;
+
+    if (fclose(file_) != 0) {
+        success = false;
+    }
+
+    file_ = nullptr;
+
+    if (!success) {
+        *error_stream_ << "Failed to write PNG file: " << filename_ << '\n'
+                       << ErrorUtil::errorToString(errno) << '\n';
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+// Compresses any pending input, writing an IDAT chunk each time the output
+// buffer fills. With Z_FINISH, also writes the remainder of the stream.
+
+void PngWriter::deflateToFile(const int flush)
+{
+    do {
+        stream_.next_out  = &output_[0];
+        stream_.avail_out = static_cast<uInt>(output_.size());
+
+        const int result = deflate(&stream_, flush);
+
+        assert(result != Z_STREAM_ERROR);
+
+        const std::size_t length = output_.size() - stream_.avail_out;
+
+        if (length > 0) {
+            writeChunk(file_, "IDAT", &output_[0], length);
+        }
+    }
+    while (stream_.avail_out == 0);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_PNG_WRITER_H)
+#define INC_PNG_WRITER_H
+
+//------------------------------------------------------------------------------
+
+#include <gd.h>
+#include <zlib.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+// Writes PNG files using zlib directly, rather than through libgd. The image
+// scanlines are divided into segments which are filtered and compressed on
+// separate threads, in the same way as pigz. Each segment is primed with the
+// last 32 KB of the preceding segment's data as a preset dictionary, so the
+// compression ratio is almost the same as compressing the image as a single
+// stream.
+//
+// Palette images can also be written one row at a time, using open(),
+// writeRow(), and close(), so that the whole image need never be held in
+// memory. If writeRow() fails, close() must not be called; the destructor
+// closes the incomplete file.
+
+class PngWriter
+{
+    public:
+        enum Filter {
+            FILTER_DEFAULT = -1,
+            FILTER_NONE,
+            FILTER_SUB,
+            FILTER_UP,
+            FILTER_AVERAGE,
+            FILTER_PAETH,
+            FILTER_ADAPTIVE
+        };
+
+    public:
+        PngWriter(int compression_level, Filter filter, int threads);
+        ~PngWriter();
+
+        PngWriter(const PngWriter&) = delete;
+        PngWriter& operator=(const PngWriter&) = delete;
+
+    public:
+        // Enables or disables progress messages (enabled by default)
+        void setVerbose(bool verbose) { verbose_ = verbose; }
+
+        // Sets the stream for error messages (error_stream by default), e.g.,
+        // to collect the messages from a worker thread
+        void setErrorStream(std::ostream& stream) { error_stream_ = &stream; }
+
+        // Returns the number of segments the image would be compressed in,
+        // i.e., the number of threads write() would use
+        int getSegmentCount(gdImagePtr image) const;
+
+        bool write(gdImagePtr image, const char* filename);
+
+        bool open(const char* filename, gdImagePtr palette_image, int height);
+        bool writeRow(const unsigned char* indices);
+        bool close();
+
+    private:
+        void setImageFormat(gdImagePtr image);
+
+        Filter getFilter() const;
+
+        void packRow(const unsigned char* indices, unsigned char* output) const;
+
+        void filterScanline(
+            const unsigned char* row,
+            const unsigned char* prev,
+            unsigned char* output,
+            unsigned char* candidate
+        ) const;
+
+        void writeHeader(FILE* file, gdImagePtr image) const;
+
+        void getScanlines(
+            gdImagePtr image,
+            std::vector<unsigned char>& scanlines
+        ) const;
+
+        void filterRows(
+            const std::vector<unsigned char>& scanlines,
+            std::vector<unsigned char>& filtered,
+            int first_row,
+            int last_row
+        ) const;
+
+        void deflateToFile(int flush);
+
+        void compressSegment(
+            const std::vector<unsigned char>& filtered,
+            std::size_t start,
+            std::size_t end,
+            bool last,
+            std::vector<unsigned char>& output
+        ) const;
+
+        static void writeChunk(
+            FILE* file,
+            const char* type,
+            const unsigned char* data,
+            std::size_t length
+        );
+
+    private:
+        int compression_level_;
+        Filter filter_;
+        int threads_;
+
+        // Image format, set by setImageFormat()
+        int width_;
+        int height_;
+        int bit_depth_;
+        int color_type_;
+        std::size_t pixel_bytes_;
+        std::size_t row_bytes_;
+
+        bool verbose_;
+        std::ostream* error_stream_;
+
+        // Row streaming state, set by open()
+        FILE* file_;
+        std::string filename_;
+        z_stream stream_;
+        int rows_written_;
+        std::vector<unsigned char> row_;
+        std::vector<unsigned char> prev_row_;
+        std::vector<unsigned char> filtered_;
+        std::vector<unsigned char> candidate_;
+        std::vector<unsigned char> output_;
+};
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_PNG_WRITER_H)
+
+//------------------------------------------------------------------------------
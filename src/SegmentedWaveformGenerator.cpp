@@ -0,0 +1,602 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "SegmentedWaveformGenerator.h"
+#include "AudioFileReader.h"
+#include "AudioProcessor.h"
+#include "Streams.h"
+#include "ThreadUtil.h"
+#include "WaveformBuffer.h"
+#include "WaveformGenerator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+
+//------------------------------------------------------------------------------
+
+struct SegmentedWaveformGenerator::Segment
+{
+    int index;
+    boost::filesystem::path filename;
+
+    // Position of the segment in the concatenated stream, or the position
+    // assumed when decoding, if not yet known
+    long long start_frame;
+
+    // Length from the file header or cache, or -1 if not known until decoded
+    long long frame_count;
+
+    long long decoded_frame_count;
+
+    // Number of frames before the segment in its first point, which depends on
+    // the start position
+    int offset;
+
+    // True if the waveform data was decoded rather than read from the cache
+    bool decoded;
+
+    WaveformBuffer buffer;
+};
+
+//------------------------------------------------------------------------------
+
+const int MAX_SAMPLE = std::numeric_limits<short>::max();
+const int MIN_SAMPLE = std::numeric_limits<short>::min();
+
+//------------------------------------------------------------------------------
+
+// Generates the waveform data for one segment. If the segment does not start
+// on a point boundary, its first point is the remainder of the last point of
+// the previous segment, and is later merged with it.
+
+class SegmentProcessor : public AudioProcessor
+{
+    public:
+        SegmentProcessor(
+            WaveformBuffer& buffer,
+            const ScaleFactor& scale_factor,
+            long long start_frame,
+            std::ostream& errors) :
+            generator_(buffer, scale_factor),
+            start_frame_(start_frame),
+            frame_count_(0),
+            offset_(0)
+        {
+            generator_.setVerbose(false);
+            generator_.setErrorStream(errors);
+        }
+
+        SegmentProcessor(const SegmentProcessor&) = delete;
+        SegmentProcessor& operator=(const SegmentProcessor&) = delete;
+
+    public:
+        virtual bool init(const AudioStreamInfo& info, int buffer_size)
+        {
+            if (!generator_.init(info, buffer_size)) {
+                return false;
+            }
+
+            offset_ = static_cast<int>(start_frame_ % generator_.getSamplesPerPixel());
+
+            if (offset_ > 0) {
+                generator_.setPartialPoint(MAX_SAMPLE, MIN_SAMPLE, offset_);
+            }
+
+            return true;
+        }
+
+        virtual bool acceptsSampleFormat(SampleFormat format) const
+        {
+            return generator_.acceptsSampleFormat(format);
+        }
+
+        virtual bool process(const short* input_buffer, int input_frame_count)
+        {
+            frame_count_ += input_frame_count;
+
+            return generator_.process(input_buffer, input_frame_count);
+        }
+
+        virtual bool process(const int* input_buffer, int input_frame_count)
+        {
+            frame_count_ += input_frame_count;
+
+            return generator_.process(input_buffer, input_frame_count);
+        }
+
+        virtual bool process(const float* input_buffer, int input_frame_count)
+        {
+            frame_count_ += input_frame_count;
+
+            return generator_.process(input_buffer, input_frame_count);
+        }
+
+        virtual void done()
+        {
+            generator_.done();
+        }
+
+        long long getFrameCount() const { return frame_count_; }
+        int getOffset() const { return offset_; }
+
+    private:
+        WaveformGenerator generator_;
+        const long long start_frame_;
+        long long frame_count_;
+        int offset_;
+};
+
+//------------------------------------------------------------------------------
+
+SegmentedWaveformGenerator::SegmentedWaveformGenerator(
+    ReaderFactory create_reader,
+    const ScaleFactor& scale_factor,
+    const int threads) :
+    create_reader_(create_reader),
+    scale_factor_(scale_factor),
+    threads_(threads),
+    frame_count_(0)
+{
+    if (threads_ < 1) {
+        threads_ = static_cast<int>(std::thread::hardware_concurrency());
+
+        if (threads_ < 1) {
+            threads_ = 1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool SegmentedWaveformGenerator::readPlaylist(
+    const boost::filesystem::path& filename,
+    std::vector<boost::filesystem::path>& filenames)
+{
+    std::ifstream stream(filename.string().c_str());
+
+    if (!stream) {
+        error_stream << "Failed to read file: " << filename.string() << '\n';
+        return false;
+    }
+
+    const boost::filesystem::path directory = filename.parent_path();
+
+    std::string line;
+
+    while (std::getline(stream, line)) {
+        // Ignore surrounding whitespace, including '\r' in files with Windows
+        // line endings
+        const size_t begin = line.find_first_not_of(" \t\r");
+
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+
+        const size_t end = line.find_last_not_of(" \t\r");
+
+        boost::filesystem::path segment_filename = line.substr(begin, end - begin + 1);
+
+        if (segment_filename.is_relative()) {
+            segment_filename = directory / segment_filename;
+        }
+
+        filenames.push_back(segment_filename);
+    }
+
+    if (filenames.empty()) {
+        error_stream << "No audio files listed in playlist: "
+                     << filename.string() << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+static std::string getCacheFilename(
+    const boost::filesystem::path& directory,
+    const int index,
+    const char* ext)
+{
+    return (directory / (std::to_string(index) + ext)).string();
+}
+
+//------------------------------------------------------------------------------
+
+// Returns false if the segment is not in the cache, or the cached data is for
+// a different file, zoom level, or resolution. The data may be for a different
+// start position, which is checked once the start position is known.
+
+bool SegmentedWaveformGenerator::loadCachedSegment(
+    Segment& segment,
+    const int bits) const
+{
+    if (cache_directory_.empty()) {
+        return false;
+    }
+
+    const std::string data_filename =
+        getCacheFilename(cache_directory_, segment.index, ".dat");
+
+    std::ifstream stream(
+        getCacheFilename(cache_directory_, segment.index, ".txt").c_str()
+    );
+
+    std::string filename;
+    long long file_size;
+    long long modified_time;
+    long long offset;
+    long long frame_count;
+
+    if (!std::getline(stream, filename) ||
+        !(stream >> file_size >> modified_time >> offset >> frame_count) ||
+        filename != segment.filename.string() ||
+        !boost::filesystem::exists(data_filename)) {
+        return false;
+    }
+
+    boost::system::error_code error_code;
+
+    if (file_size != static_cast<long long>(
+            boost::filesystem::file_size(segment.filename, error_code)) ||
+        error_code ||
+        modified_time != static_cast<long long>(
+            boost::filesystem::last_write_time(segment.filename, error_code)) ||
+        error_code) {
+        return false;
+    }
+
+    WaveformBuffer& buffer = segment.buffer;
+
+    if (!buffer.load(data_filename.c_str())) {
+        return false;
+    }
+
+    const int samples_per_pixel = buffer.getSamplesPerPixel();
+
+    if (buffer.getBits() != bits ||
+        samples_per_pixel < 1 ||
+        samples_per_pixel != scale_factor_.getSamplesPerPixel(buffer.getSampleRate()) ||
+        offset < 0 ||
+        offset >= samples_per_pixel ||
+        buffer.getSize() !=
+            (offset + frame_count + samples_per_pixel - 1) / samples_per_pixel) {
+        return false;
+    }
+
+    segment.frame_count = frame_count;
+    segment.offset      = static_cast<int>(offset);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool SegmentedWaveformGenerator::saveCachedSegment(const Segment& segment) const
+{
+    boost::system::error_code error_code;
+    boost::filesystem::create_directories(cache_directory_, error_code);
+
+    const WaveformBuffer& buffer = segment.buffer;
+
+    if (!buffer.save(
+        getCacheFilename(cache_directory_, segment.index, ".dat").c_str(),
+        buffer.getBits()))
+    {
+        return false;
+    }
+
+    const std::string info_filename =
+        getCacheFilename(cache_directory_, segment.index, ".txt");
+
+    std::ofstream stream(info_filename.c_str());
+
+    stream << segment.filename.string() << '\n'
+           << boost::filesystem::file_size(segment.filename, error_code) << ' '
+           << boost::filesystem::last_write_time(segment.filename, error_code) << ' '
+           << segment.offset << ' '
+           << segment.frame_count << '\n';
+
+    if (!stream) {
+        error_stream << "Failed to write segment cache file: " << info_filename << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Reads the segment's length from the file header, if given. The file is
+// closed again, so that only the files being decoded are open at once.
+
+bool SegmentedWaveformGenerator::readFrameCount(Segment& segment) const
+{
+    std::unique_ptr<AudioFileReader> reader = create_reader_(segment.filename);
+    reader->setVerbose(false);
+
+    if (!reader->open(segment.filename.string().c_str())) {
+        return false;
+    }
+
+    segment.frame_count = reader->getFrameCount();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool SegmentedWaveformGenerator::decode(
+    Segment& segment,
+    std::ostream& errors) const
+{
+    // Replace any data decoded from a different start position
+    segment.buffer.setSize(0);
+
+    std::unique_ptr<AudioFileReader> reader = create_reader_(segment.filename);
+    reader->setVerbose(false);
+    reader->setErrorStream(errors);
+
+    if (!reader->open(segment.filename.string().c_str())) {
+        return false;
+    }
+
+    SegmentProcessor processor(
+        segment.buffer,
+        scale_factor_,
+        segment.start_frame,
+        errors
+    );
+
+    const bool success = reader->run(processor);
+
+    segment.decoded_frame_count = processor.getFrameCount();
+    segment.offset              = processor.getOffset();
+    segment.decoded             = true;
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+bool SegmentedWaveformGenerator::decodeSegments(const std::vector<Segment*>& segments)
+{
+    if (segments.empty()) {
+        return true;
+    }
+
+    const int thread_count = std::max(
+        std::min(threads_, static_cast<int>(segments.size())),
+        1
+    );
+
+    output_stream << "Decoding segments: " << segments.size()
+                  << "\nThreads: " << thread_count << std::endl;
+
+    const bool success = ThreadUtil::runTasks(
+        static_cast<int>(segments.size()),
+        thread_count,
+        [this, &segments](const int index, std::ostream& errors) {
+            return decode(*segments[static_cast<size_t>(index)], errors);
+        }
+    );
+
+    if (!success) {
+        return false;
+    }
+
+    for (Segment* segment : segments) {
+        // The start positions of later segments were computed from the length
+        // given in the file header, or from an earlier decode
+        if (segment->frame_count >= 0 &&
+            segment->decoded_frame_count != segment->frame_count) {
+            error_stream << "Segment length does not match file header: "
+                         << segment->filename.string() << '\n';
+            return false;
+        }
+
+        segment->frame_count = segment->decoded_frame_count;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Appends a segment's waveform data to buffer. If the segment does not start on
+// a point boundary, its first point is merged with the last point in buffer.
+
+static bool appendSegment(
+    WaveformBuffer& buffer,
+    const WaveformBuffer& segment_buffer,
+    const boost::filesystem::path& filename,
+    const long long start_frame)
+{
+    const long long size = segment_buffer.getSize();
+
+    if (size == 0) {
+        return true;
+    }
+
+    const int samples_per_pixel = segment_buffer.getSamplesPerPixel();
+
+    if (buffer.getSampleRate() == 0) {
+        buffer.setSampleRate(segment_buffer.getSampleRate());
+        buffer.setSamplesPerPixel(samples_per_pixel);
+    }
+    else if (segment_buffer.getSampleRate() != buffer.getSampleRate() ||
+             samples_per_pixel != buffer.getSamplesPerPixel()) {
+        error_stream << "Segment sample rate does not match previous segments: "
+                     << filename.string() << '\n';
+        return false;
+    }
+
+    long long index = 0;
+
+    if (start_frame % samples_per_pixel != 0 && buffer.getSize() > 0) {
+        const long long last = buffer.getSize() - 1;
+
+        buffer.setSamples(
+            last,
+            std::min(buffer.getMinSample(last), segment_buffer.getMinSample(0)),
+            std::max(buffer.getMaxSample(last), segment_buffer.getMaxSample(0))
+        );
+
+        index = 1;
+    }
+
+    buffer.reserve(buffer.getSize() + size - index);
+
+    for (; index < size; ++index) {
+        buffer.appendSamples(
+            segment_buffer.getMinSample(index),
+            segment_buffer.getMaxSample(index)
+        );
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// All segments are decoded in parallel. A segment's start position is known
+// before decoding only if the lengths of the segments before it are given in
+// their file headers or the cache. Otherwise, it is decoded from an assumed
+// start position, and if that gives a different offset from the point
+// boundaries, which the min and max values of its points depend on, it is
+// decoded again, in parallel with the other such segments, once the lengths
+// are known.
+
+bool SegmentedWaveformGenerator::generate(
+    const std::vector<boost::filesystem::path>& filenames,
+    WaveformBuffer& buffer)
+{
+    const int bits = buffer.getBits();
+
+    std::vector<std::unique_ptr<Segment>> segments;
+
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        std::unique_ptr<Segment> segment(new Segment);
+
+        segment->index               = static_cast<int>(i);
+        segment->filename            = filenames[i];
+        segment->start_frame         = 0;
+        segment->frame_count         = -1;
+        segment->decoded_frame_count = 0;
+        segment->offset              = 0;
+        segment->decoded             = false;
+
+        segment->buffer.setBits(bits);
+
+        segments.push_back(std::move(segment));
+    }
+
+    output_stream << "Generating waveform data from " << segments.size()
+                  << " segments..." << std::endl;
+
+    std::vector<Segment*> decode_segments;
+
+    // Start position of the next segment, or -1 if not known until decoded
+    long long start_frame = 0;
+
+    for (auto& segment : segments) {
+        segment->start_frame = std::max(start_frame, 0LL);
+
+        if (loadCachedSegment(*segment, bits)) {
+            output_stream << "Using cached waveform data: "
+                          << segment->filename.string() << '\n';
+        }
+        else {
+            if (!readFrameCount(*segment)) {
+                return false;
+            }
+
+            decode_segments.push_back(segment.get());
+        }
+
+        if (start_frame >= 0 && segment->frame_count >= 0) {
+            start_frame += segment->frame_count;
+        }
+        else {
+            start_frame = -1;
+        }
+    }
+
+    if (!decodeSegments(decode_segments)) {
+        return false;
+    }
+
+    // All lengths are now known, so decode again any segment whose offset
+    // was wrong
+    decode_segments.clear();
+
+    start_frame = 0;
+
+    for (auto& segment : segments) {
+        const int samples_per_pixel = segment->buffer.getSamplesPerPixel();
+
+        if (samples_per_pixel > 0 &&
+            segment->offset != start_frame % samples_per_pixel) {
+            decode_segments.push_back(segment.get());
+        }
+
+        segment->start_frame = start_frame;
+        start_frame += segment->frame_count;
+    }
+
+    if (!decodeSegments(decode_segments)) {
+        return false;
+    }
+
+    // Release each segment's data once added to the output
+    for (auto& segment : segments) {
+        if (segment->decoded &&
+            !cache_directory_.empty() &&
+            !saveCachedSegment(*segment)) {
+            return false;
+        }
+
+        if (!appendSegment(
+            buffer,
+            segment->buffer,
+            segment->filename,
+            segment->start_frame))
+        {
+            return false;
+        }
+
+        segment.reset();
+    }
+
+    frame_count_ = start_frame;
+
+    output_stream << "Generated " << buffer.getSize() << " points" << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_SEGMENTED_WAVEFORM_GENERATOR_H)
+#define INC_SEGMENTED_WAVEFORM_GENERATOR_H
+
+//------------------------------------------------------------------------------
+
+#include <boost/filesystem.hpp>
+
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+class AudioFileReader;
+class ScaleFactor;
+class WaveformBuffer;
+
+//------------------------------------------------------------------------------
+
+// Generates waveform data from a list of audio files (segments), as if they
+// were one continuous stream: a point that spans the end of one segment and
+// the start of the next has the min and max values of both.
+//
+// The segments are decoded in parallel. A segment whose start position isn't
+// known until the segments before it are decoded, as their lengths aren't
+// given in the file headers, is decoded again if it was decoded at the wrong
+// offset from the point boundaries. If a cache directory is set, the
+// waveform data for each segment is saved there and reused while the segment
+// file and its start position are unchanged, so adding a segment to the end
+// of the list only requires that segment to be decoded.
+
+class SegmentedWaveformGenerator
+{
+    public:
+        typedef std::unique_ptr<AudioFileReader> (*ReaderFactory)(
+            const boost::filesystem::path& filename
+        );
+
+        SegmentedWaveformGenerator(
+            ReaderFactory create_reader,
+            const ScaleFactor& scale_factor,
+            int threads
+        );
+
+        SegmentedWaveformGenerator(const SegmentedWaveformGenerator&) = delete;
+        SegmentedWaveformGenerator& operator=(const SegmentedWaveformGenerator&) = delete;
+
+    public:
+        void setCacheDirectory(const boost::filesystem::path& directory)
+        {
+            cache_directory_ = directory;
+        }
+
+        // Generates waveform data into buffer, at the buffer's resolution.
+        bool generate(
+            const std::vector<boost::filesystem::path>& filenames,
+            WaveformBuffer& buffer
+        );
+
+        // Returns the number of input frames in the segments, after generate().
+        long long getFrameCount() const { return frame_count_; }
+
+        // Reads a playlist (.m3u) file, which lists one file name per line.
+        // Blank lines and lines starting with '#' are ignored, and relative
+        // file names are relative to the playlist's directory.
+        static bool readPlaylist(
+            const boost::filesystem::path& filename,
+            std::vector<boost::filesystem::path>& filenames
+        );
+
+    private:
+        struct Segment;
+
+        bool loadCachedSegment(Segment& segment, int bits) const;
+        bool saveCachedSegment(const Segment& segment) const;
+
+        bool readFrameCount(Segment& segment) const;
+
+        bool decodeSegments(const std::vector<Segment*>& segments);
+
+        bool decode(Segment& segment, std::ostream& errors) const;
+
+    private:
+        ReaderFactory create_reader_;
+        const ScaleFactor& scale_factor_;
+        int threads_;
+        boost::filesystem::path cache_directory_;
+        long long frame_count_;
+};
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_SEGMENTED_WAVEFORM_GENERATOR_H)
+
+//------------------------------------------------------------------------------
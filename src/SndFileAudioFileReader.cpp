@@ -26,6 +26,7 @@
 #include "Streams.h"
 #include "nullptr.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
@@ -44,6 +45,35 @@ static void dumpInfo(std::ostream& stream, const SF_INFO& info)
 
 //------------------------------------------------------------------------------
 
+static SampleFormat getSampleFormat(const int format)
+{
+    switch (format & SF_FORMAT_SUBMASK) {
+        case SF_FORMAT_PCM_S8:
+        case SF_FORMAT_PCM_U8:
+            return SAMPLE_FORMAT_PCM_8;
+
+        case SF_FORMAT_PCM_16:
+            return SAMPLE_FORMAT_PCM_16;
+
+        case SF_FORMAT_PCM_24:
+            return SAMPLE_FORMAT_PCM_24;
+
+        case SF_FORMAT_PCM_32:
+            return SAMPLE_FORMAT_PCM_32;
+
+        case SF_FORMAT_FLOAT:
+            return SAMPLE_FORMAT_FLOAT;
+
+        case SF_FORMAT_DOUBLE:
+            return SAMPLE_FORMAT_DOUBLE;
+
+        default:
+            return SAMPLE_FORMAT_UNKNOWN;
+    }
+}
+
+//------------------------------------------------------------------------------
+
 SndFileAudioFileReader::SndFileAudioFileReader() :
     input_file_(nullptr)
 {
@@ -59,18 +89,27 @@ SndFileAudioFileReader::~SndFileAudioFileReader()
 
 //------------------------------------------------------------------------------
 
+long long SndFileAudioFileReader::getFrameCount() const
+{
+    return input_file_ != nullptr ? info_.frames : -1;
+}
+
+//------------------------------------------------------------------------------
+
 bool SndFileAudioFileReader::open(const char* input_filename)
 {
     input_file_ = sf_open(input_filename, SFM_READ, &info_);
 
     if (input_file_ != nullptr) {
-        output_stream << "Input file: " << input_filename << std::endl;
+        if (isVerbose()) {
+            output_stream << "Input file: " << input_filename << std::endl;
 
-        dumpInfo(output_stream, info_);
+            dumpInfo(output_stream, info_);
+        }
     }
     else {
-        error_stream << "Failed to read file: " << input_filename << '\n'
-                     << sf_strerror(input_file_) << '\n';
+        getErrorStream() << "Failed to read file: " << input_filename << '\n'
+                         << sf_strerror(input_file_) << '\n';
     }
 
     return input_file_ != nullptr;
@@ -94,24 +133,142 @@ bool SndFileAudioFileReader::run(AudioProcessor& processor)
         return false;
     }
 
+    return read(processor, info_.frames);
+}
+
+//------------------------------------------------------------------------------
+
+bool SndFileAudioFileReader::runRange(
+    AudioProcessor& processor,
+    const long long start_frame,
+    const long long frame_count)
+{
+    if (input_file_ == nullptr) {
+        return false;
+    }
+
+    if (!info_.seekable) {
+        return AudioFileReader::runRange(processor, start_frame, frame_count);
+    }
+
+    if (sf_seek(input_file_, start_frame, SEEK_SET) < 0) {
+        getErrorStream() << "Failed to seek to frame " << start_frame << '\n'
+                         << sf_strerror(input_file_) << '\n';
+        close();
+        return false;
+    }
+
+    const sf_count_t frames_remaining = std::max<sf_count_t>(
+        info_.frames - start_frame,
+        0
+    );
+
+    return read(processor, std::min<sf_count_t>(frame_count, frames_remaining));
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the format in which to pass samples from a file with the given
+// sample format to the processor: 32-bit integer for 24 and 32-bit files, and
+// float for floating point files, if the processor accepts them, so that
+// libsndfile doesn't convert them to 16-bit.
+
+static SampleFormat getProcessFormat(
+    const SampleFormat sample_format,
+    const AudioProcessor& processor)
+{
+    switch (sample_format) {
+        case SAMPLE_FORMAT_PCM_24:
+        case SAMPLE_FORMAT_PCM_32:
+            if (processor.acceptsSampleFormat(SAMPLE_FORMAT_PCM_32)) {
+                return SAMPLE_FORMAT_PCM_32;
+            }
+            break;
+
+        case SAMPLE_FORMAT_FLOAT:
+        case SAMPLE_FORMAT_DOUBLE:
+            if (processor.acceptsSampleFormat(SAMPLE_FORMAT_FLOAT)) {
+                return SAMPLE_FORMAT_FLOAT;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return SAMPLE_FORMAT_PCM_16;
+}
+
+//------------------------------------------------------------------------------
+
+static sf_count_t readFrames(SNDFILE* file, short* buffer, sf_count_t frames)
+{
+    return sf_readf_short(file, buffer, frames);
+}
+
+static sf_count_t readFrames(SNDFILE* file, int* buffer, sf_count_t frames)
+{
+    return sf_readf_int(file, buffer, frames);
+}
+
+static sf_count_t readFrames(SNDFILE* file, float* buffer, sf_count_t frames)
+{
+    return sf_readf_float(file, buffer, frames);
+}
+
+//------------------------------------------------------------------------------
+
+// Reads up to frame_count frames from the current position, or to the end of
+// the file.
+
+bool SndFileAudioFileReader::read(
+    AudioProcessor& processor,
+    const sf_count_t frame_count)
+{
+    AudioStreamInfo stream_info(info_.samplerate, info_.channels);
+
+    stream_info.frame_count       = frame_count;
+    stream_info.frame_count_exact = true;
+    stream_info.sample_format     = getSampleFormat(info_.format);
+    stream_info.seekable          = info_.seekable != 0;
+
+    switch (getProcessFormat(stream_info.sample_format, processor)) {
+        case SAMPLE_FORMAT_PCM_32:
+            return read<int>(processor, stream_info, frame_count);
+
+        case SAMPLE_FORMAT_FLOAT:
+            return read<float>(processor, stream_info, frame_count);
+
+        default:
+            return read<short>(processor, stream_info, frame_count);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+bool SndFileAudioFileReader::read(
+    AudioProcessor& processor,
+    const AudioStreamInfo& stream_info,
+    const sf_count_t frame_count)
+{
     const int BUFFER_SIZE = 16384;
 
-    short input_buffer[BUFFER_SIZE];
+    T input_buffer[BUFFER_SIZE];
 
-    sf_count_t frames_to_read = BUFFER_SIZE / info_.channels;
-    sf_count_t frames_read    = frames_to_read;
+    const sf_count_t buffer_frames = BUFFER_SIZE / info_.channels;
 
-    sf_count_t total_frames_read = 0;
+    sf_count_t frames_to_read = std::min(buffer_frames, frame_count);
 
-    bool success = true;
+    sf_count_t total_frames_read = 0;
 
-    success = processor.init(info_.samplerate, info_.channels, BUFFER_SIZE);
+    bool success = processor.init(stream_info, BUFFER_SIZE);
 
     if (success) {
-        showProgress(0, info_.frames);
+        showProgress(0, frame_count);
 
-        while (success && frames_read == frames_to_read) {
-            frames_read = sf_readf_short(
+        while (success && frames_to_read > 0) {
+            const sf_count_t frames_read = readFrames(
                 input_file_,
                 input_buffer,
                 frames_to_read
@@ -124,10 +281,21 @@ bool SndFileAudioFileReader::run(AudioProcessor& processor)
 
             total_frames_read += frames_read;
 
-            showProgress(total_frames_read, info_.frames);
+            showProgress(total_frames_read, frame_count);
+
+            // A short read means the end of the file. The last read before
+            // frame_count is reached may be shorter than the buffer, so this
+            // is checked before frames_to_read is updated.
+            if (frames_read < frames_to_read) {
+                break;
+            }
+
+            frames_to_read = std::min(buffer_frames, frame_count - total_frames_read);
         }
 
-        output_stream << "\nRead " << total_frames_read << " frames\n";
+        if (isVerbose()) {
+            output_stream << "\nRead " << total_frames_read << " frames\n";
+        }
 
         processor.done();
     }
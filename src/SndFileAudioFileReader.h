@@ -34,6 +34,10 @@
 
 //------------------------------------------------------------------------------
 
+struct AudioStreamInfo;
+
+//------------------------------------------------------------------------------
+
 class SndFileAudioFileReader : public AudioFileReader
 {
     public:
@@ -48,7 +52,24 @@ class SndFileAudioFileReader : public AudioFileReader
 
         virtual bool run(AudioProcessor& processor);
 
+        virtual bool runRange(
+            AudioProcessor& processor,
+            long long start_frame,
+            long long frame_count
+        );
+
+        virtual long long getFrameCount() const;
+
     private:
+        bool read(AudioProcessor& processor, sf_count_t frame_count);
+
+        template <typename T>
+        bool read(
+            AudioProcessor& processor,
+            const AudioStreamInfo& stream_info,
+            sf_count_t frame_count
+        );
+
         void close();
 
     private:
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2013, 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+
+#include "ThreadUtil.h"
+#include "Streams.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+namespace ThreadUtil {
+
+//------------------------------------------------------------------------------
+
+// Tasks are taken from a shared counter, so that threads that finish early
+// continue with the remaining tasks. Error messages are collected separately
+// for each thread so that messages from different threads don't interleave.
+
+bool runTasks(
+    const int task_count,
+    const int thread_count,
+    const std::function<bool(int index, std::ostream& errors)>& task)
+{
+    std::atomic<int> next_task(0);
+    std::atomic<bool> success(true);
+
+    std::vector<std::ostringstream> thread_errors(static_cast<size_t>(thread_count));
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < thread_count; ++i) {
+        std::ostream& errors = thread_errors[static_cast<size_t>(i)];
+
+        threads.push_back(std::thread([&task, &next_task, &success, &errors, task_count] {
+            while (success) {
+                const int index = next_task++;
+
+                if (index >= task_count) {
+                    break;
+                }
+
+                if (!task(index, errors)) {
+                    success = false;
+                }
+            }
+        }));
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& errors : thread_errors) {
+        error_stream << errors.str();
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace ThreadUtil
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,52 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2013, 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+
+#if !defined(INC_THREAD_UTIL_H)
+#define INC_THREAD_UTIL_H
+
+//------------------------------------------------------------------------------
+
+#include <functional>
+#include <iosfwd>
+
+//------------------------------------------------------------------------------
+
+namespace ThreadUtil {
+    // Calls task(index, errors) for each index from 0 to task_count - 1, on
+    // thread_count threads. Each thread writes its error messages to its own
+    // errors stream, and these are written to error_stream in thread order
+    // after the threads finish. Returns false if any task returns false, in
+    // which case no more tasks are started.
+    bool runTasks(
+        int task_count,
+        int thread_count,
+        const std::function<bool(int index, std::ostream& errors)>& task
+    );
+}
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_THREAD_UTIL_H)
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "TileRenderer.h"
+#include "GdImageRenderer.h"
+#include "Streams.h"
+#include "ThreadUtil.h"
+#include "WaveformBuffer.h"
+#include "WaveformRescaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+
+//------------------------------------------------------------------------------
+
+// Returns the start time of the tile that begins at the given pixel. The time
+// is rounded up if necessary, so that GdImageRenderer converts it back to the
+// same pixel rather than the one before.
+
+static double getTileStartTime(
+    const long long first_pixel,
+    const int sample_rate,
+    const int samples_per_pixel)
+{
+    double start_time = static_cast<double>(first_pixel) * samples_per_pixel / sample_rate;
+
+    while (static_cast<long long>(start_time * sample_rate / samples_per_pixel) < first_pixel) {
+        start_time = std::nextafter(start_time, std::numeric_limits<double>::max());
+    }
+
+    return start_time;
+}
+
+//------------------------------------------------------------------------------
+
+TileRenderer::TileRenderer(
+    const int tile_width,
+    const int tile_height,
+    const WaveformColors& colors,
+    const bool render_axis_labels,
+    const bool use_palette,
+    const int compression_level,
+    const PngWriter::Filter filter,
+    const int threads) :
+    tile_width_(tile_width),
+    tile_height_(tile_height),
+    colors_(colors),
+    render_axis_labels_(render_axis_labels),
+    use_palette_(use_palette),
+    compression_level_(compression_level),
+    filter_(filter),
+    threads_(threads)
+{
+    if (threads_ < 1) {
+        threads_ = static_cast<int>(std::thread::hardware_concurrency());
+
+        if (threads_ < 1) {
+            threads_ = 1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+int TileRenderer::getTileCount(const WaveformBuffer& buffer) const
+{
+    return static_cast<int>((buffer.getSize() + tile_width_ - 1) / tile_width_);
+}
+
+//------------------------------------------------------------------------------
+
+bool TileRenderer::render(
+    const WaveformBuffer& buffer,
+    const std::vector<int>& zoom_levels,
+    const boost::filesystem::path& output_path)
+{
+    if (tile_width_ < 1) {
+        error_stream << "Invalid tile width: minimum 1\n";
+        return false;
+    }
+
+    const int input_samples_per_pixel = buffer.getSamplesPerPixel();
+
+    for (const int zoom : zoom_levels) {
+        if (zoom < input_samples_per_pixel) {
+            error_stream << "Invalid zoom, minimum: " << input_samples_per_pixel << '\n';
+            return false;
+        }
+    }
+
+    // Rescale to all the zoom levels in one go, so that each can be computed
+    // from a more detailed one
+    std::vector<const WaveformBuffer*> zoom_buffers;
+
+    WaveformRescaler rescaler;
+
+    if (!rescaler.rescale(buffer, zoom_levels, zoom_buffers)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < zoom_levels.size(); ++i) {
+        const boost::filesystem::path directory = output_path / std::to_string(zoom_levels[i]);
+
+        boost::system::error_code error_code;
+        boost::filesystem::create_directories(directory, error_code);
+
+        if (error_code) {
+            error_stream << "Failed to create directory: " << directory << '\n'
+                         << error_code.message() << '\n';
+            return false;
+        }
+
+        const bool success = renderZoomLevel(*zoom_buffers[i], directory);
+
+        if (!success) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool TileRenderer::renderZoomLevel(
+    const WaveformBuffer& buffer,
+    const boost::filesystem::path& directory)
+{
+    const int tile_count = getTileCount(buffer);
+
+    const int thread_count = std::max(std::min(threads_, tile_count), 1);
+
+    output_stream << "Rendering tiles: " << directory.string()
+                  << "\nSamples per pixel: " << buffer.getSamplesPerPixel()
+                  << "\nTiles: " << tile_count
+                  << "\nThreads: " << thread_count << std::endl;
+
+    return ThreadUtil::runTasks(
+        tile_count,
+        thread_count,
+        [this, &buffer, &directory](const int tile, std::ostream& errors) {
+            return renderTile(buffer, directory, tile, errors);
+        }
+    );
+}
+
+//------------------------------------------------------------------------------
+
+bool TileRenderer::renderTile(
+    const WaveformBuffer& buffer,
+    const boost::filesystem::path& directory,
+    const int tile,
+    std::ostream& errors) const
+{
+    GdImageRenderer renderer;
+
+    // Avoid interleaving progress messages from each thread
+    renderer.setVerbose(false);
+    renderer.setErrorStream(errors);
+
+    const double start_time = getTileStartTime(
+        static_cast<long long>(tile) * tile_width_,
+        buffer.getSampleRate(),
+        buffer.getSamplesPerPixel()
+    );
+
+    const boost::filesystem::path filename =
+        directory / (std::to_string(tile) + ".png");
+
+    return renderer.create(
+        buffer,
+        start_time,
+        tile_width_,
+        tile_height_,
+        colors_,
+        render_axis_labels_,
+        use_palette_) &&
+        renderer.saveAsPng(
+            filename.string().c_str(),
+            compression_level_,
+            filter_,
+            1
+        );
+}
+
+//------------------------------------------------------------------------------
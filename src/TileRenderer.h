@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_TILE_RENDERER_H)
+#define INC_TILE_RENDERER_H
+
+//------------------------------------------------------------------------------
+
+#include "PngWriter.h"
+#include "WaveformColors.h"
+
+#include <boost/filesystem.hpp>
+
+#include <iosfwd>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+class WaveformBuffer;
+
+//------------------------------------------------------------------------------
+
+// Renders a waveform as a pyramid of fixed size PNG image tiles, for use by
+// zoomable viewers. Each zoom level is written to a separate directory, named
+// after the zoom level in samples per pixel, which contains one file per tile,
+// numbered from the start of the audio: {zoom}/{x}.png. The tiles for each
+// zoom level are rendered in parallel.
+
+class TileRenderer
+{
+    public:
+        TileRenderer(
+            int tile_width,
+            int tile_height,
+            const WaveformColors& colors,
+            bool render_axis_labels,
+            bool use_palette,
+            int compression_level,
+            PngWriter::Filter filter,
+            int threads
+        );
+
+        TileRenderer(const TileRenderer&) = delete;
+        TileRenderer& operator=(const TileRenderer&) = delete;
+
+    public:
+        bool render(
+            const WaveformBuffer& buffer,
+            const std::vector<int>& zoom_levels,
+            const boost::filesystem::path& output_path
+        );
+
+        int getTileCount(const WaveformBuffer& buffer) const;
+
+    private:
+        bool renderZoomLevel(
+            const WaveformBuffer& buffer,
+            const boost::filesystem::path& directory
+        );
+
+        bool renderTile(
+            const WaveformBuffer& buffer,
+            const boost::filesystem::path& directory,
+            int tile,
+            std::ostream& errors
+        ) const;
+
+    private:
+        int tile_width_;
+        int tile_height_;
+        WaveformColors colors_;
+        bool render_axis_labels_;
+        bool use_palette_;
+        int compression_level_;
+        PngWriter::Filter filter_;
+        int threads_;
+};
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_TILE_RENDERER_H)
+
+//------------------------------------------------------------------------------
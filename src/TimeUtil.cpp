@@ -31,21 +31,21 @@ namespace TimeUtil {
 
 //------------------------------------------------------------------------------
 
-int secondsToString(char* str, size_t size, int seconds)
+int secondsToString(char* str, size_t size, long long seconds)
 {
-    const int hours = seconds / 3600;
+    const long long hours = seconds / 3600;
 
     seconds -= hours * 3600;
 
-    const int minutes = seconds / 60;
+    const int minutes = static_cast<int>(seconds / 60);
 
     seconds -= minutes * 60;
 
     if (hours > 0) {
-        return snprintf(str, size, "%02d:%02d:%02d", hours, minutes, seconds);
+        return snprintf(str, size, "%02lld:%02d:%02d", hours, minutes, static_cast<int>(seconds));
     }
     else {
-        return snprintf(str, size, "%02d:%02d", minutes, seconds);
+        return snprintf(str, size, "%02d:%02d", minutes, static_cast<int>(seconds));
     }
 }
 
@@ -31,7 +31,7 @@
 //------------------------------------------------------------------------------
 
 namespace TimeUtil {
-    int secondsToString(char* str, size_t size, int seconds);
+    int secondsToString(char* str, size_t size, long long seconds);
 }
 
 //------------------------------------------------------------------------------
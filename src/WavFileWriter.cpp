@@ -26,14 +26,20 @@
 #include "nullptr.h"
 
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 //------------------------------------------------------------------------------
 
 WavFileWriter::WavFileWriter(const char* output_filename) :
     output_filename_(output_filename),
     output_file_(nullptr),
+    output_fd_(-1),
     channels_(0),
     buffer_size_(0)
 {
@@ -49,28 +55,44 @@ WavFileWriter::~WavFileWriter()
 //------------------------------------------------------------------------------
 
 bool WavFileWriter::init(
-    const int sample_rate,
-    const int channels,
+    const AudioStreamInfo& stream_info,
     const int buffer_size)
 {
     output_stream << "Output file: " << output_filename_ << std::endl;
 
-    channels_    = channels;
+    channels_    = stream_info.channels;
     buffer_size_ = buffer_size;
 
     output_buffer_.resize(buffer_size_);
 
+    output_fd_ = ::open(
+        output_filename_.c_str(),
+        O_RDWR | O_CREAT | O_TRUNC,
+        0666
+    );
+
+    if (output_fd_ == -1) {
+        error_stream << "Failed to write file: " << output_filename_ << '\n'
+                     << strerror(errno) << '\n';
+        return false;
+    }
+
+    if (stream_info.frame_count > 0) {
+        preallocate(stream_info.frame_count);
+    }
+
     SF_INFO info;
     memset(&info, 0, sizeof(info));
 
-    info.samplerate = sample_rate;
-    info.channels   = channels;
+    info.samplerate = stream_info.sample_rate;
+    info.channels   = stream_info.channels;
     info.format     = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
 
-    output_file_ = sf_open(output_filename_.c_str(), SFM_WRITE, &info);
+    output_file_ = sf_open_fd(output_fd_, SFM_WRITE, &info, SF_FALSE);
 
     if (output_file_ == nullptr) {
         error_stream << sf_strerror(output_file_) << '\n';
+        close();
     }
 
     return output_file_ != nullptr;
@@ -78,12 +100,47 @@ bool WavFileWriter::init(
 
 //------------------------------------------------------------------------------
 
+// Reserves disk space for the given number of frames without changing the
+// file size, so the file is written into contiguous blocks. The length may be
+// an estimate, so this is only a hint, and any space left unused is released
+// by close().
+
+void WavFileWriter::preallocate(const long long frame_count)
+{
+#if defined(FALLOC_FL_KEEP_SIZE)
+    const long long WAV_HEADER_SIZE = 44;
+
+    const long long size = WAV_HEADER_SIZE + frame_count * channels_ * 2;
+
+    // Not all file systems support this, so failure isn't an error.
+    fallocate(output_fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+#else
+    static_cast<void>(frame_count);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
 void WavFileWriter::close()
 {
     if (output_file_ != nullptr) {
         sf_close(output_file_);
         output_file_ = nullptr;
     }
+
+    if (output_fd_ != -1) {
+#if defined(FALLOC_FL_KEEP_SIZE)
+        // Free any preallocated space beyond the end of the file.
+        struct stat stat_buf;
+
+        if (fstat(output_fd_, &stat_buf) == 0) {
+            static_cast<void>(ftruncate(output_fd_, stat_buf.st_size));
+        }
+#endif
+
+        ::close(output_fd_);
+        output_fd_ = -1;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -46,8 +46,7 @@ class WavFileWriter : public AudioProcessor
 
     public:
         virtual bool init(
-            int sample_rate,
-            int channels,
+            const AudioStreamInfo& info,
             int buffer_size
         );
 
@@ -59,11 +58,13 @@ class WavFileWriter : public AudioProcessor
         virtual void done();
 
     private:
+        void preallocate(long long frame_count);
         void close();
 
     private:
         std::string output_filename_;
         SNDFILE* output_file_;
+        int output_fd_;
         int channels_;
         std::vector<short> output_buffer_;
         int buffer_size_;
@@ -22,8 +22,12 @@
 //------------------------------------------------------------------------------
 
 #include "WaveformBuffer.h"
+#include "BlockCodec.h"
+#include "GzipStreamBuf.h"
+#include "JsonReader.h"
 #include "Streams.h"
 
+#include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 
 #include <cstdint>
@@ -33,6 +37,7 @@
 #include <limits>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 //------------------------------------------------------------------------------
 
@@ -56,6 +61,16 @@ static uint32_t readUInt32(std::istream& stream)
 
 //------------------------------------------------------------------------------
 
+static uint64_t readUInt64(std::istream& stream)
+{
+    uint64_t value;
+    stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+
+    return value;
+}
+
+//------------------------------------------------------------------------------
+
 static int16_t readInt16(std::istream& stream)
 {
     int16_t value;
@@ -90,6 +105,20 @@ static void writeUInt32(std::ostream& stream, uint32_t value)
 
 //------------------------------------------------------------------------------
 
+static void writeUInt64(std::ostream& stream, uint64_t value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+
+static void writeInt16(std::ostream& stream, int16_t value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+
 static void writeInt8(std::ostream& stream, int8_t value)
 {
     stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
@@ -98,14 +127,21 @@ static void writeInt8(std::ostream& stream, int8_t value)
 //------------------------------------------------------------------------------
 
 template <typename T>
-static void writeVector(std::ostream& stream, const std::vector<T>& values)
+static void writeVector(std::ostream& stream, const ChunkedVector<T>& values)
 {
     static_assert(std::is_integral<T>::value, "T must be integral type");
 
-    stream.write(
-        reinterpret_cast<const char*>(&values[0]),
-        static_cast<std::streamsize>(values.size() * sizeof(T))
-    );
+    for (size_t i = 0; i < values.size(); ) {
+        const T* data;
+        const size_t count = values.getSpan(i, data);
+
+        stream.write(
+            reinterpret_cast<const char*>(data),
+            static_cast<std::streamsize>(count * sizeof(T))
+        );
+
+        i += count;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -126,27 +162,197 @@ static void reportWriteError(const char* filename, const char* message)
 
 //------------------------------------------------------------------------------
 
-const uint32_t FLAG_8_BIT = 0x00000001U;
+const uint32_t FLAG_8_BIT      = 0x00000001U;
+const uint32_t FLAG_COMPRESSED = 0x00000002U;
+const uint32_t FLAG_RMS        = 0x00000004U;
+
+// Version 2 data files are the same as version 1, except that the header has a
+// channels field after the length, and each point holds the min and max values
+// of each channel in turn. This is the same as version 2 of the format used
+// elsewhere, e.g., by waveform-data.js. Files are saved as version 1 unless
+// there is more than one channel, so they can still be read by software that
+// only supports version 1.
+//
+// Version 3 is the same as version 2, except that the length is 64-bit, and
+// the data may be compressed (FLAG_COMPRESSED). Compressed data is stored in
+// blocks of BLOCK_SIZE points, each holding the block's min values then max
+// values, of each channel in turn, encoded by BlockCodec. The header is
+// followed by the block size, then a table of the offsets of each block, and
+// of the end of the last block, from the end of the table, so that any range
+// of points can be read without reading the blocks before it. Files are saved
+// as version 3 only if compressed, or if the length doesn't fit in 32 bits.
+//
+// Version 4 is the same as version 3, except that each point may also have an
+// RMS value (FLAG_RMS). Uncompressed points are then stored as min, max, and
+// RMS values, and compressed blocks hold the RMS values after the max values.
+// Multi-channel data can't have RMS values.
+const int32_t MAX_VERSION = 4;
+
+const int32_t MAX_CHANNELS = 256;
+
+const uint32_t BLOCK_SIZE = 4096;
+
+// Largest encoded size of a block with the given number of points and series
+// of values
+static size_t getMaxBlockSize(const uint32_t block_size, const size_t series)
+{
+    return series * (3 + 2 * static_cast<size_t>(block_size));
+}
 
 //------------------------------------------------------------------------------
 
 WaveformBuffer::WaveformBuffer() :
     sample_rate_(0),
     samples_per_pixel_(0),
-    bits_(16)
+    bits_(16),
+    channels_(1),
+    has_rms_(false)
+{
+}
+
+//------------------------------------------------------------------------------
+
+void WaveformBuffer::setBits(const int bits)
+{
+    if (bits == bits_) {
+        return;
+    }
+
+    if (bits == 8) {
+        for (size_type i = 0; i < data_.size(); ++i) {
+            data_8_.push_back(static_cast<int8_t>(data_[i] / 256));
+        }
+
+        data_.clear();
+    }
+    else {
+        for (size_type i = 0; i < data_8_.size(); ++i) {
+            data_.push_back(static_cast<short>(data_8_[i] * 256));
+        }
+
+        data_8_.clear();
+    }
+
+    bits_ = bits;
+}
+
+//------------------------------------------------------------------------------
+
+// Shows the properties of waveform data loaded from a file, and checks they
+// are valid.
+
+static bool checkLoadedData(const WaveformBuffer& buffer, const char* filename)
 {
+    const int sample_rate       = buffer.getSampleRate();
+    const int samples_per_pixel = buffer.getSamplesPerPixel();
+
+    output_stream << "Sample rate: " << sample_rate << " Hz"
+                  << "\nBits: " << buffer.getBits()
+                  << "\nSamples per pixel: " << samples_per_pixel
+                  << "\nLength: " << buffer.getSize() << " points" << std::endl;
+
+    if (buffer.getChannels() > 1) {
+        output_stream << "Channels: " << buffer.getChannels() << std::endl;
+    }
+
+    bool success = true;
+
+    if (samples_per_pixel < 2) {
+        reportReadError(
+            filename,
+            boost::str(boost::format("Invalid samples per pixel: %1%, minimum 2") % samples_per_pixel).c_str()
+        );
+
+        success = false;
+    }
+    else if (sample_rate < 1) {
+        reportReadError(
+            filename,
+            boost::str(boost::format("Invalid sample rate: %1% Hz, minimum 1 Hz") % sample_rate).c_str()
+        );
+
+        success = false;
+    }
+
+    return success;
 }
 
 //------------------------------------------------------------------------------
 
 bool WaveformBuffer::load(const char* filename)
+{
+    return load(filename, 0, std::numeric_limits<long long>::max());
+}
+
+//------------------------------------------------------------------------------
+
+// Appends count points from the given block of compressed data, which holds
+// a series of values for each channel's min and max values, then the RMS
+// values, if any.
+
+void WaveformBuffer::appendBlock(
+    const std::vector<uint8_t>& block,
+    const int start,
+    const int count,
+    const int block_points)
+{
+    const size_t points = static_cast<size_t>(block_points);
+    const size_t series = 2 * static_cast<size_t>(channels_) + (has_rms_ ? 1 : 0);
+
+    std::vector<short> values(series * points);
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < series; ++i) {
+        const size_t size = BlockCodec::decode(
+            block.data() + offset, block.size() - offset, &values[i * points], block_points
+        );
+
+        if (size == 0) {
+            throw std::runtime_error("Invalid compressed data");
+        }
+
+        offset += size;
+    }
+
+    for (size_t i = static_cast<size_t>(start); i < static_cast<size_t>(start + count); ++i) {
+        for (size_t j = 0; j < 2 * static_cast<size_t>(channels_); ++j) {
+            const short value = values[j * points + i];
+
+            if (bits_ == 8) {
+                data_8_.push_back(static_cast<int8_t>(value));
+            }
+            else {
+                data_.push_back(value);
+            }
+        }
+
+        if (has_rms_) {
+            const short rms_value = values[(series - 1) * points + i];
+            rms_.push_back(bits_ == 8 ? static_cast<short>(rms_value * 256) : rms_value);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Only the data for the requested points is read: uncompressed data is read
+// from the start index, and compressed data from the block that contains it.
+
+bool WaveformBuffer::load(
+    const char* filename,
+    const long long start_index,
+    const long long count)
 {
     bool success = true;
 
     std::ifstream file;
     file.exceptions(std::ios::badbit | std::ios::failbit);
 
-    uint32_t size = 0;
+    uint64_t size = 0;
+
+    // Number of points to read
+    uint64_t expected_size = 0;
 
     try {
         file.open(filename, std::ios::in | std::ios::binary);
@@ -155,7 +361,7 @@ bool WaveformBuffer::load(const char* filename)
 
         const int32_t version = readInt32(file);
 
-        if (version != 1) {
+        if (version < 1 || version > MAX_VERSION) {
             reportReadError(
                 filename,
                 boost::str(boost::format("Cannot load data file version: %1%") % version).c_str()
@@ -169,52 +375,144 @@ bool WaveformBuffer::load(const char* filename)
         sample_rate_       = readInt32(file);
         samples_per_pixel_ = readInt32(file);
 
-        size = readUInt32(file);
+        size = version >= 3 ? readUInt64(file) : readUInt32(file);
 
-        if ((flags & FLAG_8_BIT) != 0) {
-            bits_ = 8;
+        const int32_t channels = version >= 2 ? readInt32(file) : 1;
 
-            for (uint32_t i = 0; i < size; ++i) {
-                int8_t min_value = readInt8(file);
-                data_.push_back(static_cast<int16_t>(min_value * 256));
+        if (channels < 1 || channels > MAX_CHANNELS) {
+            throw std::runtime_error("Invalid number of channels");
+        }
 
-                int8_t max_value = readInt8(file);
-                data_.push_back(static_cast<int16_t>(max_value * 256));
-            }
+        if (channels > 1 && (flags & FLAG_RMS) != 0) {
+            throw std::runtime_error("Invalid data file: RMS values with more than one channel");
         }
-        else {
-            bits_ = 16;
 
-            for (uint32_t i = 0; i < size; ++i) {
-                int16_t min_value = readInt16(file);
-                data_.push_back(min_value);
+        // The length is checked against the rest of the file before
+        // allocating memory for it, as the header may be corrupt
+        const std::streamoff header_end = file.tellg();
+        file.seekg(0, std::ios::end);
+        const uint64_t remaining = static_cast<uint64_t>(file.tellg() - header_end);
+        file.seekg(header_end);
 
-                int16_t max_value = readInt16(file);
-                data_.push_back(max_value);
+        const uint64_t start = static_cast<uint64_t>(std::max(start_index, 0LL));
+        const uint64_t end   = start + static_cast<uint64_t>(std::max(count, 0LL));
+
+        expected_size = start < size ? std::min(end, size) - start : 0;
+
+        setBits((flags & FLAG_8_BIT) != 0 ? 8 : 16);
+        setSize(0);
+        setChannels(channels);
+        setRms(version >= 4 && (flags & FLAG_RMS) != 0);
+
+        const uint64_t values_per_point =
+            2 * static_cast<uint64_t>(channels) + (has_rms_ ? 1 : 0);
+
+        if (version >= 3 && (flags & FLAG_COMPRESSED) != 0) {
+            const uint32_t block_size = readUInt32(file);
+
+            if (block_size < 1 || block_size > 1024 * 1024) {
+                throw std::runtime_error("Invalid block size");
             }
-        }
 
-        output_stream << "Sample rate: " << sample_rate_ << " Hz"
-                      << "\nBits: " << bits_
-                      << "\nSamples per pixel: " << samples_per_pixel_
-                      << "\nLength: " << getSize() << " points" << std::endl;
+            const uint64_t block_count = (size + block_size - 1) / block_size;
 
-        if (samples_per_pixel_ < 2) {
-            reportReadError(
-                filename,
-                boost::str(boost::format("Invalid samples per pixel: %1%, minimum 2") % samples_per_pixel_).c_str()
-            );
+            // The offsets table has block_count + 1 entries of 8 bytes, after
+            // the 4-byte block size
+            if (block_count >= (remaining - 4) / 8) {
+                throw std::runtime_error("Invalid data file: length too large for file size");
+            }
 
-            success = false;
+            std::vector<uint64_t> offsets(static_cast<size_t>(block_count + 1));
+
+            for (auto& offset : offsets) {
+                offset = readUInt64(file);
+            }
+
+            const std::streamoff data_start = file.tellg();
+
+            std::vector<uint8_t> block;
+
+            uint64_t index = start;
+
+            while (index < start + expected_size) {
+                const uint64_t block_index = index / block_size;
+                const uint64_t block_start = block_index * block_size;
+
+                const uint64_t offset      = offsets[static_cast<size_t>(block_index)];
+                const uint64_t next_offset = offsets[static_cast<size_t>(block_index + 1)];
+
+                if (next_offset <= offset ||
+                    next_offset - offset > getMaxBlockSize(block_size, values_per_point)) {
+                    throw std::runtime_error("Invalid compressed block offset");
+                }
+
+                block.resize(static_cast<size_t>(next_offset - offset));
+
+                file.seekg(data_start + static_cast<std::streamoff>(offset));
+                file.read(
+                    reinterpret_cast<char*>(&block[0]),
+                    static_cast<std::streamsize>(block.size())
+                );
+
+                const uint64_t block_end = std::min(block_start + block_size, size);
+                const uint64_t read_end  = std::min(block_end, start + expected_size);
+
+                appendBlock(
+                    block,
+                    static_cast<int>(index - block_start),
+                    static_cast<int>(read_end - index),
+                    static_cast<int>(block_end - block_start)
+                );
+
+                index = read_end;
+            }
         }
-        else if (sample_rate_ < 1) {
-            reportReadError(
-                filename,
-                boost::str(boost::format("Invalid sample rate: %1% Hz, minimum 1 Hz") % sample_rate_).c_str()
-            );
+        else if (bits_ == 8) {
+            reserve(static_cast<long long>(
+                std::min(expected_size, remaining / values_per_point)
+            ));
+
+            file.seekg(static_cast<std::streamoff>(start * values_per_point), std::ios::cur);
+
+            for (uint64_t i = 0; i < expected_size; ++i) {
+                for (int32_t channel = 0; channel < channels; ++channel) {
+                    int8_t min_value = readInt8(file);
+                    data_8_.push_back(min_value);
+
+                    int8_t max_value = readInt8(file);
+                    data_8_.push_back(max_value);
+                }
+
+                if (has_rms_) {
+                    int8_t rms_value = readInt8(file);
+                    rms_.push_back(static_cast<short>(rms_value * 256));
+                }
+            }
+        }
+        else {
+            reserve(static_cast<long long>(
+                std::min(expected_size, remaining / (values_per_point * 2))
+            ));
 
-            success = false;
+            file.seekg(static_cast<std::streamoff>(start * values_per_point * 2), std::ios::cur);
+
+            for (uint64_t i = 0; i < expected_size; ++i) {
+                for (int32_t channel = 0; channel < channels; ++channel) {
+                    int16_t min_value = readInt16(file);
+                    data_.push_back(min_value);
+
+                    int16_t max_value = readInt16(file);
+                    data_.push_back(max_value);
+                }
+
+                if (has_rms_) {
+                    int16_t rms_value = readInt16(file);
+                    rms_.push_back(rms_value);
+                }
+            }
         }
+
+        success = checkLoadedData(*this, filename);
     }
     catch (const std::ios::failure&) {
         if (!file.eof()) {
@@ -222,11 +520,15 @@ bool WaveformBuffer::load(const char* filename)
             success = false;
         }
     }
+    catch (const std::runtime_error& e) {
+        reportReadError(filename, e.what());
+        success = false;
+    }
 
-    const int actual_size = getSize();
+    const long long actual_size = getSize();
 
-    if (size != static_cast<uint32_t>(actual_size)) {
-        error_stream << "Expected " << size << " points, read "
+    if (expected_size != static_cast<uint64_t>(actual_size)) {
+        error_stream << "Expected " << expected_size << " points, read "
                      << actual_size << " min and max points\n";
     }
 
@@ -235,170 +537,1084 @@ bool WaveformBuffer::load(const char* filename)
 
 //------------------------------------------------------------------------------
 
-bool WaveformBuffer::save(const char* filename, const int bits) const
+// Reads one value of a JSON data array, which must be in the range given by
+// the bits field.
+
+static short readJsonValue(JsonReader& reader, const int bits)
 {
-    if (bits != 8 && bits != 16) {
-        error_stream << "Invalid bits: must be either 8 or 16\n";
-        return false;
-    }
+    const long long max_value = bits == 8 ?
+        std::numeric_limits<int8_t>::max() : std::numeric_limits<short>::max();
 
-    bool success = true;
+    const long long min_value = bits == 8 ?
+        std::numeric_limits<int8_t>::min() : std::numeric_limits<short>::min();
 
-    std::ofstream file;
-    file.exceptions(std::ios::badbit | std::ios::failbit);
+    const long long value = reader.readInteger();
 
-    try {
-        file.open(filename, std::ios::out | std::ios::binary);
+    if (value < min_value || value > max_value) {
+        throw std::runtime_error("Invalid JSON: data value out of range");
+    }
 
-        output_stream << "Writing output file: " << filename
-                      << "\nResolution: " << bits << " bits" << std::endl;
+    return static_cast<short>(value);
+}
 
-        const int32_t version = 1;
-        writeInt32(file, version);
+//------------------------------------------------------------------------------
 
-        uint32_t flags = 0;
+// Reads the data array of a JSON file, appending the values to the buffer.
+// The values are stored at the resolution given by the bits field, which must
+// come first. Multi-channel data is an array of arrays, one per channel.
 
-        if (bits == 8) {
-            flags |= FLAG_8_BIT;
-        }
+void WaveformBuffer::readJsonData(JsonReader& reader, const bool has_bits)
+{
+    if (!has_bits) {
+        throw std::runtime_error("Invalid JSON: bits must precede data");
+    }
 
-        writeUInt32(file, flags);
-        writeInt32(file, sample_rate_);
-        writeInt32(file, samples_per_pixel_);
+    reader.expect('[');
 
-        const int size = getSize();
+    if (reader.consume('[')) {
+        readJsonChannels(reader);
+        return;
+    }
 
-        writeUInt32(file, static_cast<uint32_t>(size));
+    if (reader.consume(']')) {
+        return;
+    }
 
-        if ((flags & FLAG_8_BIT) != 0) {
-            for (int i = 0; i < size; ++i) {
-                int8_t min_value = static_cast<int8_t>(getMinSample(i) / 256);
-                writeInt8(file, min_value);
+    do {
+        const short value = readJsonValue(reader, bits_);
 
-                int8_t max_value = static_cast<int8_t>(getMaxSample(i) / 256);
-                writeInt8(file, max_value);
-            }
+        if (bits_ == 8) {
+            data_8_.push_back(static_cast<int8_t>(value));
         }
         else {
-            writeVector(file, data_);
+            data_.push_back(value);
         }
     }
-    catch (const std::ios::failure&) {
-        reportWriteError(filename, strerror(errno));
-        success = false;
-    }
-    catch (const std::runtime_error& e) {
-        reportWriteError(filename, e.what());
-        success = false;
-    }
+    while (reader.consume(','));
 
-    return success;
+    reader.expect(']');
+
+    if ((bits_ == 8 ? data_8_.size() : data_.size()) % 2 != 0) {
+        throw std::runtime_error("Invalid JSON: odd number of data values");
+    }
 }
 
 //------------------------------------------------------------------------------
 
-bool WaveformBuffer::saveAsText(const char* filename, int bits) const
-{
-    bool success = true;
+// Reads the per-channel arrays of a multi-channel JSON data array, from just
+// after the opening bracket of the first channel's array, and interleaves
+// them into the buffer.
 
-    std::ofstream file;
-    file.exceptions(std::ios::badbit | std::ios::failbit);
+void WaveformBuffer::readJsonChannels(JsonReader& reader)
+{
+    std::vector<std::vector<short>> channels;
 
-    try {
-        file.open(filename);
+    do {
+        if (!channels.empty()) {
+            reader.expect('[');
+        }
 
-        output_stream << "Writing output file: " << filename << std::endl;
+        channels.emplace_back();
+        std::vector<short>& values = channels.back();
 
-        const int size = getSize();
+        if (!reader.consume(']')) {
+            do {
+                values.push_back(readJsonValue(reader, bits_));
+            }
+            while (reader.consume(','));
 
-        if (bits == 8) {
-            for (int i = 0; i < size; ++i) {
-                const int min_value = getMinSample(i) / 256;
-                const int max_value = getMaxSample(i) / 256;
+            reader.expect(']');
+        }
 
-                file << min_value << ',' << max_value<< '\n';
-            }
+        if (values.size() % 2 != 0) {
+            throw std::runtime_error("Invalid JSON: odd number of data values");
         }
-        else {
-            for (int i = 0; i < size; ++i) {
-                file << getMinSample(i) << ','
-                     << getMaxSample(i) << '\n';
-            }
+
+        if (values.size() != channels.front().size()) {
+            throw std::runtime_error("Invalid JSON: channel data lengths differ");
         }
     }
-    catch (const std::ios::failure&) {
-        reportWriteError(filename, strerror(errno));
-        success = false;
+    while (reader.consume(','));
+
+    reader.expect(']');
+
+    if (channels.size() > static_cast<size_t>(MAX_CHANNELS)) {
+        throw std::runtime_error("Invalid JSON: too many channels");
     }
 
-    return success;
+    const size_t size = channels.front().size() / 2;
+
+    setSize(0);
+    setChannels(static_cast<int>(channels.size()));
+    reserve(static_cast<long long>(size));
+
+    for (size_t i = 0; i < size; ++i) {
+        for (const std::vector<short>& values : channels) {
+            if (bits_ == 8) {
+                data_8_.push_back(static_cast<int8_t>(values[2 * i]));
+                data_8_.push_back(static_cast<int8_t>(values[2 * i + 1]));
+            }
+            else {
+                data_.push_back(values[2 * i]);
+                data_.push_back(values[2 * i + 1]);
+            }
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
 
-static void writeAsJsonArray(
-    std::ostream& stream,
-    const std::vector<short>& data,
-    int divisor)
+// Reads the rms array of a JSON file, which has one value per point, at the
+// resolution given by the bits field.
+
+void WaveformBuffer::readJsonRms(JsonReader& reader, const bool has_bits)
 {
-    auto i = data.begin();
+    if (!has_bits) {
+        throw std::runtime_error("Invalid JSON: bits must precede rms");
+    }
 
-    stream << '[';
+    const long long max_value = bits_ == 8 ?
+        std::numeric_limits<int8_t>::max() : std::numeric_limits<short>::max();
+
+    const int multiplier = bits_ == 8 ? 256 : 1;
+
+    has_rms_ = true;
+    rms_.clear();
+
+    reader.expect('[');
 
-    if (i != data.end()) {
-        stream << (*i / divisor);
-        ++i;
+    if (reader.consume(']')) {
+        return;
     }
 
-    for (; i != data.end(); ++i) {
-        stream << ',' << (*i / divisor);
+    do {
+        const long long value = reader.readInteger();
+
+        if (value < 0 || value > max_value) {
+            throw std::runtime_error("Invalid JSON: rms value out of range");
+        }
+
+        rms_.push_back(static_cast<short>(value * multiplier));
     }
+    while (reader.consume(','));
 
-    stream << ']';
+    reader.expect(']');
 }
 
 //------------------------------------------------------------------------------
 
-bool WaveformBuffer::saveAsJson(const char* filename, const int bits) const
+// Loads a waveform data file in the format written by saveAsJson. Fields may
+// be in any order, except that bits must come before data, and unknown
+// fields are ignored. If present, the channels field must match the data.
+
+bool WaveformBuffer::loadJson(const char* filename)
 {
-    if (bits != 8 && bits != 16) {
-        error_stream << "Invalid bits: must be either 8 or 16\n";
+    bool success = true;
+
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+    if (!file.is_open()) {
+        reportReadError(filename, strerror(errno));
         return false;
     }
 
-    bool success = true;
+    output_stream << "Reading waveform data file: " << filename << std::endl;
 
-    std::ofstream file;
-    file.exceptions(std::ios::badbit | std::ios::failbit);
+    long long length = 0;
+    long long channels = 0;
+
+    setBits(16);
+    setSize(0);
+    setChannels(1);
+    setRms(false);
 
     try {
-        file.open(filename);
+        JsonReader reader(file);
+
+        bool has_bits = false;
+
+        reader.expect('{');
+
+        if (!reader.consume('}')) {
+            do {
+                const std::string name = reader.readString();
+                reader.expect(':');
+
+                if (name == "sample_rate") {
+                    sample_rate_ = static_cast<int>(reader.readInteger());
+                }
+                else if (name == "samples_per_pixel") {
+                    samples_per_pixel_ = static_cast<int>(reader.readInteger());
+                }
+                else if (name == "bits") {
+                    const long long bits = reader.readInteger();
+
+                    if (bits != 8 && bits != 16) {
+                        throw std::runtime_error("Invalid bits: must be either 8 or 16");
+                    }
+
+                    setBits(static_cast<int>(bits));
+                    setSize(0);
+
+                    has_bits = true;
+                }
+                else if (name == "length") {
+                    length = reader.readInteger();
+                }
+                else if (name == "channels") {
+                    channels = reader.readInteger();
+                }
+                else if (name == "data") {
+                    readJsonData(reader, has_bits);
+                }
+                else if (name == "rms") {
+                    readJsonRms(reader, has_bits);
+                }
+                else {
+                    reader.skipValue();
+                }
+            }
+            while (reader.consume(','));
 
-        output_stream << "Writing output file: " << filename << std::endl;
+            reader.expect('}');
+        }
 
-        const int size = getSize();
+        if (!reader.atEnd()) {
+            throw std::runtime_error("Invalid JSON: unexpected data after object");
+        }
 
-        file << "{\"sample_rate\":" << sample_rate_
-             << ",\"samples_per_pixel\":" << samples_per_pixel_
-             << ",\"bits\":" << bits
-             << ",\"length\":" << size
-             << ",\"data\":";
+        if (channels != 0 && channels != channels_) {
+            throw std::runtime_error("Invalid JSON: channels and data don't match");
+        }
 
-        if (bits == 8) {
-            writeAsJsonArray(file, data_, 256);
+        if (has_rms_ && channels_ > 1) {
+            throw std::runtime_error("Invalid JSON: rms values with more than one channel");
         }
-        else {
-            writeAsJsonArray(file, data_, 1);
+
+        if (has_rms_ && static_cast<long long>(rms_.size()) != getSize()) {
+            throw std::runtime_error("Invalid JSON: rms and data lengths differ");
         }
 
-        file << "}\n";
+        success = checkLoadedData(*this, filename);
     }
-    catch (const std::ios::failure&) {
-        reportWriteError(filename, strerror(errno));
+    catch (const std::runtime_error& e) {
+        reportReadError(filename, e.what());
         success = false;
     }
 
+    const long long actual_size = getSize();
+
+    if (length != actual_size) {
+        error_stream << "Expected " << length << " points, read "
+                     << actual_size << " min and max points\n";
+    }
+
     return success;
 }
 
 //------------------------------------------------------------------------------
+
+// Writes the block size, offsets table, and compressed blocks of a version 3
+// data file. The offsets are only known once each block is encoded, so the
+// table is written after the blocks.
+
+void WaveformBuffer::writeBlocks(std::ostream& stream, const int bits) const
+{
+    const long long size = getSize();
+    const long long block_size = BLOCK_SIZE;
+    const long long block_count = (size + block_size - 1) / block_size;
+
+    writeUInt32(stream, BLOCK_SIZE);
+
+    const std::streampos table_start = stream.tellp();
+
+    for (long long i = 0; i <= block_count; ++i) {
+        writeUInt64(stream, 0);
+    }
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(static_cast<size_t>(block_count + 1));
+
+    std::vector<short> min_values;
+    std::vector<short> max_values;
+    std::vector<short> rms_values;
+    std::vector<uint8_t> block;
+
+    uint64_t offset = 0;
+
+    for (long long block_start = 0; block_start < size; block_start += block_size) {
+        const long long block_end = std::min(block_start + block_size, size);
+        const int count = static_cast<int>(block_end - block_start);
+
+        block.clear();
+
+        for (int channel = 0; channel < channels_; ++channel) {
+            min_values.clear();
+            max_values.clear();
+
+            for (long long i = block_start; i < block_end; ++i) {
+                const short min_value = getMinSample(channel, i);
+                const short max_value = getMaxSample(channel, i);
+
+                min_values.push_back(bits == 8 ? static_cast<short>(min_value / 256) : min_value);
+                max_values.push_back(bits == 8 ? static_cast<short>(max_value / 256) : max_value);
+            }
+
+            BlockCodec::encode(&min_values[0], count, block);
+            BlockCodec::encode(&max_values[0], count, block);
+        }
+
+        if (has_rms_) {
+            rms_values.clear();
+
+            for (long long i = block_start; i < block_end; ++i) {
+                const short rms_value = getRmsSample(i);
+                rms_values.push_back(bits == 8 ? static_cast<short>(rms_value / 256) : rms_value);
+            }
+
+            BlockCodec::encode(&rms_values[0], count, block);
+        }
+
+        stream.write(
+            reinterpret_cast<const char*>(&block[0]),
+            static_cast<std::streamsize>(block.size())
+        );
+
+        offsets.push_back(offset);
+        offset += block.size();
+    }
+
+    offsets.push_back(offset);
+
+    stream.seekp(table_start);
+
+    for (const uint64_t block_offset : offsets) {
+        writeUInt64(stream, block_offset);
+    }
+
+    stream.seekp(0, std::ios::end);
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformBuffer::save(
+    const char* filename,
+    const int bits,
+    const bool compress) const
+{
+    if (bits != 8 && bits != 16) {
+        error_stream << "Invalid bits: must be either 8 or 16\n";
+        return false;
+    }
+
+    bool success = true;
+
+    std::ofstream file;
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+
+    try {
+        file.open(filename, std::ios::out | std::ios::binary);
+
+        output_stream << "Writing output file: " << filename
+                      << "\nResolution: " << bits << " bits" << std::endl;
+
+        const long long size = getSize();
+
+        const int32_t version =
+            has_rms_ ? 4 :
+            compress || size > std::numeric_limits<uint32_t>::max() ? 3 :
+            channels_ > 1 ? 2 : 1;
+
+        writeInt32(file, version);
+
+        uint32_t flags = 0;
+
+        if (bits == 8) {
+            flags |= FLAG_8_BIT;
+        }
+
+        if (compress) {
+            flags |= FLAG_COMPRESSED;
+        }
+
+        if (has_rms_) {
+            flags |= FLAG_RMS;
+        }
+
+        writeUInt32(file, flags);
+        writeInt32(file, sample_rate_);
+        writeInt32(file, samples_per_pixel_);
+
+        if (version >= 3) {
+            writeUInt64(file, static_cast<uint64_t>(size));
+        }
+        else {
+            writeUInt32(file, static_cast<uint32_t>(size));
+        }
+
+        if (version >= 2) {
+            writeInt32(file, channels_);
+        }
+
+        if (compress) {
+            writeBlocks(file, bits);
+        }
+        else if (has_rms_) {
+            for (long long i = 0; i < size; ++i) {
+                if (bits == 8) {
+                    writeInt8(file, static_cast<int8_t>(getMinSample(i) / 256));
+                    writeInt8(file, static_cast<int8_t>(getMaxSample(i) / 256));
+                    writeInt8(file, static_cast<int8_t>(getRmsSample(i) / 256));
+                }
+                else {
+                    writeInt16(file, getMinSample(i));
+                    writeInt16(file, getMaxSample(i));
+                    writeInt16(file, getRmsSample(i));
+                }
+            }
+        }
+        else if (bits == bits_) {
+            if (bits_ == 8) {
+                writeVector(file, data_8_);
+            }
+            else {
+                writeVector(file, data_);
+            }
+        }
+        else if (bits == 8) {
+            for (long long i = 0; i < size; ++i) {
+                for (int channel = 0; channel < channels_; ++channel) {
+                    int8_t min_value = static_cast<int8_t>(getMinSample(channel, i) / 256);
+                    writeInt8(file, min_value);
+
+                    int8_t max_value = static_cast<int8_t>(getMaxSample(channel, i) / 256);
+                    writeInt8(file, max_value);
+                }
+            }
+        }
+        else {
+            for (long long i = 0; i < size; ++i) {
+                for (int channel = 0; channel < channels_; ++channel) {
+                    writeInt16(file, getMinSample(channel, i));
+                    writeInt16(file, getMaxSample(channel, i));
+                }
+            }
+        }
+    }
+    catch (const std::ios::failure&) {
+        reportWriteError(filename, strerror(errno));
+        success = false;
+    }
+    catch (const std::runtime_error& e) {
+        reportWriteError(filename, e.what());
+        success = false;
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+// Writes the buffer's points to an existing data file, from the given point
+// index in the file, which must be no more than the file's length, and sets
+// the length in the header to the end of the written points. The file must
+// have the same sample rate, scale, and resolution as the buffer. Only the
+// points written and the header are changed, so growing a large file is
+// quick.
+
+bool WaveformBuffer::appendToFile(
+    const char* filename,
+    const long long start_index) const
+{
+    bool success = true;
+
+    std::fstream file;
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+
+    const long long length = start_index + getSize();
+
+    try {
+        file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+
+        output_stream << "Appending to output file: " << filename
+                      << "\nStart index: " << start_index << std::endl;
+
+        const int32_t version = readInt32(file);
+
+        if (version < 1 || version > MAX_VERSION) {
+            reportWriteError(
+                filename,
+                boost::str(boost::format("Cannot append to data file version: %1%") % version).c_str()
+            );
+
+            return false;
+        }
+
+        const uint32_t flags            = readUInt32(file);
+
+        if ((flags & FLAG_COMPRESSED) != 0) {
+            reportWriteError(filename, "Cannot append to a compressed data file");
+            return false;
+        }
+
+        if ((flags & FLAG_RMS) != 0 || has_rms_) {
+            reportWriteError(filename, "Cannot append to a data file with RMS values");
+            return false;
+        }
+
+        const int32_t sample_rate       = readInt32(file);
+        const int32_t samples_per_pixel = readInt32(file);
+
+        const std::streamoff length_position = file.tellg();
+
+        const uint64_t file_length = version >= 3 ? readUInt64(file) : readUInt32(file);
+        const int32_t channels     = version >= 2 ? readInt32(file) : 1;
+
+        if (channels != 1 || channels_ > 1) {
+            reportWriteError(filename, "Cannot append to a multi-channel data file");
+            return false;
+        }
+
+        const int bits = (flags & FLAG_8_BIT) != 0 ? 8 : 16;
+
+        if (sample_rate != sample_rate_ ||
+            samples_per_pixel != samples_per_pixel_ ||
+            bits != bits_) {
+            reportWriteError(filename, "Data file does not match waveform data");
+            return false;
+        }
+
+        if (start_index < 0 || static_cast<uint64_t>(start_index) > file_length) {
+            reportWriteError(filename, "Start index is beyond the end of the data file");
+            return false;
+        }
+
+        if (version < 3 && length > std::numeric_limits<uint32_t>::max()) {
+            reportWriteError(
+                filename,
+                boost::str(boost::format("Too many points for a version %1% data file") % version).c_str()
+            );
+
+            return false;
+        }
+
+        const std::streamoff header_size = file.tellg();
+
+        file.seekp(header_size + start_index * 2 * (bits_ / 8));
+
+        if (bits_ == 8) {
+            writeVector(file, data_8_);
+        }
+        else {
+            writeVector(file, data_);
+        }
+
+        file.seekp(length_position);
+
+        if (version >= 3) {
+            writeUInt64(file, static_cast<uint64_t>(length));
+        }
+        else {
+            writeUInt32(file, static_cast<uint32_t>(length));
+        }
+
+        file.close();
+
+        // Remove any points left after the ones written
+        if (static_cast<uint64_t>(length) < file_length) {
+            boost::filesystem::resize_file(
+                filename,
+                static_cast<uintmax_t>(header_size + length * 2 * (bits_ / 8))
+            );
+        }
+    }
+    catch (const std::ios::failure&) {
+        reportWriteError(filename, strerror(errno));
+        success = false;
+    }
+    catch (const boost::filesystem::filesystem_error& e) {
+        reportWriteError(filename, e.what());
+        success = false;
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+static bool isGzipFilename(const char* filename)
+{
+    return boost::filesystem::path(filename).extension() == ".gz";
+}
+
+//------------------------------------------------------------------------------
+
+// Opens a text output file and calls write() to write its contents. If the
+// file name ends in .gz, the output is gzip compressed as it is written.
+
+template <typename Callback>
+static bool writeTextFile(
+    const char* filename,
+    const int compression_level,
+    Callback write)
+{
+    bool success = true;
+
+    std::ofstream file;
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+
+    try {
+        const bool gzip = isGzipFilename(filename);
+
+        file.open(filename, gzip ? std::ios::out | std::ios::binary : std::ios::out);
+
+        output_stream << "Writing output file: " << filename << std::endl;
+
+        if (gzip) {
+            GzipStreamBuf buffer(file, compression_level);
+
+            std::ostream stream(&buffer);
+            stream.exceptions(std::ios::badbit | std::ios::failbit);
+
+            write(stream);
+
+            stream.flush();
+            buffer.finish();
+        }
+        else {
+            write(file);
+        }
+    }
+    catch (const std::ios::failure&) {
+        reportWriteError(filename, strerror(errno));
+        success = false;
+    }
+    catch (const std::runtime_error& e) {
+        reportWriteError(filename, e.what());
+        success = false;
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformBuffer::saveAsText(
+    const char* filename,
+    const int bits,
+    const int compression_level) const
+{
+    return writeTextFile(filename, compression_level, [&](std::ostream& file) {
+        const long long size = getSize();
+
+        if (bits == 8) {
+            for (long long i = 0; i < size; ++i) {
+                for (int channel = 0; channel < channels_; ++channel) {
+                    const int min_value = getMinSample(channel, i) / 256;
+                    const int max_value = getMaxSample(channel, i) / 256;
+
+                    if (channel > 0) {
+                        file << ',';
+                    }
+
+                    file << min_value << ',' << max_value;
+                }
+
+                if (has_rms_) {
+                    file << ',' << getRmsSample(i) / 256;
+                }
+
+                file << '\n';
+            }
+        }
+        else {
+            for (long long i = 0; i < size; ++i) {
+                for (int channel = 0; channel < channels_; ++channel) {
+                    if (channel > 0) {
+                        file << ',';
+                    }
+
+                    file << getMinSample(channel, i) << ','
+                         << getMaxSample(channel, i);
+                }
+
+                if (has_rms_) {
+                    file << ',' << getRmsSample(i);
+                }
+
+                file << '\n';
+            }
+        }
+    });
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+static void writeAsJsonArray(
+    std::ostream& stream,
+    const ChunkedVector<T>& data,
+    int multiplier,
+    int divisor)
+{
+    stream << '[';
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (i > 0) {
+            stream << ',';
+        }
+
+        stream << (static_cast<int>(data[i]) * multiplier / divisor);
+    }
+
+    stream << ']';
+}
+
+//------------------------------------------------------------------------------
+
+// Writes one channel's min and max values from interleaved multi-channel
+// data.
+
+template <typename T>
+static void writeChannelAsJsonArray(
+    std::ostream& stream,
+    const ChunkedVector<T>& data,
+    size_t channel,
+    size_t channels,
+    int multiplier,
+    int divisor)
+{
+    stream << '[';
+
+    for (size_t i = 2 * channel; i + 1 < data.size(); i += 2 * channels) {
+        if (i > 2 * channel) {
+            stream << ',';
+        }
+
+        stream << (static_cast<int>(data[i]) * multiplier / divisor) << ','
+               << (static_cast<int>(data[i + 1]) * multiplier / divisor);
+    }
+
+    stream << ']';
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformBuffer::saveAsJson(
+    const char* filename,
+    const int bits,
+    const int compression_level) const
+{
+    if (bits != 8 && bits != 16) {
+        error_stream << "Invalid bits: must be either 8 or 16\n";
+        return false;
+    }
+
+    return writeTextFile(filename, compression_level, [&](std::ostream& file) {
+        const long long size = getSize();
+
+        file << "{\"sample_rate\":" << sample_rate_
+             << ",\"samples_per_pixel\":" << samples_per_pixel_
+             << ",\"bits\":" << bits
+             << ",\"length\":" << size;
+
+        if (channels_ > 1) {
+            file << ",\"channels\":" << channels_ << ",\"data\":[";
+
+            for (int channel = 0; channel < channels_; ++channel) {
+                if (channel > 0) {
+                    file << ',';
+                }
+
+                const size_t index = static_cast<size_t>(channel);
+                const size_t count = static_cast<size_t>(channels_);
+
+                if (bits_ == 8) {
+                    writeChannelAsJsonArray(file, data_8_, index, count, bits == 8 ? 1 : 256, 1);
+                }
+                else {
+                    writeChannelAsJsonArray(file, data_, index, count, 1, bits == 8 ? 256 : 1);
+                }
+            }
+
+            file << ']';
+        }
+        else if (bits_ == 8) {
+            file << ",\"data\":";
+            writeAsJsonArray(file, data_8_, bits == 8 ? 1 : 256, 1);
+        }
+        else {
+            file << ",\"data\":";
+            writeAsJsonArray(file, data_, 1, bits == 8 ? 256 : 1);
+        }
+
+        if (has_rms_) {
+            file << ",\"rms\":";
+            writeAsJsonArray(file, rms_, 1, bits == 8 ? 256 : 1);
+        }
+
+        file << "}\n";
+    });
+}
+
+//------------------------------------------------------------------------------
+
+// Writes the waveform data, converted from stored_bits to bits, as interleaved
+// min and max values in little-endian byte order. Data stored at the output
+// resolution is written a chunk at a time, without formatting each value.
+
+template <typename T, typename U>
+static void writeConvertedVector(
+    std::ostream& stream,
+    const ChunkedVector<U>& values,
+    int multiplier,
+    int divisor)
+{
+    std::vector<T> converted;
+
+    for (size_t i = 0; i < values.size(); ) {
+        const U* data;
+        const size_t count = values.getSpan(i, data);
+
+        converted.resize(count);
+
+        for (size_t j = 0; j < count; ++j) {
+            converted[j] = static_cast<T>(static_cast<int>(data[j]) * multiplier / divisor);
+        }
+
+        stream.write(
+            reinterpret_cast<const char*>(&converted[0]),
+            static_cast<std::streamsize>(count * sizeof(T))
+        );
+
+        i += count;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Writes an unsigned integer in big-endian byte order, as used by both
+// MessagePack and CBOR.
+
+static void writeBigEndian(std::ostream& stream, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; --i) {
+        stream.put(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Encodes the parts of a waveform data object in MessagePack format. The data
+// is a bin value holding the int8 or int16 values.
+
+struct MsgPackEncoder
+{
+    static void writeMap(std::ostream& stream, int size)
+    {
+        stream.put(static_cast<char>(0x80 | size));
+    }
+
+    static void writeString(std::ostream& stream, const char* value)
+    {
+        const size_t length = strlen(value);
+
+        stream.put(static_cast<char>(0xa0 | length));
+        stream.write(value, static_cast<std::streamsize>(length));
+    }
+
+    static void writeUInt(std::ostream& stream, uint64_t value)
+    {
+        if (value < 0x80) {
+            stream.put(static_cast<char>(value));
+        }
+        else if (value <= std::numeric_limits<uint8_t>::max()) {
+            stream.put(static_cast<char>(0xcc));
+            writeBigEndian(stream, value, 1);
+        }
+        else if (value <= std::numeric_limits<uint16_t>::max()) {
+            stream.put(static_cast<char>(0xcd));
+            writeBigEndian(stream, value, 2);
+        }
+        else if (value <= std::numeric_limits<uint32_t>::max()) {
+            stream.put(static_cast<char>(0xce));
+            writeBigEndian(stream, value, 4);
+        }
+        else {
+            stream.put(static_cast<char>(0xcf));
+            writeBigEndian(stream, value, 8);
+        }
+    }
+
+    static void writeDataHeader(std::ostream& stream, int /* bits */, uint64_t size)
+    {
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Too much data for MessagePack format");
+        }
+
+        stream.put(static_cast<char>(0xc6));
+        writeBigEndian(stream, size, 4);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+// Encodes the parts of a waveform data object in CBOR format. The data is a
+// typed array (RFC 8746) of int8 or little-endian int16 values.
+
+struct CborEncoder
+{
+    static void writeHead(std::ostream& stream, int major_type, uint64_t value)
+    {
+        const int type = major_type << 5;
+
+        if (value < 24) {
+            stream.put(static_cast<char>(type | static_cast<int>(value)));
+        }
+        else if (value <= std::numeric_limits<uint8_t>::max()) {
+            stream.put(static_cast<char>(type | 24));
+            writeBigEndian(stream, value, 1);
+        }
+        else if (value <= std::numeric_limits<uint16_t>::max()) {
+            stream.put(static_cast<char>(type | 25));
+            writeBigEndian(stream, value, 2);
+        }
+        else if (value <= std::numeric_limits<uint32_t>::max()) {
+            stream.put(static_cast<char>(type | 26));
+            writeBigEndian(stream, value, 4);
+        }
+        else {
+            stream.put(static_cast<char>(type | 27));
+            writeBigEndian(stream, value, 8);
+        }
+    }
+
+    static void writeMap(std::ostream& stream, int size)
+    {
+        writeHead(stream, 5, static_cast<uint64_t>(size));
+    }
+
+    static void writeString(std::ostream& stream, const char* value)
+    {
+        const size_t length = strlen(value);
+
+        writeHead(stream, 3, length);
+        stream.write(value, static_cast<std::streamsize>(length));
+    }
+
+    static void writeUInt(std::ostream& stream, uint64_t value)
+    {
+        writeHead(stream, 0, value);
+    }
+
+    static void writeDataHeader(std::ostream& stream, int bits, uint64_t size)
+    {
+        // Typed array tags: sint8, and sint16 little-endian
+        const uint64_t tag = bits == 8 ? 72 : 77;
+
+        writeHead(stream, 6, tag);
+        writeHead(stream, 2, size);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+template <typename Encoder>
+bool WaveformBuffer::saveAsObject(const char* filename, const int bits) const
+{
+    if (bits != 8 && bits != 16) {
+        error_stream << "Invalid bits: must be either 8 or 16\n";
+        return false;
+    }
+
+    bool success = true;
+
+    std::ofstream file;
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+
+    try {
+        file.open(filename, std::ios::out | std::ios::binary);
+
+        output_stream << "Writing output file: " << filename << std::endl;
+
+        const long long size = getSize();
+
+        Encoder::writeMap(file, has_rms_ || channels_ > 1 ? 6 : 5);
+
+        Encoder::writeString(file, "sample_rate");
+        Encoder::writeUInt(file, static_cast<uint64_t>(sample_rate_));
+
+        Encoder::writeString(file, "samples_per_pixel");
+        Encoder::writeUInt(file, static_cast<uint64_t>(samples_per_pixel_));
+
+        Encoder::writeString(file, "bits");
+        Encoder::writeUInt(file, static_cast<uint64_t>(bits));
+
+        Encoder::writeString(file, "length");
+        Encoder::writeUInt(file, static_cast<uint64_t>(size));
+
+        if (channels_ > 1) {
+            Encoder::writeString(file, "channels");
+            Encoder::writeUInt(file, static_cast<uint64_t>(channels_));
+        }
+
+        const uint64_t data_size =
+            static_cast<uint64_t>(size) * 2 * static_cast<uint64_t>(channels_) * (bits / 8);
+
+        Encoder::writeString(file, "data");
+        Encoder::writeDataHeader(file, bits, data_size);
+
+        if (bits == bits_) {
+            if (bits_ == 8) {
+                writeVector(file, data_8_);
+            }
+            else {
+                writeVector(file, data_);
+            }
+        }
+        else if (bits == 8) {
+            writeConvertedVector<int8_t>(file, data_, 1, 256);
+        }
+        else {
+            writeConvertedVector<int16_t>(file, data_8_, 256, 1);
+        }
+
+        if (has_rms_) {
+            Encoder::writeString(file, "rms");
+            Encoder::writeDataHeader(file, bits, static_cast<uint64_t>(size) * (bits / 8));
+
+            if (bits == 8) {
+                writeConvertedVector<int8_t>(file, rms_, 1, 256);
+            }
+            else {
+                writeVector(file, rms_);
+            }
+        }
+    }
+    catch (const std::ios::failure&) {
+        reportWriteError(filename, strerror(errno));
+        success = false;
+    }
+    catch (const std::runtime_error& e) {
+        reportWriteError(filename, e.what());
+        success = false;
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformBuffer::saveAsMsgPack(const char* filename, const int bits) const
+{
+    return saveAsObject<MsgPackEncoder>(filename, bits);
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformBuffer::saveAsCbor(const char* filename, const int bits) const
+{
+    return saveAsObject<CborEncoder>(filename, bits);
+}
+
+//------------------------------------------------------------------------------
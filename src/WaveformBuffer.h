@@ -26,10 +26,18 @@
 
 //------------------------------------------------------------------------------
 
+#include "ChunkedVector.h"
+
+#include <cstdint>
+#include <iosfwd>
 #include <vector>
 
 //------------------------------------------------------------------------------
 
+class JsonReader;
+
+//------------------------------------------------------------------------------
+
 class WaveformBuffer
 {
     public:
@@ -54,48 +62,230 @@ class WaveformBuffer
 
         int getBits() const { return bits_; }
 
-        int getSize() const { return static_cast<int>(data_.size() / 2); }
+        // Sets the resolution of the stored data. 8-bit data is stored as
+        // int8_t, and converted to and from 16-bit values by the functions
+        // below. Existing data is converted to the new resolution.
+        void setBits(int bits);
+
+        // Enables or disables storing the RMS (root mean square) of each
+        // point's input samples, in addition to its min and max values. RMS
+        // values are stored as 16-bit values, whatever the resolution.
+        void setRms(bool rms)
+        {
+            has_rms_ = rms;
+            rms_.resize(rms ? static_cast<size_type>(getSize()) : 0);
+        }
+
+        bool hasRms() const { return has_rms_; }
+
+        // Sets the number of audio channels whose min and max values are
+        // stored separately for each point. Only valid while the buffer is
+        // empty. Multi-channel data can't have RMS values.
+        void setChannels(int channels)
+        {
+            channels_ = channels;
+        }
+
+        int getChannels() const { return channels_; }
+
+        // Sizes and indexes are 64-bit, as a waveform of a long recording at a
+        // fine zoom level may have more than 2^31 points.
+        long long getSize() const
+        {
+            return static_cast<long long>(
+                (bits_ == 8 ? data_8_.size() : data_.size()) /
+                (2 * static_cast<size_type>(channels_))
+            );
+        }
+
+        void setSize(long long size)
+        {
+            if (bits_ == 8) {
+                data_8_.resize(getDataIndex(0, size));
+            }
+            else {
+                data_.resize(getDataIndex(0, size));
+            }
+
+            if (has_rms_) {
+                rms_.resize(static_cast<size_type>(size));
+            }
+        }
+
+        // Allocates storage for size points, at the current resolution.
+        void reserve(long long size)
+        {
+            if (bits_ == 8) {
+                data_8_.reserve(getDataIndex(0, size));
+            }
+            else {
+                data_.reserve(getDataIndex(0, size));
+            }
+
+            if (has_rms_) {
+                rms_.reserve(static_cast<size_type>(size));
+            }
+        }
+
+        // Returns the first channel's values, for multi-channel data.
+        short getMinSample(long long index) const
+        {
+            return getMinSample(0, index);
+        }
+
+        short getMaxSample(long long index) const
+        {
+            return getMaxSample(0, index);
+        }
+
+        short getMinSample(int channel, long long index) const
+        {
+            const size_type i = getDataIndex(channel, index);
+            return bits_ == 8 ? static_cast<short>(data_8_[i] * 256) : data_[i];
+        }
+
+        short getMaxSample(int channel, long long index) const
+        {
+            const size_type i = getDataIndex(channel, index) + 1;
+            return bits_ == 8 ? static_cast<short>(data_8_[i] * 256) : data_[i];
+        }
 
-        void setSize(int size)
+        // Only valid if hasRms() is true.
+        short getRmsSample(long long index) const
         {
-            data_.resize(static_cast<size_type>(size * 2));
+            return rms_[static_cast<size_type>(index)];
         }
 
-        short getMinSample(int index) const
+        // Sets samples to point to the interleaved min and max values from the
+        // given index, and returns the number of points stored contiguously
+        // from there. Only valid for 16-bit, single-channel data.
+        int getSamples(long long index, const short*& samples) const
         {
-            return data_[static_cast<size_type>(2 * index)];
+            return static_cast<int>(
+                data_.getSpan(static_cast<size_type>(2 * index), samples) / 2
+            );
         }
 
-        short getMaxSample(int index) const
+        // As getSamples(), but only valid for 8-bit, single-channel data.
+        int getSamples8(long long index, const int8_t*& samples) const
         {
-            return data_[static_cast<size_type>(2 * index + 1)];
+            return static_cast<int>(
+                data_8_.getSpan(static_cast<size_type>(2 * index), samples) / 2
+            );
         }
 
+        // For multi-channel data, call this once for each channel of each
+        // point, in channel order.
         void appendSamples(short min, short max)
         {
-            data_.push_back(min);
-            data_.push_back(max);
+            if (bits_ == 8) {
+                data_8_.push_back(static_cast<int8_t>(min / 256));
+                data_8_.push_back(static_cast<int8_t>(max / 256));
+            }
+            else {
+                data_.push_back(min);
+                data_.push_back(max);
+            }
         }
 
-        void setSamples(int index, short min, short max)
+        // Appends a point with an RMS value. Only valid if hasRms() is true.
+        void appendSamples(short min, short max, short rms)
         {
-            data_[static_cast<size_type>(2 * index)] = min;
-            data_[static_cast<size_type>(2 * index + 1)] = max;
+            appendSamples(min, max);
+            rms_.push_back(rms);
+        }
+
+        // Only valid for single-channel data.
+        void setSamples(long long index, short min, short max)
+        {
+            if (bits_ == 8) {
+                data_8_[static_cast<size_type>(2 * index)] = static_cast<int8_t>(min / 256);
+                data_8_[static_cast<size_type>(2 * index + 1)] = static_cast<int8_t>(max / 256);
+            }
+            else {
+                data_[static_cast<size_type>(2 * index)] = min;
+                data_[static_cast<size_type>(2 * index + 1)] = max;
+            }
         }
 
         bool load(const char* filename);
-        bool save(const char* filename, int bits = 16) const;
-        bool saveAsText(const char* filename, int bits = 16) const;
-        bool saveAsJson(const char* filename, int bits = 16) const;
+
+        // Loads count points from the given index, or fewer if the file ends
+        // first.
+        bool load(const char* filename, long long start_index, long long count);
+
+        // Loads a file in the format written by saveAsJson.
+        bool loadJson(const char* filename);
+
+        // Saves in the block compressed format (version 3) if compress is
+        // true, in version 4 format if hasRms() is true, or in version 2
+        // format if there is more than one channel. None of these can be
+        // appended to.
+        bool save(const char* filename, int bits = 16, bool compress = false) const;
+        bool appendToFile(const char* filename, long long start_index) const;
+
+        // Text and JSON files whose name ends in .gz are gzip compressed at
+        // the given zlib compression level (0 to 9, or -1 for the default).
+        bool saveAsText(
+            const char* filename,
+            int bits = 16,
+            int compression_level = -1
+        ) const;
+
+        bool saveAsJson(
+            const char* filename,
+            int bits = 16,
+            int compression_level = -1
+        ) const;
+
+        // Save the same fields as saveAsJson, in MessagePack or CBOR format,
+        // with the data as a binary array of int8 or little-endian int16
+        // values.
+        bool saveAsMsgPack(const char* filename, int bits = 16) const;
+        bool saveAsCbor(const char* filename, int bits = 16) const;
+
+    private:
+        // Index in data_ or data_8_ of the min value of the given channel
+        // and point
+        size_t getDataIndex(int channel, long long index) const
+        {
+            return 2 * (static_cast<size_t>(index) * static_cast<size_t>(channels_) +
+                        static_cast<size_t>(channel));
+        }
+
+        void readJsonData(JsonReader& reader, bool has_bits);
+        void readJsonChannels(JsonReader& reader);
+        void readJsonRms(JsonReader& reader, bool has_bits);
+
+        void appendBlock(
+            const std::vector<uint8_t>& block,
+            int start,
+            int count,
+            int block_points
+        );
+
+        void writeBlocks(std::ostream& stream, int bits) const;
+
+        template <typename Encoder>
+        bool saveAsObject(const char* filename, int bits) const;
 
     private:
         int sample_rate_;
         int samples_per_pixel_;
         int bits_;
+        int channels_;
+
+        typedef size_t size_type;
+
+        ChunkedVector<short> data_;
+
+        // Used instead of data_ when bits_ is 8
+        ChunkedVector<int8_t> data_8_;
+
+        bool has_rms_;
 
-        typedef std::vector<short> vector_type;
-        typedef vector_type::size_type size_type;
-        vector_type data_;
+        // One value per point, if has_rms_ is true
+        ChunkedVector<short> rms_;
 };
 
 //------------------------------------------------------------------------------
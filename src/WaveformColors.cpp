@@ -36,11 +36,13 @@ WaveformColors::WaveformColors(
     const RGBA& border,
     const RGBA& background,
     const RGBA& waveform,
-    const RGBA& axis_label) :
+    const RGBA& axis_label,
+    const RGBA& rms) :
     border_color(border),
     background_color(background),
     waveform_color(waveform),
-    axis_label_color(axis_label)
+    axis_label_color(axis_label),
+    rms_color(rms)
 {
 }
 
@@ -51,7 +53,8 @@ bool WaveformColors::hasAlpha() const
     return border_color.hasAlpha() ||
            background_color.hasAlpha() ||
            waveform_color.hasAlpha() ||
-           axis_label_color.hasAlpha();
+           axis_label_color.hasAlpha() ||
+           rms_color.hasAlpha();
 }
 
 //------------------------------------------------------------------------------
@@ -60,7 +63,8 @@ const WaveformColors audacity_waveform_colors(
     {0, 0, 0},
     {214, 214, 214},
     {63, 77, 155},
-    {0, 0, 0}
+    {0, 0, 0},
+    {111, 125, 203}
 );
 
 //------------------------------------------------------------------------------
@@ -69,7 +73,8 @@ const WaveformColors audition_waveform_colors(
     {157, 157, 157},
     {0, 63, 34},
     {134, 252, 199},
-    {190, 190, 190}
+    {190, 190, 190},
+    {200, 255, 230}
 );
 
 //------------------------------------------------------------------------------
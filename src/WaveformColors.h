@@ -38,7 +38,8 @@ class WaveformColors
             const RGBA& border_color,
             const RGBA& background_color,
             const RGBA& wave_color,
-            const RGBA& axis_label_color
+            const RGBA& axis_label_color,
+            const RGBA& rms_color
         );
 
         bool hasAlpha() const;
@@ -48,6 +49,9 @@ class WaveformColors
         RGBA background_color;
         RGBA waveform_color;
         RGBA axis_label_color;
+
+        // Used to draw the RMS values, if the waveform data has them
+        RGBA rms_color;
 };
 
 //------------------------------------------------------------------------------
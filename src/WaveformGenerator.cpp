@@ -24,9 +24,12 @@
 #include "WaveformGenerator.h"
 #include "WaveformBuffer.h"
 #include "Streams.h"
+#include "nullptr.h"
 
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
@@ -35,6 +38,10 @@
 #include <sstream>
 #include <stdexcept>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 //------------------------------------------------------------------------------
 
 ScaleFactor::~ScaleFactor()
@@ -87,11 +94,13 @@ int DurationScaleFactor::getSamplesPerPixel(const int sample_rate) const
 {
     const double seconds = end_time_ - start_time_;
 
-    const int width_samples = static_cast<int>(seconds * sample_rate);
+    const long long width_samples = static_cast<long long>(seconds * sample_rate);
 
-    const int samples_per_pixel = width_samples / width_pixels_;
+    const long long samples_per_pixel = width_samples / width_pixels_;
 
-    return samples_per_pixel;
+    return static_cast<int>(
+        std::min<long long>(samples_per_pixel, std::numeric_limits<int>::max())
+    );
 }
 
 //------------------------------------------------------------------------------
@@ -124,7 +133,13 @@ WaveformGenerator::WaveformGenerator(
     buffer_(buffer),
     scale_factor_(scale_factor),
     channels_(0),
-    samples_per_pixel_(0)
+    samples_per_pixel_(0),
+    verbose_(true),
+    error_stream_(&error_stream),
+    split_channels_(false),
+    has_rms_(false),
+    min_(1),
+    max_(1)
 {
     reset();
 }
@@ -132,30 +147,64 @@ WaveformGenerator::WaveformGenerator(
 //------------------------------------------------------------------------------
 
 bool WaveformGenerator::init(
-    const int sample_rate,
-    const int channels,
+    const AudioStreamInfo& info,
     const int /* buffer_size */)
 {
-    if (channels < 1 || channels > 2) {
-        error_stream << "Can only generate waveform data from mono or stereo input files\n";
+    const int sample_rate = info.sample_rate;
+    const int channels    = info.channels;
+
+    if (channels < 1) {
+        *error_stream_ << "Invalid number of input channels: " << channels << '\n';
         return false;
     }
 
     channels_ = channels;
+    has_rms_  = buffer_.hasRms();
+
+    if (split_channels_) {
+        if (has_rms_) {
+            *error_stream_ << "Can't generate RMS values with split channels\n";
+            return false;
+        }
+
+        buffer_.setChannels(channels);
+
+        // Keeps the first channel's values from setPartialPoint()
+        min_.resize(static_cast<size_t>(channels), MAX_SAMPLE);
+        max_.resize(static_cast<size_t>(channels), MIN_SAMPLE);
+    }
 
     samples_per_pixel_ = scale_factor_.getSamplesPerPixel(sample_rate);
 
     if (samples_per_pixel_ < 2) {
-        error_stream << "Invalid zoom: minimum 2\n";
+        *error_stream_ << "Invalid zoom: minimum 2\n";
+        return false;
+    }
+
+    // A point continued by setPartialPoint() must be incomplete
+    if (count_ >= samples_per_pixel_) {
+        *error_stream_ << "Invalid partial point: too many samples for zoom\n";
         return false;
     }
 
     buffer_.setSamplesPerPixel(samples_per_pixel_);
     buffer_.setSampleRate(sample_rate);
 
-    output_stream << "Generating waveform data...\n"
-                  << "Samples per pixel: " << samples_per_pixel_ << '\n'
-                  << "Input channels: " << channels_ << '\n';
+    // Only reserve space for an exact length, as an estimate could be much
+    // too large.
+
+    if (info.frame_count_exact && info.frame_count > 0) {
+        const long long points =
+            (info.frame_count + samples_per_pixel_ - 1) / samples_per_pixel_;
+
+        buffer_.reserve(buffer_.getSize() + points);
+    }
+
+    if (verbose_) {
+        output_stream << "Generating waveform data...\n"
+                      << "Samples per pixel: " << samples_per_pixel_ << '\n'
+                      << "Input channels: " << channels_ << '\n';
+    }
 
     return true;
 }
@@ -171,43 +220,387 @@ int WaveformGenerator::getSamplesPerPixel() const
 
 void WaveformGenerator::reset()
 {
-    min_ = MAX_SAMPLE;
-    max_ = MIN_SAMPLE;
+    std::fill(min_.begin(), min_.end(), MAX_SAMPLE);
+    std::fill(max_.begin(), max_.end(), MIN_SAMPLE);
     count_ = 0;
+    sum_squares_ = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void WaveformGenerator::setPartialPoint(
+    const int min,
+    const int max,
+    const int count)
+{
+    min_[0] = min;
+    max_[0] = max;
+    count_  = count;
+}
+
+//------------------------------------------------------------------------------
+
+void WaveformGenerator::getPartialPoint(int& min, int& max, int& count) const
+{
+    min   = min_[0];
+    max   = max_[0];
+    count = count_;
 }
 
 //------------------------------------------------------------------------------
 
+// The incomplete last point is output, but kept so that getPartialPoint() can
+// return it.
+
 void WaveformGenerator::done()
 {
     if (count_ > 0) {
-        buffer_.appendSamples(static_cast<short>(min_), static_cast<short>(max_));
-        reset();
+        appendPoint();
     }
 
-    output_stream << "Generated " << buffer_.getSize() << " points"
-                  << std::endl;
+    if (verbose_) {
+        output_stream << "Generated " << buffer_.getSize() << " points"
+                      << std::endl;
+    }
 }
 
 //------------------------------------------------------------------------------
 
-// See BlockFile::CalcSummary in Audacity
+// Outputs the current point. The RMS value is rounded to the nearest integer,
+// and limited to the maximum sample value, which it exceeds only if every
+// sample is the minimum value.
 
-bool WaveformGenerator::process(
-    const short* input_buffer,
-    const int input_frame_count)
+void WaveformGenerator::appendPoint()
+{
+    if (has_rms_) {
+        const double rms = std::sqrt(static_cast<double>(sum_squares_) / count_);
+
+        buffer_.appendSamples(
+            static_cast<short>(min_[0]),
+            static_cast<short>(max_[0]),
+            static_cast<short>(std::min(std::lround(rms), static_cast<long>(MAX_SAMPLE)))
+        );
+    }
+    else {
+        for (size_t i = 0; i < min_.size(); ++i) {
+            buffer_.appendSamples(static_cast<short>(min_[i]), static_cast<short>(max_[i]));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Updates min and max with count samples, and, if sum_squares is given, adds
+// the sum of their squares. With SSE2, eight samples are processed at a time.
+// _mm_madd_epi16 gives the sums of squares of pairs of samples, which fit in
+// 32 bits as unsigned values, so are widened to 64 bits before adding.
+
+static void accumulate(
+    const short* samples,
+    const int count,
+    int& min,
+    int& max,
+    long long* sum_squares)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    if (count >= 8) {
+        const __m128i zero = _mm_setzero_si128();
+
+        __m128i min_vector = _mm_set1_epi16(static_cast<short>(min));
+        __m128i max_vector = _mm_set1_epi16(static_cast<short>(max));
+        __m128i sum_vector = zero;
+
+        for (; i + 8 <= count; i += 8) {
+            const __m128i values = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(samples + i)
+            );
+
+            min_vector = _mm_min_epi16(min_vector, values);
+            max_vector = _mm_max_epi16(max_vector, values);
+
+            if (sum_squares != nullptr) {
+                const __m128i squares = _mm_madd_epi16(values, values);
+
+                sum_vector = _mm_add_epi64(sum_vector, _mm_unpacklo_epi32(squares, zero));
+                sum_vector = _mm_add_epi64(sum_vector, _mm_unpackhi_epi32(squares, zero));
+            }
+        }
+
+        short mins[8];
+        short maxs[8];
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), min_vector);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs), max_vector);
+
+        for (int j = 0; j < 8; ++j) {
+            if (mins[j] < min) {
+                min = mins[j];
+            }
+
+            if (maxs[j] > max) {
+                max = maxs[j];
+            }
+        }
+
+        if (sum_squares != nullptr) {
+            long long sums[2];
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), sum_vector);
+
+            *sum_squares += sums[0] + sums[1];
+        }
+    }
+#endif
+
+    long long sum = 0;
+
+    for (; i < count; ++i) {
+        const int sample = samples[i];
+
+        if (sample < min) {
+            min = sample;
+        }
+
+        if (sample > max) {
+            max = sample;
+        }
+
+        sum += sample * sample;
+    }
+
+    if (sum_squares != nullptr) {
+        *sum_squares += sum;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Converts an input sample to 16 bits. 32-bit integer samples keep their upper
+// 16 bits, and float samples are scaled by 32767 and rounded to the nearest
+// integer, so that full scale float input gives full scale output. Float
+// samples outside the range -1.0 to 1.0 are clamped. Previously, float files
+// were read with sf_readf_short(), which libsndfile scales by 1.0 unless
+// SFC_SET_SCALE_FLOAT_INT_READ is set, giving an almost flat waveform.
+
+static inline short toSample(const short sample)
+{
+    return sample;
+}
+
+static inline short toSample(const int sample)
+{
+    return static_cast<short>(sample >> 16);
+}
+
+static inline short toSample(const float sample)
+{
+    const float value = sample * 32767.0f;
+
+    if (value >= 32767.0f) {
+        return MAX_SAMPLE;
+    }
+    else if (value > -32768.0f) {
+        return static_cast<short>(std::lrint(value));
+    }
+    else {
+        return MIN_SAMPLE;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+// Loads eight input samples, converted to 16 bits as in toSample(). Float
+// samples are clamped before packing, with _mm_max_ps first so that NaN
+// becomes the minimum value, as in toSample(), and rounded using the current
+// rounding mode, as std::lrint() does.
+
+static inline __m128i loadSamples(const short* samples)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+}
+
+static inline __m128i loadSamples(const int* samples)
+{
+    const __m128i values0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+    const __m128i values1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + 4));
+
+    return _mm_packs_epi32(_mm_srai_epi32(values0, 16), _mm_srai_epi32(values1, 16));
+}
+
+static inline __m128i loadSamples(const float* samples)
+{
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const __m128 min   = _mm_set1_ps(-32768.0f);
+
+    const __m128 values0 = _mm_mul_ps(_mm_loadu_ps(samples), scale);
+    const __m128 values1 = _mm_mul_ps(_mm_loadu_ps(samples + 4), scale);
+
+    return _mm_packs_epi32(
+        _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(values0, min), scale)),
+        _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(values1, min), scale))
+    );
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+
+// Copies interleaved input samples, converted to 16 bits, to one block of
+// frame_count samples for each channel. With SSE2, stereo input is split eight
+// frames at a time: each 32-bit lane holds a left and right sample, which are
+// sign extended by shifting, then packed back to 16 bits.
+
+template <typename T>
+static void deinterleave(
+    const T* input_buffer,
+    const int frame_count,
+    const int channels,
+    short* samples)
 {
-    for (int i = 0; i < input_frame_count; ++i) {
-        const int index = i * channels_;
+    int i = 0;
+
+#if defined(__SSE2__)
+    if (channels == 2) {
+        short* left  = samples;
+        short* right = samples + frame_count;
+
+        for (; i + 8 <= frame_count; i += 8) {
+            const __m128i frames0 = loadSamples(input_buffer + 2 * i);
+            const __m128i frames1 = loadSamples(input_buffer + 2 * i + 8);
+
+            const __m128i left_values = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_slli_epi32(frames0, 16), 16),
+                _mm_srai_epi32(_mm_slli_epi32(frames1, 16), 16)
+            );
+
+            const __m128i right_values = _mm_packs_epi32(
+                _mm_srai_epi32(frames0, 16),
+                _mm_srai_epi32(frames1, 16)
+            );
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(left + i), left_values);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(right + i), right_values);
+        }
+    }
+#endif
+
+    for (; i < frame_count; ++i) {
+        for (int channel = 0; channel < channels; ++channel) {
+            samples[channel * frame_count + i] = toSample(input_buffer[i * channels + channel]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Converts each frame's samples to 16 bits, then sums them and divides by the
+// number of channels, rounding towards zero, to make a single (mono) sample.
+// With SSE2, the sums are made in 32-bit lanes, then packed back to 16 bits,
+// which clamps them. Mono input is converted eight frames at a time. Stereo
+// input is summed eight frames at a time, as in deinterleave(), and halved by
+// shifting, after adding one to negative sums so they round towards zero.
+// Other channel counts are summed four frames at a time, and divided in double
+// precision after adding 0.5 with the sign of the sum, which truncates to the
+// same result as integer division.
+
+template <typename T>
+static void downmix(
+    const T* input_buffer,
+    const int frame_count,
+    const int channels,
+    short* samples)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    if (channels == 1) {
+        for (; i + 8 <= frame_count; i += 8) {
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(samples + i),
+                loadSamples(input_buffer + i)
+            );
+        }
+    }
+    else if (channels == 2) {
+        for (; i + 8 <= frame_count; i += 8) {
+            const __m128i frames0 = loadSamples(input_buffer + 2 * i);
+            const __m128i frames1 = loadSamples(input_buffer + 2 * i + 8);
+
+            const __m128i sum0 = _mm_add_epi32(
+                _mm_srai_epi32(_mm_slli_epi32(frames0, 16), 16),
+                _mm_srai_epi32(frames0, 16)
+            );
+
+            const __m128i sum1 = _mm_add_epi32(
+                _mm_srai_epi32(_mm_slli_epi32(frames1, 16), 16),
+                _mm_srai_epi32(frames1, 16)
+            );
+
+            const __m128i mean0 = _mm_srai_epi32(_mm_add_epi32(sum0, _mm_srli_epi32(sum0, 31)), 1);
+            const __m128i mean1 = _mm_srai_epi32(_mm_add_epi32(sum1, _mm_srli_epi32(sum1, 31)), 1);
+
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(samples + i),
+                _mm_packs_epi32(mean0, mean1)
+            );
+        }
+    }
+    else {
+        const __m128d sign_bit   = _mm_set1_pd(-0.0);
+        const __m128d half       = _mm_set1_pd(0.5);
+        const __m128d reciprocal = _mm_set1_pd(1.0 / channels);
+
+        for (; i + 4 <= frame_count; i += 4) {
+            const T* frames = input_buffer + i * channels;
+
+            __m128i sum = _mm_setzero_si128();
+
+            for (int channel = 0; channel < channels; ++channel) {
+                sum = _mm_add_epi32(sum, _mm_set_epi32(
+                    toSample(frames[3 * channels + channel]),
+                    toSample(frames[2 * channels + channel]),
+                    toSample(frames[channels + channel]),
+                    toSample(frames[channel])
+                ));
+            }
+
+            const __m128d sum_low  = _mm_cvtepi32_pd(sum);
+            const __m128d sum_high = _mm_cvtepi32_pd(_mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 2, 3, 2)));
+
+            const __m128i mean_low = _mm_cvttpd_epi32(_mm_mul_pd(
+                _mm_add_pd(sum_low, _mm_or_pd(_mm_and_pd(sum_low, sign_bit), half)),
+                reciprocal
+            ));
+
+            const __m128i mean_high = _mm_cvttpd_epi32(_mm_mul_pd(
+                _mm_add_pd(sum_high, _mm_or_pd(_mm_and_pd(sum_high, sign_bit), half)),
+                reciprocal
+            ));
+
+            const __m128i mean = _mm_unpacklo_epi64(mean_low, mean_high);
+
+            _mm_storel_epi64(
+                reinterpret_cast<__m128i*>(samples + i),
+                _mm_packs_epi32(mean, mean)
+            );
+        }
+    }
+#endif
+
+    for (; i < frame_count; ++i) {
+        const int index = i * channels;
 
-        // Sum samples from each input channel to make a single (mono) waveform
         int sample = 0;
 
-        for (int j = 0; j < channels_; ++j) {
-            sample += input_buffer[index + j];
+        for (int j = 0; j < channels; ++j) {
+            sample += toSample(input_buffer[index + j]);
         }
 
-        sample /= channels_;
+        sample /= channels;
 
         // Avoid numeric overflow when converting to short
         if (sample > MAX_SAMPLE) {
@@ -217,21 +610,143 @@ bool WaveformGenerator::process(
             sample = MIN_SAMPLE;
         }
 
-        if (sample < min_) {
-            min_ = sample;
+        samples[i] = static_cast<short>(sample);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformGenerator::acceptsSampleFormat(const SampleFormat format) const
+{
+    return format == SAMPLE_FORMAT_PCM_16 ||
+           format == SAMPLE_FORMAT_PCM_32 ||
+           format == SAMPLE_FORMAT_FLOAT;
+}
+
+//------------------------------------------------------------------------------
+
+// See BlockFile::CalcSummary in Audacity. Input samples are converted to 16
+// bits as multi-channel input is summed to make a single (mono) waveform, or
+// split into one block per channel, so 32-bit and float input needs no
+// separate conversion pass. Each point's samples are then accumulated in one
+// call per channel.
+
+template <typename T>
+bool WaveformGenerator::processSamples(
+    const T* input_buffer,
+    const int input_frame_count)
+{
+    if (split_channels_ && channels_ > 1) {
+        samples_.resize(static_cast<size_t>(input_frame_count * channels_));
+
+        deinterleave(input_buffer, input_frame_count, channels_, samples_.data());
+
+        processChannels(samples_.data(), input_frame_count);
+    }
+    else {
+        samples_.resize(static_cast<size_t>(input_frame_count));
+
+        downmix(input_buffer, input_frame_count, channels_, samples_.data());
+
+        processMono(samples_.data(), input_frame_count);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Mono 16-bit input is accumulated directly, without copying.
+
+bool WaveformGenerator::process(
+    const short* input_buffer,
+    const int input_frame_count)
+{
+    if (channels_ == 1) {
+        processMono(input_buffer, input_frame_count);
+        return true;
+    }
+
+    return processSamples(input_buffer, input_frame_count);
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformGenerator::process(
+    const int* input_buffer,
+    const int input_frame_count)
+{
+    return processSamples(input_buffer, input_frame_count);
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformGenerator::process(
+    const float* input_buffer,
+    const int input_frame_count)
+{
+    return processSamples(input_buffer, input_frame_count);
+}
+
+//------------------------------------------------------------------------------
+
+// Accumulates frame_count mono samples.
+
+void WaveformGenerator::processMono(
+    const short* samples,
+    const int frame_count)
+{
+    int i = 0;
+
+    while (i < frame_count) {
+        const int count = std::min(frame_count - i, samples_per_pixel_ - count_);
+
+        accumulate(samples + i, count, min_[0], max_[0], has_rms_ ? &sum_squares_ : nullptr);
+
+        i += count;
+        count_ += count;
+
+        if (count_ == samples_per_pixel_) {
+            appendPoint();
+            reset();
         }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Accumulates frame_count frames of samples, which holds one block of samples
+// for each channel.
+
+void WaveformGenerator::processChannels(
+    const short* samples,
+    const int frame_count)
+{
+    int i = 0;
+
+    while (i < frame_count) {
+        const int count = std::min(frame_count - i, samples_per_pixel_ - count_);
+
+        for (int channel = 0; channel < channels_; ++channel) {
+            const size_t index = static_cast<size_t>(channel);
 
-        if (sample > max_) {
-            max_ = sample;
+            accumulate(
+                samples + channel * frame_count + i,
+                count,
+                min_[index],
+                max_[index],
+                nullptr
+            );
         }
 
-        if (++count_ == samples_per_pixel_) {
-            buffer_.appendSamples(static_cast<short>(min_), static_cast<short>(max_));
+        i += count;
+        count_ += count;
+
+        if (count_ == samples_per_pixel_) {
+            appendPoint();
             reset();
         }
     }
-
-    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -28,6 +28,9 @@
 
 #include "AudioProcessor.h"
 
+#include <iosfwd>
+#include <vector>
+
 //------------------------------------------------------------------------------
 
 class WaveformBuffer;
@@ -106,22 +109,63 @@ class WaveformGenerator : public AudioProcessor
 
     public:
         virtual bool init(
-            int sample_rate,
-            int channels,
+            const AudioStreamInfo& info,
             int buffer_size
         );
 
         int getSamplesPerPixel() const;
 
+        virtual bool acceptsSampleFormat(SampleFormat format) const;
+
         virtual bool process(
             const short* input_buffer,
             int input_frame_count
         );
 
+        virtual bool process(
+            const int* input_buffer,
+            int input_frame_count
+        );
+
+        virtual bool process(
+            const float* input_buffer,
+            int input_frame_count
+        );
+
         virtual void done();
 
+        // Continues the last point of a previous run, which has count input
+        // samples so far, with the given min and max values. Call this before
+        // processing the input that follows.
+        void setPartialPoint(int min, int max, int count);
+
+        // After done(), returns the last point's min and max values and number
+        // of input samples, which is less than samples per pixel if the point
+        // is incomplete, or zero if there is no incomplete point.
+        void getPartialPoint(int& min, int& max, int& count) const;
+
+        // Disables the messages written by init() and done(), e.g., when
+        // several generators run at once.
+        void setVerbose(bool verbose) { verbose_ = verbose; }
+
+        // Sets the stream for error messages (error_stream by default), e.g.,
+        // when several generators run at once.
+        void setErrorStream(std::ostream& stream) { error_stream_ = &stream; }
+
+        // Outputs each input channel's min and max values separately, instead
+        // of summing the channels to mono. Call this before init(). Can't be
+        // used with RMS values.
+        void setSplitChannels(bool split) { split_channels_ = split; }
+
     private:
         void reset();
+        void appendPoint();
+
+        template <typename T>
+        bool processSamples(const T* input_buffer, int input_frame_count);
+
+        void processMono(const short* samples, int frame_count);
+        void processChannels(const short* samples, int frame_count);
 
     private:
         WaveformBuffer& buffer_;
@@ -129,10 +173,24 @@ class WaveformGenerator : public AudioProcessor
 
         int channels_;
         int samples_per_pixel_;
+        bool verbose_;
+        std::ostream* error_stream_;
+        bool split_channels_;
+
+        // Set if the buffer stores RMS values
+        bool has_rms_;
 
         int count_;
-        int min_;
-        int max_;
+
+        // One value for each output channel
+        std::vector<int> min_;
+        std::vector<int> max_;
+
+        long long sum_squares_;
+
+        // Input samples converted to 16 bits and summed to mono, or one
+        // block of samples for each channel if split_channels_ is set
+        std::vector<short> samples_;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,323 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "WaveformIndex.h"
+#include "Streams.h"
+#include "WaveformBuffer.h"
+
+#include <boost/format.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+//------------------------------------------------------------------------------
+
+// Version 2 has a 64-bit buffer size. Files with other versions are rebuilt.
+const int32_t INDEX_FILE_VERSION = 2;
+
+//------------------------------------------------------------------------------
+
+static int32_t readInt32(std::istream& stream)
+{
+    int32_t value;
+    stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+
+    return value;
+}
+
+//------------------------------------------------------------------------------
+
+static int64_t readInt64(std::istream& stream)
+{
+    int64_t value;
+    stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+
+    return value;
+}
+
+//------------------------------------------------------------------------------
+
+static void writeInt32(std::ostream& stream, int32_t value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+
+static void writeInt64(std::ostream& stream, int64_t value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+//------------------------------------------------------------------------------
+
+static void reportReadError(const char* filename, const char* message)
+{
+    error_stream << "Failed to read index file: " << filename << '\n'
+                 << message << '\n';
+}
+
+//------------------------------------------------------------------------------
+
+static void reportWriteError(const char* filename, const char* message)
+{
+    error_stream << "Failed to write index file: " << filename << '\n'
+                 << message << '\n';
+}
+
+//------------------------------------------------------------------------------
+
+WaveformIndex::WaveformIndex(const WaveformBuffer& buffer) :
+    buffer_(buffer)
+{
+}
+
+//------------------------------------------------------------------------------
+
+void WaveformIndex::build()
+{
+    levels_.clear();
+
+    long long size = buffer_.getSize();
+    int level = -1;
+
+    while (size > BLOCK_SIZE) {
+        const long long blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        vector_type values;
+        values.reserve(static_cast<size_type>(blocks) * 2);
+
+        for (long long i = 0; i < size; i += BLOCK_SIZE) {
+            short min = std::numeric_limits<short>::max();
+            short max = std::numeric_limits<short>::min();
+
+            scan(level, i, std::min<long long>(i + BLOCK_SIZE, size), min, max);
+
+            values.push_back(min);
+            values.push_back(max);
+        }
+
+        levels_.push_back(values);
+
+        size = blocks;
+        level++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+short WaveformIndex::getMinSample(const int level, const long long index) const
+{
+    if (level < 0) {
+        return buffer_.getMinSample(index);
+    }
+
+    return levels_[static_cast<size_type>(level)][static_cast<size_type>(index) * 2];
+}
+
+//------------------------------------------------------------------------------
+
+short WaveformIndex::getMaxSample(const int level, const long long index) const
+{
+    if (level < 0) {
+        return buffer_.getMaxSample(index);
+    }
+
+    return levels_[static_cast<size_type>(level)][static_cast<size_type>(index) * 2 + 1];
+}
+
+//------------------------------------------------------------------------------
+
+// Updates min and max with the values from start to end at the given level,
+// where level -1 is the buffer itself.
+
+void WaveformIndex::scan(
+    const int level,
+    const long long start,
+    const long long end,
+    short& min,
+    short& max) const
+{
+    for (long long i = start; i < end; ++i) {
+        const short low  = getMinSample(level, i);
+        const short high = getMaxSample(level, i);
+
+        if (low < min) {
+            min = low;
+        }
+
+        if (high > max) {
+            max = high;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the minimum and maximum values over buffer indices from start up to,
+// but not including, end. At each level, the partial blocks at either end of
+// the range are scanned, and the whole blocks in between are looked up in the
+// level above.
+
+void WaveformIndex::getMinMax(
+    long long start,
+    long long end,
+    short& min,
+    short& max) const
+{
+    assert(start >= 0);
+    assert(end <= buffer_.getSize());
+
+    min = std::numeric_limits<short>::max();
+    max = std::numeric_limits<short>::min();
+
+    const int top_level = getLevelCount() - 1;
+
+    for (int level = -1; start < end; ++level) {
+        if (level == top_level || end - start < 2 * BLOCK_SIZE) {
+            scan(level, start, end, min, max);
+            break;
+        }
+
+        const long long head_end   = std::min((start + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE, end);
+        const long long tail_start = std::max(end / BLOCK_SIZE * BLOCK_SIZE, head_end);
+
+        scan(level, start, head_end, min, max);
+        scan(level, tail_start, end, min, max);
+
+        start = head_end / BLOCK_SIZE;
+        end   = tail_start / BLOCK_SIZE;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Loads a saved index, checking that it matches the buffer. Returns false if
+// the file can't be read or was built from different data.
+
+bool WaveformIndex::load(const char* filename)
+{
+    bool success = true;
+
+    std::ifstream file;
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+
+    try {
+        file.open(filename, std::ios::in | std::ios::binary);
+
+        output_stream << "Reading index file: " << filename << std::endl;
+
+        const int32_t version = readInt32(file);
+
+        if (version != INDEX_FILE_VERSION) {
+            reportReadError(
+                filename,
+                boost::str(boost::format("Cannot load index file version: %1%") % version).c_str()
+            );
+
+            return false;
+        }
+
+        const int32_t block_size        = readInt32(file);
+        const int32_t sample_rate       = readInt32(file);
+        const int32_t samples_per_pixel = readInt32(file);
+        const int64_t size              = readInt64(file);
+        const int32_t level_count       = readInt32(file);
+
+        if (block_size != BLOCK_SIZE ||
+            sample_rate != buffer_.getSampleRate() ||
+            samples_per_pixel != buffer_.getSamplesPerPixel() ||
+            size != buffer_.getSize()) {
+            reportReadError(filename, "Index does not match waveform data");
+            return false;
+        }
+
+        levels_.clear();
+
+        long long level_size = size;
+
+        for (int32_t level = 0; level < level_count; ++level) {
+            level_size = (level_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+            vector_type values(static_cast<size_type>(level_size) * 2);
+
+            file.read(
+                reinterpret_cast<char*>(&values[0]),
+                static_cast<std::streamsize>(values.size() * sizeof(short))
+            );
+
+            levels_.push_back(values);
+        }
+    }
+    catch (const std::ios::failure&) {
+        reportReadError(filename, strerror(errno));
+        levels_.clear();
+        success = false;
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformIndex::save(const char* filename) const
+{
+    bool success = true;
+
+    std::ofstream file;
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+
+    try {
+        file.open(filename, std::ios::out | std::ios::binary);
+
+        output_stream << "Writing index file: " << filename << std::endl;
+
+        writeInt32(file, INDEX_FILE_VERSION);
+        writeInt32(file, BLOCK_SIZE);
+        writeInt32(file, buffer_.getSampleRate());
+        writeInt32(file, buffer_.getSamplesPerPixel());
+        writeInt64(file, buffer_.getSize());
+        writeInt32(file, getLevelCount());
+
+        for (const auto& values : levels_) {
+            file.write(
+                reinterpret_cast<const char*>(&values[0]),
+                static_cast<std::streamsize>(values.size() * sizeof(short))
+            );
+        }
+    }
+    catch (const std::ios::failure&) {
+        reportWriteError(filename, strerror(errno));
+        success = false;
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#if !defined(INC_WAVEFORM_INDEX_H)
+#define INC_WAVEFORM_INDEX_H
+
+//------------------------------------------------------------------------------
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+class WaveformBuffer;
+
+//------------------------------------------------------------------------------
+
+// A block min/max tree over a WaveformBuffer, which answers queries for the
+// minimum and maximum values over any range of buffer indices in O(log n)
+// time. Each level holds the min and max of each block of BLOCK_SIZE entries
+// in the level below, the lowest level being the buffer itself.
+//
+// The index can be saved to a file, usually next to the .dat file it was built
+// from, so that it need not be rebuilt each time the data is used.
+
+class WaveformIndex
+{
+    public:
+        explicit WaveformIndex(const WaveformBuffer& buffer);
+
+        WaveformIndex(const WaveformIndex&) = delete;
+        WaveformIndex& operator=(const WaveformIndex&) = delete;
+
+    public:
+        static const int BLOCK_SIZE = 16;
+
+        void build();
+
+        bool load(const char* filename);
+        bool save(const char* filename) const;
+
+        void getMinMax(long long start, long long end, short& min, short& max) const;
+
+        int getLevelCount() const { return static_cast<int>(levels_.size()); }
+
+    private:
+        short getMinSample(int level, long long index) const;
+        short getMaxSample(int level, long long index) const;
+
+        void scan(
+            int level,
+            long long start,
+            long long end,
+            short& min,
+            short& max
+        ) const;
+
+    private:
+        const WaveformBuffer& buffer_;
+
+        typedef std::vector<short> vector_type;
+        typedef vector_type::size_type size_type;
+
+        // Interleaved min and max values, levels_[0] being the first level
+        // above the buffer
+        std::vector<vector_type> levels_;
+};
+
+//------------------------------------------------------------------------------
+
+#endif // #if !defined(INC_WAVEFORM_INDEX_H)
+
+//------------------------------------------------------------------------------
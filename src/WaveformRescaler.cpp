@@ -24,12 +24,273 @@
 #include "WaveformRescaler.h"
 #include "Streams.h"
 #include "WaveformBuffer.h"
+#include "WaveformIndex.h"
+#include "nullptr.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+
+// Finds the lowest min value and highest max value of count interleaved
+// min/max pairs. With SSE2, four pairs are compared at a time: the even lanes
+// of min_vector hold the min values, and the odd lanes of max_vector the max
+// values.
+
+static void getMinMax(const short* samples, int count, short& min, short& max)
+{
+    min = std::numeric_limits<short>::max();
+    max = std::numeric_limits<short>::min();
+
+    int i = 0;
+
+#if defined(__SSE2__)
+    if (count >= 4) {
+        __m128i min_vector = _mm_set1_epi16(min);
+        __m128i max_vector = _mm_set1_epi16(max);
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pairs = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(samples + 2 * i)
+            );
+
+            min_vector = _mm_min_epi16(min_vector, pairs);
+            max_vector = _mm_max_epi16(max_vector, pairs);
+        }
+
+        short mins[8];
+        short maxs[8];
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), min_vector);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs), max_vector);
+
+        for (int j = 0; j < 8; j += 2) {
+            if (mins[j] < min) {
+                min = mins[j];
+            }
+
+            if (maxs[j + 1] > max) {
+                max = maxs[j + 1];
+            }
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (samples[2 * i] < min) {
+            min = samples[2 * i];
+        }
+
+        if (samples[2 * i + 1] > max) {
+            max = samples[2 * i + 1];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// As above, for 8-bit data, returning 16-bit values. With SSE2, eight pairs
+// are compared at a time, using unsigned comparisons on values with the sign
+// bit flipped, as SSE2 has no signed 8-bit min and max.
+
+static void getMinMax(const int8_t* samples, int count, short& min, short& max)
+{
+    int min_value = std::numeric_limits<int8_t>::max();
+    int max_value = std::numeric_limits<int8_t>::min();
+
+    int i = 0;
+
+#if defined(__SSE2__)
+    if (count >= 8) {
+        const __m128i sign_bits = _mm_set1_epi8(static_cast<char>(0x80));
+
+        __m128i min_vector = _mm_set1_epi8(static_cast<char>(0xff));
+        __m128i max_vector = _mm_setzero_si128();
+
+        for (; i + 8 <= count; i += 8) {
+            const __m128i pairs = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + 2 * i)),
+                sign_bits
+            );
+
+            min_vector = _mm_min_epu8(min_vector, pairs);
+            max_vector = _mm_max_epu8(max_vector, pairs);
+        }
+
+        unsigned char mins[16];
+        unsigned char maxs[16];
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), min_vector);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs), max_vector);
+
+        for (int j = 0; j < 16; j += 2) {
+            if (mins[j] - 128 < min_value) {
+                min_value = mins[j] - 128;
+            }
+
+            if (maxs[j + 1] - 128 > max_value) {
+                max_value = maxs[j + 1] - 128;
+            }
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (samples[2 * i] < min_value) {
+            min_value = samples[2 * i];
+        }
+
+        if (samples[2 * i + 1] > max_value) {
+            max_value = samples[2 * i + 1];
+        }
+    }
+
+    min = static_cast<short>(min_value * 256);
+    max = static_cast<short>(max_value * 256);
+}
+
+//------------------------------------------------------------------------------
+
+// Finds the lowest min value and highest max value of the given channel over
+// count points. Multi-channel data is interleaved, so is scanned point by
+// point.
+
+static void getMinMax(
+    const WaveformBuffer& buffer,
+    const int channel,
+    long long start,
+    long long count,
+    short& min,
+    short& max)
+{
+    min = std::numeric_limits<short>::max();
+    max = std::numeric_limits<short>::min();
+
+    if (buffer.getChannels() > 1) {
+        for (long long i = start; i < start + count; ++i) {
+            min = std::min(min, buffer.getMinSample(channel, i));
+            max = std::max(max, buffer.getMaxSample(channel, i));
+        }
+
+        return;
+    }
+
+    // Reduce each run of points stored contiguously in the buffer
+    while (count > 0) {
+        int span_count;
+        short span_min;
+        short span_max;
+
+        if (buffer.getBits() == 8) {
+            const int8_t* samples;
+            span_count = static_cast<int>(
+                std::min<long long>(buffer.getSamples8(start, samples), count)
+            );
+            getMinMax(samples, span_count, span_min, span_max);
+        }
+        else {
+            const short* samples;
+            span_count = static_cast<int>(
+                std::min<long long>(buffer.getSamples(start, samples), count)
+            );
+            getMinMax(samples, span_count, span_min, span_max);
+        }
+
+        if (span_min < min) {
+            min = span_min;
+        }
+
+        if (span_max > max) {
+            max = span_max;
+        }
+
+        start += span_count;
+        count -= span_count;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the RMS of values whose squares add up to sum_squares.
+
+static short getRms(const long long sum_squares, const long long count)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    const double rms = std::sqrt(static_cast<double>(sum_squares) / static_cast<double>(count));
+
+    return static_cast<short>(
+        std::min(std::lround(rms), static_cast<long>(std::numeric_limits<short>::max()))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the sum of the squares of count points' RMS values, from which the
+// RMS of their input samples is found, as each point covers the same number
+// of samples (except the last).
+
+static long long getSumSquares(
+    const WaveformBuffer& buffer,
+    const long long start,
+    const long long count)
+{
+    long long sum_squares = 0;
+
+    for (long long i = start; i < start + count; ++i) {
+        const long long rms = buffer.getRmsSample(i);
+        sum_squares += rms * rms;
+    }
+
+    return sum_squares;
+}
+
+//------------------------------------------------------------------------------
+
+// Appends a point to the output buffer, with the RMS of the input points'
+// RMS values if the buffer has RMS values.
+
+static void appendPoint(
+    WaveformBuffer& output_buffer,
+    const short min,
+    const short max,
+    const long long sum_squares,
+    const long long count)
+{
+    if (output_buffer.hasRms()) {
+        output_buffer.appendSamples(min, max, getRms(sum_squares, count));
+    }
+    else {
+        output_buffer.appendSamples(min, max);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Appends a point with each channel's min and max values.
+
+static void appendPoint(
+    WaveformBuffer& output_buffer,
+    const std::vector<short>& min,
+    const std::vector<short>& max,
+    const long long sum_squares,
+    const long long count)
+{
+    for (size_t channel = 0; channel < min.size(); ++channel) {
+        appendPoint(output_buffer, min[channel], max[channel], sum_squares, count);
+    }
+}
+
 //------------------------------------------------------------------------------
 
 WaveformRescaler::WaveformRescaler() :
@@ -40,6 +301,12 @@ WaveformRescaler::WaveformRescaler() :
 
 //------------------------------------------------------------------------------
 
+WaveformRescaler::~WaveformRescaler()
+{
+}
+
+//------------------------------------------------------------------------------
+
 // See Sequence::GetWaveDisplay in Audacity
 
 bool WaveformRescaler::rescale(
@@ -58,66 +325,105 @@ bool WaveformRescaler::rescale(
     assert(input_samples_per_pixel > 0);
     assert(output_samples_per_pixel_ > input_samples_per_pixel);
 
-    const int input_buffer_size = input_buffer.getSize();
+    const long long input_buffer_size = input_buffer.getSize();
 
     output_buffer.setSampleRate(sample_rate_);
+    output_buffer.setBits(input_buffer.getBits());
     output_buffer.setSamplesPerPixel(samples_per_pixel);
+    output_buffer.setChannels(input_buffer.getChannels());
+    output_buffer.setRms(input_buffer.hasRms());
 
     output_stream << "Input scale: " << input_samples_per_pixel << " samples/pixel"
                   << "\nOutput scale: " << samples_per_pixel << " samples/pixel"
                   << "\nInput buffer size: " << input_buffer_size << std::endl;
 
-    short min = 0;
-    short max = 0;
+    if (samples_per_pixel % input_samples_per_pixel == 0) {
+        rescaleBlocks(
+            input_buffer,
+            output_buffer,
+            samples_per_pixel / input_samples_per_pixel
+        );
+
+        output_stream << "Generated " << output_buffer.getSize() << " points"
+                      << std::endl;
+
+        return true;
+    }
+
+    const int channels = input_buffer.getChannels();
+
+    std::vector<short> min(static_cast<size_t>(channels), 0);
+    std::vector<short> max(static_cast<size_t>(channels), 0);
 
     if (input_buffer_size > 0) {
-        min = input_buffer.getMinSample(0);
-        max = input_buffer.getMaxSample(0);
+        for (int channel = 0; channel < channels; ++channel) {
+            min[static_cast<size_t>(channel)] = input_buffer.getMinSample(channel, 0);
+            max[static_cast<size_t>(channel)] = input_buffer.getMaxSample(channel, 0);
+        }
     }
 
-    int input_index  = 0;
-    int output_index = 0;
+    const bool has_rms = input_buffer.hasRms();
 
-    int last_input_index = 0;
+    // Sum of squares of the RMS values of the input points in the current
+    // output point, and the number of input points
+    long long sum_squares = 0;
+    long long count = 0;
+
+    long long input_index  = 0;
+    long long output_index = 0;
+
+    long long last_input_index = 0;
 
     while (input_index < input_buffer_size) {
         while (sampleAtPixel(output_index) / input_samples_per_pixel == input_index) {
             if (output_index > 0) {
-                output_buffer.appendSamples(min, max);
+                appendPoint(output_buffer, min, max, sum_squares, count);
             }
 
             last_input_index = input_index;
 
             output_index++;
 
-            const int where      = sampleAtPixel(output_index);
-            const int prev_where = sampleAtPixel(output_index - 1);
+            const long long where      = sampleAtPixel(output_index);
+            const long long prev_where = sampleAtPixel(output_index - 1);
 
             if (where != prev_where) {
-                min = std::numeric_limits<short>::max();
-                max = std::numeric_limits<short>::min();
+                std::fill(min.begin(), min.end(), std::numeric_limits<short>::max());
+                std::fill(max.begin(), max.end(), std::numeric_limits<short>::min());
+                sum_squares = 0;
+                count = 0;
             }
         }
 
-        const int where = sampleAtPixel(output_index);
+        const long long where = sampleAtPixel(output_index);
 
-        int stop = where / input_samples_per_pixel;
+        long long stop = where / input_samples_per_pixel;
 
         if (stop > input_buffer_size) {
             stop = input_buffer_size;
         }
 
         while (input_index < stop) {
-            short value = input_buffer.getMinSample(input_index);
+            for (int channel = 0; channel < channels; ++channel) {
+                const size_t i = static_cast<size_t>(channel);
 
-            if (value < min) {
-                min = value;
-            }
+                short value = input_buffer.getMinSample(channel, input_index);
+
+                if (value < min[i]) {
+                    min[i] = value;
+                }
 
-            value = input_buffer.getMaxSample(input_index);
+                value = input_buffer.getMaxSample(channel, input_index);
 
-            if (value > max) {
-                max = value;
+                if (value > max[i]) {
+                    max[i] = value;
+                }
+            }
+
+            if (has_rms) {
+                const long long rms = input_buffer.getRmsSample(input_index);
+                sum_squares += rms * rms;
+                count++;
             }
 
             input_index++;
@@ -125,7 +431,273 @@ bool WaveformRescaler::rescale(
     }
 
     if (input_index != last_input_index) {
-        output_buffer.appendSamples(min, max);
+        appendPoint(output_buffer, min, max, sum_squares, count);
+    }
+
+    output_stream << "Generated " << output_buffer.getSize() << " points"
+                  << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Rescales to each of the given zoom levels, which may be in any order, and
+// must be no less than the input scale. Each distinct level greater than the
+// input scale is rescaled once, in increasing order, and levels equal to the
+// input scale use the input buffer.
+//
+// Each level is rescaled from the most detailed level before it whose zoom
+// divides its own, which gives the same min and max values as rescaling the
+// input, as its output points cover whole blocks of that level's points. So
+// the full input is read only for the first level, and levels with no such
+// divisor. RMS values would not be the same, as they are rounded at each
+// level, so data with RMS values is always rescaled from the input.
+
+bool WaveformRescaler::rescale(
+    const WaveformBuffer& input_buffer,
+    const std::vector<int>& zoom_levels,
+    std::vector<const WaveformBuffer*>& output_buffers)
+{
+    const int input_samples_per_pixel = input_buffer.getSamplesPerPixel();
+
+    output_buffers.clear();
+    zoom_levels_.clear();
+    zoom_buffers_.clear();
+
+    for (const int zoom : zoom_levels) {
+        assert(zoom >= input_samples_per_pixel);
+
+        if (zoom > input_samples_per_pixel) {
+            zoom_levels_.push_back(zoom);
+        }
+    }
+
+    std::sort(zoom_levels_.begin(), zoom_levels_.end());
+
+    zoom_levels_.erase(
+        std::unique(zoom_levels_.begin(), zoom_levels_.end()),
+        zoom_levels_.end()
+    );
+
+    for (size_t i = 0; i < zoom_levels_.size(); ++i) {
+        const int zoom = zoom_levels_[i];
+
+        const WaveformBuffer* source_buffer = &input_buffer;
+
+        for (size_t j = i; j > 0 && !input_buffer.hasRms(); --j) {
+            if (zoom % zoom_levels_[j - 1] == 0) {
+                source_buffer = zoom_buffers_[j - 1].get();
+                break;
+            }
+        }
+
+        zoom_buffers_.emplace_back(new WaveformBuffer);
+
+        if (!rescale(*source_buffer, *zoom_buffers_.back(), zoom)) {
+            return false;
+        }
+    }
+
+    for (const int zoom : zoom_levels) {
+        if (zoom == input_samples_per_pixel) {
+            output_buffers.push_back(&input_buffer);
+        }
+        else {
+            const auto i = std::lower_bound(zoom_levels_.begin(), zoom_levels_.end(), zoom);
+
+            output_buffers.push_back(
+                zoom_buffers_[static_cast<size_t>(i - zoom_levels_.begin())].get()
+            );
+        }
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+// Used when the output scale is a whole multiple of the input scale, so each
+// output point covers exactly ratio input points (fewer for the last point).
+// This gives the same result as the Audacity algorithm.
+
+void WaveformRescaler::rescaleBlocks(
+    const WaveformBuffer& input_buffer,
+    WaveformBuffer& output_buffer,
+    const int ratio)
+{
+    const long long input_buffer_size = input_buffer.getSize();
+    const int channels = input_buffer.getChannels();
+
+    for (long long start = 0; start < input_buffer_size; start += ratio) {
+        const long long count = std::min<long long>(ratio, input_buffer_size - start);
+
+        const long long sum_squares = input_buffer.hasRms() ?
+            getSumSquares(input_buffer, start, count) : 0;
+
+        for (int channel = 0; channel < channels; ++channel) {
+            short min;
+            short max;
+
+            getMinMax(input_buffer, channel, start, count, min, max);
+
+            appendPoint(output_buffer, min, max, sum_squares, count);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Produces the same output as the linear rescale above, but finds the min and
+// max for each output point with a range query on the index, so the time taken
+// depends on the output size rather than the input size.
+
+bool WaveformRescaler::rescale(
+    const WaveformBuffer& input_buffer,
+    const WaveformIndex& index,
+    WaveformBuffer& output_buffer,
+    int samples_per_pixel)
+{
+    return rescaleRange(
+        input_buffer,
+        &index,
+        output_buffer,
+        samples_per_pixel,
+        0,
+        std::numeric_limits<long long>::max()
+    );
+}
+
+//------------------------------------------------------------------------------
+
+// Produces only output points start_index to start_index + count - 1, for
+// example the columns visible in an image, reading only the input points that
+// map to them.
+
+bool WaveformRescaler::rescale(
+    const WaveformBuffer& input_buffer,
+    WaveformBuffer& output_buffer,
+    int samples_per_pixel,
+    long long start_index,
+    long long count)
+{
+    return rescaleRange(
+        input_buffer,
+        nullptr,
+        output_buffer,
+        samples_per_pixel,
+        start_index,
+        count
+    );
+}
+
+//------------------------------------------------------------------------------
+
+bool WaveformRescaler::rescale(
+    const WaveformBuffer& input_buffer,
+    const WaveformIndex& index,
+    WaveformBuffer& output_buffer,
+    int samples_per_pixel,
+    long long start_index,
+    long long count)
+{
+    return rescaleRange(
+        input_buffer,
+        &index,
+        output_buffer,
+        samples_per_pixel,
+        start_index,
+        count
+    );
+}
+
+//------------------------------------------------------------------------------
+
+// Output point x covers input points from sampleAtPixel(x) /
+// input_samples_per_pixel up to, but not including, sampleAtPixel(x + 1) /
+// input_samples_per_pixel, which gives the same result as the Audacity
+// algorithm. The min and max over each range are found using the index, if
+// given, or by scanning the input points. The index only supports
+// single-channel data.
+
+bool WaveformRescaler::rescaleRange(
+    const WaveformBuffer& input_buffer,
+    const WaveformIndex* index,
+    WaveformBuffer& output_buffer,
+    const int samples_per_pixel,
+    const long long start_index,
+    const long long count)
+{
+    output_stream << "Rescaling to " << samples_per_pixel << " samples/pixel\n";
+
+    sample_rate_ = input_buffer.getSampleRate();
+    output_samples_per_pixel_ = samples_per_pixel;
+    const int input_samples_per_pixel = input_buffer.getSamplesPerPixel();
+
+    assert(sample_rate_ > 0);
+    assert(output_samples_per_pixel_ > 0);
+    assert(input_samples_per_pixel > 0);
+    assert(output_samples_per_pixel_ > input_samples_per_pixel);
+    assert(start_index >= 0);
+
+    const long long input_buffer_size = input_buffer.getSize();
+    const int channels = input_buffer.getChannels();
+
+    if (index != nullptr && channels > 1) {
+        error_stream << "Can't use an index with multi-channel waveform data\n";
+        return false;
+    }
+
+    output_buffer.setSampleRate(sample_rate_);
+    output_buffer.setBits(input_buffer.getBits());
+    output_buffer.setSamplesPerPixel(samples_per_pixel);
+    output_buffer.setChannels(channels);
+    output_buffer.setRms(input_buffer.hasRms());
+
+    output_stream << "Input scale: " << input_samples_per_pixel << " samples/pixel"
+                  << "\nOutput scale: " << samples_per_pixel << " samples/pixel"
+                  << "\nInput buffer size: " << input_buffer_size;
+
+    if (start_index > 0) {
+        output_stream << "\nOutput start index: " << start_index;
+    }
+
+    output_stream << std::endl;
+
+    // Saturate, as count may be the maximum value, meaning no limit
+    const long long end_index =
+        count > std::numeric_limits<long long>::max() - start_index ?
+        std::numeric_limits<long long>::max() : start_index + count;
+
+    for (long long x = start_index; x < end_index; ++x) {
+        const long long start = x * samples_per_pixel / input_samples_per_pixel;
+
+        if (start >= input_buffer_size) {
+            break;
+        }
+
+        const long long end = std::min(
+            (x + 1) * samples_per_pixel / input_samples_per_pixel,
+            input_buffer_size
+        );
+
+        // The index has no RMS values, so these are always read from the input
+        const long long sum_squares = input_buffer.hasRms() ?
+            getSumSquares(input_buffer, start, end - start) : 0;
+
+        for (int channel = 0; channel < channels; ++channel) {
+            short min;
+            short max;
+
+            if (index != nullptr) {
+                index->getMinMax(start, end, min, max);
+            }
+            else {
+                getMinMax(input_buffer, channel, start, end - start, min, max);
+            }
+
+            appendPoint(output_buffer, min, max, sum_squares, end - start);
+        }
     }
 
     output_stream << "Generated " << output_buffer.getSize() << " points"
@@ -136,7 +708,7 @@ bool WaveformRescaler::rescale(
 
 //------------------------------------------------------------------------------
 
-int WaveformRescaler::sampleAtPixel(const int x) const
+long long WaveformRescaler::sampleAtPixel(const long long x) const
 {
     return x * output_samples_per_pixel_;
 }
@@ -24,9 +24,13 @@
 #if !defined(INC_WAVEFORM_RESCALER_H)
 #define INC_WAVEFORM_RESCALER_H
 
+#include <memory>
+#include <vector>
+
 //------------------------------------------------------------------------------
 
 class WaveformBuffer;
+class WaveformIndex;
 
 //------------------------------------------------------------------------------
 
@@ -34,6 +38,7 @@ class WaveformRescaler
 {
     public:
         WaveformRescaler();
+        ~WaveformRescaler();
 
         WaveformRescaler(const WaveformRescaler&) = delete;
         WaveformRescaler& operator=(const WaveformRescaler&) = delete;
@@ -45,12 +50,64 @@ class WaveformRescaler
             int samples_per_pixel
         );
 
+        bool rescale(
+            const WaveformBuffer& input_buffer,
+            const WaveformIndex& index,
+            WaveformBuffer& output_buffer,
+            int samples_per_pixel
+        );
+
+        bool rescale(
+            const WaveformBuffer& input_buffer,
+            WaveformBuffer& output_buffer,
+            int samples_per_pixel,
+            long long start_index,
+            long long count
+        );
+
+        bool rescale(
+            const WaveformBuffer& input_buffer,
+            const WaveformIndex& index,
+            WaveformBuffer& output_buffer,
+            int samples_per_pixel,
+            long long start_index,
+            long long count
+        );
+
+        // Sets output_buffers to the buffer for each of the given zoom
+        // levels, in the same order. The buffers are owned by the rescaler,
+        // and are valid until it is destroyed or this is called again.
+        bool rescale(
+            const WaveformBuffer& input_buffer,
+            const std::vector<int>& zoom_levels,
+            std::vector<const WaveformBuffer*>& output_buffers
+        );
+
     private:
-        int sampleAtPixel(int x) const;
+        void rescaleBlocks(
+            const WaveformBuffer& input_buffer,
+            WaveformBuffer& output_buffer,
+            int ratio
+        );
+
+        bool rescaleRange(
+            const WaveformBuffer& input_buffer,
+            const WaveformIndex* index,
+            WaveformBuffer& output_buffer,
+            int samples_per_pixel,
+            long long start_index,
+            long long count
+        );
+
+        long long sampleAtPixel(long long x) const;
 
     private:
         int sample_rate_;
         int output_samples_per_pixel_;
+
+        // The buffers rescaled to each zoom level, in increasing order
+        std::vector<int> zoom_levels_;
+        std::vector<std::unique_ptr<WaveformBuffer>> zoom_buffers_;
 };
 
 //------------------------------------------------------------------------------
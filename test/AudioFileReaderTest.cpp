@@ -23,6 +23,7 @@
 
 #include "AudioFileReader.h"
 #include "AudioProcessor.h"
+#include "mocks/MockAudioProcessor.h"
 #include "util/Streams.h"
 
 #include "gmock/gmock.h"
@@ -32,7 +33,14 @@
 
 //------------------------------------------------------------------------------
 
+using testing::_;
+using testing::AllOf;
+using testing::Field;
+using testing::InSequence;
+using testing::Pointee;
+using testing::Return;
 using testing::StrEq;
+using testing::StrictMock;
 using testing::Test;
 
 //------------------------------------------------------------------------------
@@ -58,6 +66,47 @@ class TestAudioFileReader : public AudioFileReader
 
 //------------------------------------------------------------------------------
 
+// Produces 5 buffers of 10 stereo frames, where each sample value is twice
+// the frame number, plus the channel number.
+
+class FrameAudioFileReader : public AudioFileReader
+{
+    public:
+        virtual bool open(const char* /* input_filename */)
+        {
+            return true;
+        }
+
+        virtual bool run(AudioProcessor& processor)
+        {
+            AudioStreamInfo info(16000, 2);
+            info.frame_count       = 50;
+            info.frame_count_exact = true;
+
+            if (!processor.init(info, 20)) {
+                return false;
+            }
+
+            short buffer[20];
+
+            for (int i = 0; i < 5; ++i) {
+                for (int j = 0; j < 20; ++j) {
+                    buffer[j] = static_cast<short>(i * 20 + j);
+                }
+
+                if (!processor.process(buffer, 10)) {
+                    return false;
+                }
+            }
+
+            processor.done();
+
+            return true;
+        }
+};
+
+//------------------------------------------------------------------------------
+
 class AudioFileReaderTest : public Test
 {
     protected:
@@ -173,3 +222,54 @@ TEST_F(AudioFileReaderTest, shouldAllowLargeNumbers)
 }
 
 //------------------------------------------------------------------------------
+
+TEST_F(AudioFileReaderTest, shouldProcessRangeOfFrames)
+{
+    FrameAudioFileReader reader;
+
+    StrictMock<MockAudioProcessor> processor;
+
+    InSequence sequence; // Calls expected in the order listed below.
+
+    EXPECT_CALL(processor, init(
+        AllOf(
+            StreamInfo(16000, 2),
+            Field(&AudioStreamInfo::frame_count, 18)
+        ),
+        20
+    )).WillOnce(Return(true));
+    EXPECT_CALL(processor, process(Pointee(30), 5)).WillOnce(Return(true));
+    EXPECT_CALL(processor, process(Pointee(40), 10)).WillOnce(Return(true));
+    EXPECT_CALL(processor, process(Pointee(60), 3)).WillOnce(Return(true));
+    EXPECT_CALL(processor, done());
+
+    bool result = reader.runRange(processor, 15, 18);
+
+    ASSERT_TRUE(result);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(AudioFileReaderTest, shouldProcessNoFramesIfRangeIsAfterEnd)
+{
+    FrameAudioFileReader reader;
+
+    StrictMock<MockAudioProcessor> processor;
+
+    InSequence sequence; // Calls expected in the order listed below.
+
+    EXPECT_CALL(processor, init(
+        AllOf(
+            StreamInfo(16000, 2),
+            Field(&AudioStreamInfo::frame_count, 0)
+        ),
+        20
+    )).WillOnce(Return(true));
+    EXPECT_CALL(processor, done());
+
+    bool result = reader.runRange(processor, 50, 10);
+
+    ASSERT_TRUE(result);
+}
+
+//------------------------------------------------------------------------------
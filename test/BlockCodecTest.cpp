@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "BlockCodec.h"
+
+#include "gmock/gmock.h"
+
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class BlockCodecTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+        }
+
+        virtual void TearDown()
+        {
+        }
+};
+
+//------------------------------------------------------------------------------
+
+static void testRoundTrip(const std::vector<short>& values)
+{
+    const int count = static_cast<int>(values.size());
+
+    std::vector<uint8_t> data;
+    BlockCodec::encode(&values[0], count, data);
+
+    std::vector<short> decoded(values.size());
+
+    const size_t size = BlockCodec::decode(&data[0], data.size(), &decoded[0], count);
+    ASSERT_THAT(size, Eq(data.size()));
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_THAT(decoded[i], Eq(values[i]));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(BlockCodecTest, shouldDecodeRandomValues)
+{
+    srand(1);
+
+    // Include counts either side of multiples of eight, to exercise both the
+    // vector and scalar parts of the decoder
+    const int counts[] = { 1, 2, 7, 8, 9, 16, 17, 100, 4096 };
+
+    for (const int count : counts) {
+        std::vector<short> values;
+
+        for (int i = 0; i < count; ++i) {
+            values.push_back(static_cast<short>(rand() % 65536 - 32768));
+        }
+
+        testRoundTrip(values);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(BlockCodecTest, shouldDecodeLargestDeltas)
+{
+    std::vector<short> values;
+
+    for (int i = 0; i < 50; ++i) {
+        values.push_back(i % 2 == 0 ?
+            std::numeric_limits<short>::min() :
+            std::numeric_limits<short>::max()
+        );
+    }
+
+    testRoundTrip(values);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(BlockCodecTest, shouldPackSmallDeltasIntoFewBits)
+{
+    std::vector<short> values;
+
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(static_cast<short>(1000 + (i % 8) - 4));
+    }
+
+    testRoundTrip(values);
+
+    std::vector<uint8_t> data;
+    BlockCodec::encode(&values[0], 1000, data);
+
+    // Deltas from -7 to 1 need 4 bits when zigzag encoded
+    ASSERT_THAT(data.size(), Eq(3U + (999U * 4U + 7U) / 8U));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(BlockCodecTest, shouldEncodeConstantValuesInThreeBytes)
+{
+    const std::vector<short> values(500, -1234);
+
+    testRoundTrip(values);
+
+    std::vector<uint8_t> data;
+    BlockCodec::encode(&values[0], 500, data);
+
+    ASSERT_THAT(data.size(), Eq(3U));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(BlockCodecTest, shouldNotDecodeTruncatedData)
+{
+    std::vector<short> values;
+
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(static_cast<short>(i * 100));
+    }
+
+    std::vector<uint8_t> data;
+    BlockCodec::encode(&values[0], 100, data);
+
+    std::vector<short> decoded(100);
+
+    ASSERT_THAT(BlockCodec::decode(&data[0], data.size() - 1, &decoded[0], 100), Eq(0U));
+    ASSERT_THAT(BlockCodec::decode(&data[0], 2, &decoded[0], 100), Eq(0U));
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,169 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+
+#include "ChunkedVector.h"
+
+#include "gmock/gmock.h"
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class ChunkedVectorTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+        }
+
+        virtual void TearDown()
+        {
+        }
+
+        ChunkedVector<short> vector_;
+};
+
+//------------------------------------------------------------------------------
+
+static const size_t CHUNK_SIZE = ChunkedVector<short>::CHUNK_SIZE;
+
+//------------------------------------------------------------------------------
+
+TEST_F(ChunkedVectorTest, shouldConstructEmpty)
+{
+    ASSERT_TRUE(vector_.empty());
+    ASSERT_THAT(vector_.size(), Eq(0U));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(ChunkedVectorTest, shouldAppendValuesAcrossChunks)
+{
+    const size_t size = CHUNK_SIZE * 2 + 3;
+
+    for (size_t i = 0; i < size; ++i) {
+        vector_.push_back(static_cast<short>(i % 30000));
+    }
+
+    ASSERT_FALSE(vector_.empty());
+    ASSERT_THAT(vector_.size(), Eq(size));
+
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_THAT(vector_[i], Eq(static_cast<short>(i % 30000)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(ChunkedVectorTest, shouldReturnContiguousSpans)
+{
+    const size_t size = CHUNK_SIZE + 10;
+
+    for (size_t i = 0; i < size; ++i) {
+        vector_.push_back(static_cast<short>(i % 30000));
+    }
+
+    const short* data;
+
+    ASSERT_THAT(vector_.getSpan(0, data), Eq(CHUNK_SIZE));
+    ASSERT_THAT(data[0], Eq(0));
+
+    ASSERT_THAT(vector_.getSpan(CHUNK_SIZE - 2, data), Eq(2U));
+    ASSERT_THAT(data[1], Eq(vector_[CHUNK_SIZE - 1]));
+
+    ASSERT_THAT(vector_.getSpan(CHUNK_SIZE, data), Eq(10U));
+    ASSERT_THAT(data[9], Eq(vector_[size - 1]));
+
+    ASSERT_THAT(vector_.getSpan(size - 1, data), Eq(1U));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(ChunkedVectorTest, shouldSetNewValuesToZeroWhenResized)
+{
+    for (int i = 0; i < 100; ++i) {
+        vector_.push_back(7);
+    }
+
+    vector_.resize(50);
+    ASSERT_THAT(vector_.size(), Eq(50U));
+
+    vector_.resize(CHUNK_SIZE + 1);
+    ASSERT_THAT(vector_.size(), Eq(CHUNK_SIZE + 1));
+
+    ASSERT_THAT(vector_[49], Eq(7));
+    ASSERT_THAT(vector_[50], Eq(0));
+    ASSERT_THAT(vector_[99], Eq(0));
+    ASSERT_THAT(vector_[CHUNK_SIZE], Eq(0));
+
+    vector_[CHUNK_SIZE] = 5;
+    ASSERT_THAT(vector_[CHUNK_SIZE], Eq(5));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(ChunkedVectorTest, shouldClearValues)
+{
+    for (size_t i = 0; i < CHUNK_SIZE + 1; ++i) {
+        vector_.push_back(1);
+    }
+
+    vector_.clear();
+
+    ASSERT_TRUE(vector_.empty());
+
+    vector_.push_back(3);
+
+    ASSERT_THAT(vector_.size(), Eq(1U));
+    ASSERT_THAT(vector_[0], Eq(3));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(ChunkedVectorTest, shouldReserveCapacityWithoutChangingSize)
+{
+    vector_.push_back(1);
+
+    vector_.reserve(2 * CHUNK_SIZE + 1);
+
+    ASSERT_THAT(vector_.size(), Eq(1U));
+    ASSERT_THAT(vector_.capacity(), Eq(3 * CHUNK_SIZE));
+    ASSERT_THAT(vector_[0], Eq(1));
+
+    for (size_t i = 1; i < 2 * CHUNK_SIZE + 1; ++i) {
+        vector_.push_back(2);
+    }
+
+    ASSERT_THAT(vector_.capacity(), Eq(3 * CHUNK_SIZE));
+    ASSERT_THAT(vector_[2 * CHUNK_SIZE], Eq(2));
+
+    vector_.reserve(10);
+
+    ASSERT_THAT(vector_.capacity(), Eq(3 * CHUNK_SIZE));
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2013, 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+
+#include "ErrorUtil.h"
+
+#include "gmock/gmock.h"
+
+#include <cerrno>
+
+//------------------------------------------------------------------------------
+
+using testing::IsEmpty;
+using testing::Not;
+using testing::StrEq;
+
+//------------------------------------------------------------------------------
+
+TEST(ErrorUtilTest, shouldReturnErrorMessage)
+{
+    ASSERT_THAT(ErrorUtil::errorToString(ENOENT), StrEq("No such file or directory"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST(ErrorUtilTest, shouldReturnMessageForUnknownError)
+{
+    ASSERT_THAT(ErrorUtil::errorToString(-12345), Not(IsEmpty()));
+}
+
+//------------------------------------------------------------------------------
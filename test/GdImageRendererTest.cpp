@@ -30,11 +30,14 @@
 
 #include "gmock/gmock.h"
 
+#include <set>
+
 //------------------------------------------------------------------------------
 
 using testing::EndsWith;
 using testing::Eq;
 using testing::Gt;
+using testing::HasSubstr;
 using testing::StartsWith;
 using testing::Test;
 
@@ -55,6 +58,11 @@ class GdImageRendererTest : public Test
 
         void testImageRendering(bool axis_labels);
 
+        void testStreamedImageRendering(
+            const WaveformColors& colors,
+            bool axis_labels
+        );
+
         WaveformBuffer buffer_;
         GdImageRenderer renderer_;
 };
@@ -93,6 +101,66 @@ void GdImageRendererTest::testImageRendering(bool axis_labels)
 
 //------------------------------------------------------------------------------
 
+// Checks that renderToPng() produces the same pixels as create() followed by
+// saveAsPng().
+
+void GdImageRendererTest::testStreamedImageRendering(
+    const WaveformColors& colors,
+    bool axis_labels)
+{
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path actual_filename   = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter actual_deleter(actual_filename);
+
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    result = renderer_.create(buffer_, 5.0, 1000, 300, colors, axis_labels);
+    ASSERT_TRUE(result);
+
+    result = renderer_.saveAsPng(expected_filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    GdImageRenderer renderer;
+
+    result = renderer.renderToPng(
+        buffer_, 5.0, 1000, 300, colors, axis_labels, actual_filename.string().c_str()
+    );
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    gdImagePtr expected = FileUtil::readPngFile(expected_filename);
+    ASSERT_TRUE(expected != nullptr);
+
+    gdImagePtr actual = FileUtil::readPngFile(actual_filename);
+    ASSERT_TRUE(actual != nullptr);
+
+    ASSERT_THAT(gdImageSX(actual), Eq(1000));
+    ASSERT_THAT(gdImageSY(actual), Eq(300));
+
+    int mismatches = 0;
+
+    for (int y = 0; y < 300; ++y) {
+        for (int x = 0; x < 1000; ++x) {
+            if (gdImageGetTrueColorPixel(actual, x, y) !=
+                gdImageGetTrueColorPixel(expected, x, y)) {
+                mismatches++;
+            }
+        }
+    }
+
+    gdImageDestroy(expected);
+    gdImageDestroy(actual);
+
+    ASSERT_THAT(mismatches, Eq(0));
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(GdImageRendererTest, shouldRenderImageWithAxisLabels)
 {
     testImageRendering(true);
@@ -107,6 +175,366 @@ TEST_F(GdImageRendererTest, shouldRenderImageWithoutAxisLabels)
 
 //------------------------------------------------------------------------------
 
+// A palette image should have the same pixels as a true color image, and a
+// palette of only the colors drawn.
+
+TEST_F(GdImageRendererTest, shouldRenderPaletteImage)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter deleter(filename);
+    FileDeleter expected_deleter(expected_filename);
+
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    const WaveformColors& colors = audacity_waveform_colors;
+
+    result = renderer_.create(buffer_, 5.0, 1000, 300, colors, true, true);
+    ASSERT_TRUE(result);
+
+    result = renderer_.saveAsPng(filename.string().c_str(), 9);
+    ASSERT_TRUE(result);
+
+    GdImageRenderer true_color_renderer;
+
+    result = true_color_renderer.create(buffer_, 5.0, 1000, 300, colors, true, false);
+    ASSERT_TRUE(result);
+
+    result = true_color_renderer.saveAsPng(expected_filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    ASSERT_TRUE(error.str().empty());
+
+    gdImagePtr image = FileUtil::readPngFile(filename);
+    ASSERT_TRUE(image != nullptr);
+
+    gdImagePtr expected = FileUtil::readPngFile(expected_filename);
+    ASSERT_TRUE(expected != nullptr);
+
+    const bool is_true_color = gdImageTrueColor(image) != 0;
+
+    std::set<int> palette;
+
+    for (int i = 0; i < gdImageColorsTotal(image); ++i) {
+        palette.insert(gdTrueColor(
+            gdImageRed(image, i),
+            gdImageGreen(image, i),
+            gdImageBlue(image, i)
+        ));
+    }
+
+    int mismatches = 0;
+
+    for (int y = 0; y < 300; ++y) {
+        for (int x = 0; x < 1000; ++x) {
+            if (gdImageGetTrueColorPixel(image, x, y) !=
+                gdImageGetTrueColorPixel(expected, x, y)) {
+                mismatches++;
+            }
+        }
+    }
+
+    gdImageDestroy(image);
+    gdImageDestroy(expected);
+
+    ASSERT_FALSE(is_true_color);
+
+    const std::set<int> expected_palette{
+        gdTrueColor(colors.border_color.red, colors.border_color.green, colors.border_color.blue),
+        gdTrueColor(colors.background_color.red, colors.background_color.green, colors.background_color.blue),
+        gdTrueColor(colors.waveform_color.red, colors.waveform_color.green, colors.waveform_color.blue),
+        gdTrueColor(colors.axis_label_color.red, colors.axis_label_color.green, colors.axis_label_color.blue)
+    };
+
+    ASSERT_THAT(palette, Eq(expected_palette));
+    ASSERT_THAT(mismatches, Eq(0));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldStreamImageWithAxisLabels)
+{
+    testStreamedImageRendering(audacity_waveform_colors, true);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldStreamImageWithoutAxisLabels)
+{
+    testStreamedImageRendering(audition_waveform_colors, false);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldStreamImageWithTransparentColors)
+{
+    WaveformColors colors = audacity_waveform_colors;
+    colors.background_color = RGBA(0, 0, 0, 0);
+    colors.waveform_color   = RGBA(0x3f, 0x3f, 0xff, 0x80);
+
+    testStreamedImageRendering(colors, true);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldRenderFromPartialBuffer)
+{
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    // 5.0 seconds at 16000 Hz and 64 samples per pixel
+    const int start_index = 1250;
+
+    WaveformBuffer partial_buffer;
+    partial_buffer.setSampleRate(buffer_.getSampleRate());
+    partial_buffer.setSamplesPerPixel(buffer_.getSamplesPerPixel());
+
+    for (int i = start_index; i < buffer_.getSize(); ++i) {
+        partial_buffer.appendSamples(buffer_.getMinSample(i), buffer_.getMaxSample(i));
+    }
+
+    const WaveformColors& colors = audacity_waveform_colors;
+
+    result = renderer_.create(buffer_, 5.0, 1000, 300, colors, true, true);
+    ASSERT_TRUE(result);
+
+    GdImageRenderer renderer;
+    renderer.setBufferStartIndex(start_index);
+
+    result = renderer.create(partial_buffer, 5.0, 1000, 300, colors, true, true);
+    ASSERT_TRUE(result);
+
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path actual_filename   = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter actual_deleter(actual_filename);
+
+    ASSERT_TRUE(renderer_.saveAsPng(expected_filename.string().c_str()));
+    ASSERT_TRUE(renderer.saveAsPng(actual_filename.string().c_str()));
+
+    gdImagePtr expected = FileUtil::readPngFile(expected_filename);
+    ASSERT_TRUE(expected != nullptr);
+
+    gdImagePtr actual = FileUtil::readPngFile(actual_filename);
+    ASSERT_TRUE(actual != nullptr);
+
+    int mismatches = 0;
+
+    for (int y = 0; y < 300; ++y) {
+        for (int x = 0; x < 1000; ++x) {
+            if (gdImageGetTrueColorPixel(actual, x, y) !=
+                gdImageGetTrueColorPixel(expected, x, y)) {
+                mismatches++;
+            }
+        }
+    }
+
+    gdImageDestroy(expected);
+    gdImageDestroy(actual);
+
+    ASSERT_THAT(mismatches, Eq(0));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldRenderImageStartingAfterTwelveHours)
+{
+    // 60 hours at 48 kHz and 256 samples per pixel
+    const long long start_index = 40500000;
+
+    WaveformBuffer partial_buffer;
+    partial_buffer.setSampleRate(48000);
+    partial_buffer.setSamplesPerPixel(256);
+
+    for (int i = 0; i < 1000; ++i) {
+        partial_buffer.appendSamples(-1000, 1000);
+    }
+
+    renderer_.setBufferStartIndex(start_index);
+
+    bool result = renderer_.create(
+        partial_buffer,
+        60 * 60 * 60,
+        1000,
+        300,
+        audacity_waveform_colors,
+        true,
+        false
+    );
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output.str(), HasSubstr("Start index: 40500000\n"));
+    ASSERT_TRUE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldRenderAxisLabelsForStartTimeBeyondIntRange)
+{
+    // 3000000000 seconds at 8 kHz and 256 samples per pixel
+    const long long start_index = 93750000000LL;
+
+    WaveformBuffer partial_buffer;
+    partial_buffer.setSampleRate(8000);
+    partial_buffer.setSamplesPerPixel(256);
+
+    for (int i = 0; i < 1000; ++i) {
+        partial_buffer.appendSamples(-1000, 1000);
+    }
+
+    renderer_.setBufferStartIndex(start_index);
+
+    bool result = renderer_.create(
+        partial_buffer,
+        3000000000.0,
+        1000,
+        300,
+        audacity_waveform_colors,
+        true,
+        false
+    );
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output.str(), HasSubstr("First axis label: 3000000000 secs\n"));
+    ASSERT_TRUE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldReportErrorIfStartTimeIsTooLarge)
+{
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    result = renderer_.create(
+        buffer_,
+        1.0e12,
+        1000,
+        300,
+        audacity_waveform_colors,
+        true,
+        false
+    );
+
+    ASSERT_FALSE(result);
+    ASSERT_THAT(error.str(), StartsWith("Invalid start time: maximum "));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldRenderRmsValuesAsInnerBand)
+{
+    buffer_.setSampleRate(48000);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setRms(true);
+
+    for (int i = 0; i < 100; ++i) {
+        buffer_.appendSamples(-20000, 20000, 10000);
+    }
+
+    const WaveformColors& colors = audacity_waveform_colors;
+
+    bool result = renderer_.create(buffer_, 0.0, 100, 100, colors, false, false);
+    ASSERT_TRUE(result);
+
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    ASSERT_TRUE(renderer_.saveAsPng(filename.string().c_str()));
+
+    gdImagePtr image = FileUtil::readPngFile(filename);
+    ASSERT_TRUE(image != nullptr);
+
+    const RGBA& rms_color = colors.rms_color;
+    const RGBA& waveform_color = colors.waveform_color;
+
+    // The centre line is within the RMS band, and y = 25 (about 16000) is
+    // between the RMS and max values
+    const int centre_pixel = gdImageGetTrueColorPixel(image, 50, 49);
+    const int outer_pixel  = gdImageGetTrueColorPixel(image, 50, 25);
+
+    gdImageDestroy(image);
+
+    ASSERT_THAT(centre_pixel, Eq(gdTrueColor(rms_color.red, rms_color.green, rms_color.blue)));
+    ASSERT_THAT(outer_pixel, Eq(gdTrueColor(waveform_color.red, waveform_color.green, waveform_color.blue)));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldRenderEachChannelInSeparateBand)
+{
+    buffer_.setSampleRate(48000);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setChannels(2);
+
+    // A loud first channel and a quiet second channel
+    for (int i = 0; i < 100; ++i) {
+        buffer_.appendSamples(-20000, 20000);
+        buffer_.appendSamples(-1000, 1000);
+    }
+
+    const WaveformColors& colors = audacity_waveform_colors;
+
+    bool result = renderer_.create(buffer_, 0.0, 100, 100, colors, false, false);
+    ASSERT_TRUE(result);
+
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    ASSERT_TRUE(renderer_.saveAsPng(filename.string().c_str()));
+
+    gdImagePtr image = FileUtil::readPngFile(filename);
+    ASSERT_TRUE(image != nullptr);
+
+    const RGBA& background_color = colors.background_color;
+    const RGBA& waveform_color = colors.waveform_color;
+
+    // The first channel fills most of the top half of the image, and the
+    // second channel only the middle of the bottom half
+    const int top_pixel    = gdImageGetTrueColorPixel(image, 50, 20);
+    const int bottom_pixel = gdImageGetTrueColorPixel(image, 50, 60);
+    const int centre_pixel = gdImageGetTrueColorPixel(image, 50, 74);
+
+    gdImageDestroy(image);
+
+    ASSERT_THAT(top_pixel, Eq(gdTrueColor(waveform_color.red, waveform_color.green, waveform_color.blue)));
+    ASSERT_THAT(bottom_pixel, Eq(gdTrueColor(background_color.red, background_color.green, background_color.blue)));
+    ASSERT_THAT(centre_pixel, Eq(gdTrueColor(waveform_color.red, waveform_color.green, waveform_color.blue)));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GdImageRendererTest, shouldReportErrorIfCompressionLevelIsInvalid)
+{
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    result = renderer_.create(buffer_, 0.0, 800, 250, audacity_waveform_colors, true);
+    ASSERT_TRUE(result);
+
+    output.str(std::string());
+
+    result = renderer_.saveAsPng("test.png", 10);
+
+    ASSERT_FALSE(result);
+    ASSERT_TRUE(output.str().empty());
+
+    std::string str = error.str();
+    ASSERT_THAT(str, StartsWith("Invalid PNG compression level"));
+    ASSERT_THAT(str, EndsWith("\n"));
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(GdImageRendererTest, shouldReportErrorIfImageWidthIsLessThanMinimum)
 {
     buffer_.setSampleRate(48000);
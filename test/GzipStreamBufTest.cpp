@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "GzipStreamBuf.h"
+#include "util/FileDeleter.h"
+#include "util/FileUtil.h"
+
+#include "gmock/gmock.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::Gt;
+using testing::Lt;
+using testing::StrEq;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class GzipStreamBufTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+        }
+
+        virtual void TearDown()
+        {
+        }
+};
+
+//------------------------------------------------------------------------------
+
+// Writes text to a gzip file at the given compression level.
+
+static void writeGzipFile(
+    const boost::filesystem::path& filename,
+    const std::string& text,
+    int compression_level)
+{
+    std::ofstream file(filename.string().c_str(), std::ios::out | std::ios::binary);
+
+    GzipStreamBuf buffer(file, compression_level);
+
+    std::ostream stream(&buffer);
+
+    // Write in small pieces, as a serializer would
+    for (size_t i = 0; i < text.size(); i += 100) {
+        stream << text.substr(i, 100);
+    }
+
+    stream.flush();
+    buffer.finish();
+}
+
+//------------------------------------------------------------------------------
+
+static std::string getText()
+{
+    std::ostringstream stream;
+
+    for (int i = 0; i < 100000; ++i) {
+        stream << -(i % 1000) << ',' << (i % 777) << '\n';
+    }
+
+    return stream.str();
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GzipStreamBufTest, shouldCompressDataWrittenToStream)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".gz");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    const std::string text = getText();
+
+    writeGzipFile(filename, text, -1);
+
+    ASSERT_THAT(boost::filesystem::file_size(filename), Lt(text.size() / 2));
+    ASSERT_THAT(FileUtil::readGzipFile(filename), StrEq(text));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GzipStreamBufTest, shouldWriteValidFileIfNothingWritten)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".gz");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    writeGzipFile(filename, std::string(), -1);
+
+    ASSERT_THAT(boost::filesystem::file_size(filename), Gt(0U));
+    ASSERT_THAT(FileUtil::readGzipFile(filename), StrEq(""));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GzipStreamBufTest, shouldUseCompressionLevel)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".gz");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    const std::string text = getText();
+
+    // Level 0 stores the data uncompressed
+    writeGzipFile(filename, text, 0);
+
+    ASSERT_THAT(boost::filesystem::file_size(filename), Gt(text.size()));
+    ASSERT_THAT(FileUtil::readGzipFile(filename), StrEq(text));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(GzipStreamBufTest, shouldThrowIfCompressionLevelInvalid)
+{
+    std::ostringstream output;
+
+    ASSERT_THROW(GzipStreamBuf(output, 10), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
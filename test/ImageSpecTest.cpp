@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "ImageSpec.h"
+
+#include "gmock/gmock.h"
+
+#include <sstream>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::StrEq;
+
+//------------------------------------------------------------------------------
+
+TEST(ImageSpecTest, shouldParseImageSpec)
+{
+    std::istringstream stream("800x150x1024:card.png");
+
+    ImageSpec image_spec;
+    stream >> image_spec;
+
+    ASSERT_THAT(image_spec.width, Eq(800));
+    ASSERT_THAT(image_spec.height, Eq(150));
+    ASSERT_THAT(image_spec.samples_per_pixel, Eq(1024));
+    ASSERT_THAT(image_spec.filename, StrEq("card.png"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST(ImageSpecTest, shouldParseImageSpecWithPath)
+{
+    std::istringstream stream("200x40x4096:/tmp/images/thumb:1.png");
+
+    ImageSpec image_spec;
+    stream >> image_spec;
+
+    ASSERT_THAT(image_spec.width, Eq(200));
+    ASSERT_THAT(image_spec.height, Eq(40));
+    ASSERT_THAT(image_spec.samples_per_pixel, Eq(4096));
+    ASSERT_THAT(image_spec.filename, StrEq("/tmp/images/thumb:1.png"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST(ImageSpecTest, shouldThrowIfEmptyString)
+{
+    std::istringstream stream("");
+
+    ImageSpec image_spec;
+    ASSERT_THROW(stream >> image_spec, std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+
+TEST(ImageSpecTest, shouldThrowIfFilenameMissing)
+{
+    std::istringstream stream("800x150x1024");
+
+    ImageSpec image_spec;
+    ASSERT_THROW(stream >> image_spec, std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+
+TEST(ImageSpecTest, shouldThrowIfNotAValidSize)
+{
+    std::istringstream stream("800x150:card.png");
+
+    ImageSpec image_spec;
+    ASSERT_THROW(stream >> image_spec, std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,178 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "JsonReader.h"
+
+#include "gmock/gmock.h"
+
+#include <sstream>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::StrEq;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class JsonReaderTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+        }
+
+        virtual void TearDown()
+        {
+        }
+};
+
+//------------------------------------------------------------------------------
+
+TEST_F(JsonReaderTest, shouldReadObject)
+{
+    std::istringstream stream(" { \"name\" : \"value\",\n\t\"number\":-123 } ");
+
+    JsonReader reader(stream);
+
+    reader.expect('{');
+    ASSERT_THAT(reader.readString(), StrEq("name"));
+    reader.expect(':');
+    ASSERT_THAT(reader.readString(), StrEq("value"));
+    ASSERT_TRUE(reader.consume(','));
+    ASSERT_THAT(reader.readString(), StrEq("number"));
+    reader.expect(':');
+    ASSERT_THAT(reader.readInteger(), Eq(-123));
+    ASSERT_FALSE(reader.consume(','));
+    reader.expect('}');
+    ASSERT_TRUE(reader.atEnd());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(JsonReaderTest, shouldReadIntegersAcrossBufferBoundaries)
+{
+    // Larger than the reader's buffer, so that numbers are split between reads
+    std::ostringstream json;
+
+    json << '[';
+
+    for (int i = 0; i < 100000; ++i) {
+        json << (i > 0 ? "," : "") << (i % 2 == 0 ? -i : i) * 37 % 100003;
+    }
+
+    json << ']';
+
+    std::istringstream stream(json.str());
+
+    JsonReader reader(stream);
+
+    reader.expect('[');
+
+    for (int i = 0; i < 100000; ++i) {
+        if (i > 0) {
+            ASSERT_TRUE(reader.consume(','));
+        }
+
+        ASSERT_THAT(reader.readInteger(), Eq((i % 2 == 0 ? -i : i) * 37 % 100003));
+    }
+
+    reader.expect(']');
+    ASSERT_TRUE(reader.atEnd());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(JsonReaderTest, shouldReadEscapedQuotesInStrings)
+{
+    std::istringstream stream("\"a\\\"b\\\\c\\n\"");
+
+    JsonReader reader(stream);
+
+    ASSERT_THAT(reader.readString(), StrEq("a\"b\\c\\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(JsonReaderTest, shouldSkipValuesOfAnyType)
+{
+    std::istringstream stream(
+        "[{\"a\":[1,2.5e3,{}],\"b\":\"x,]}\"},true,null,\"s\",[],-7]"
+    );
+
+    JsonReader reader(stream);
+
+    reader.expect('[');
+
+    for (int i = 0; i < 5; ++i) {
+        reader.skipValue();
+        ASSERT_TRUE(reader.consume(','));
+    }
+
+    ASSERT_THAT(reader.readInteger(), Eq(-7));
+    reader.expect(']');
+    ASSERT_TRUE(reader.atEnd());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(JsonReaderTest, shouldThrowIfNotAnInteger)
+{
+    const char* values[] = { "1.5", "-", "x", "", "12345678901234567890" };
+
+    for (const char* value : values) {
+        std::istringstream stream(value);
+
+        JsonReader reader(stream);
+
+        ASSERT_THROW(reader.readInteger(), std::runtime_error);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(JsonReaderTest, shouldThrowIfUnexpectedCharacter)
+{
+    std::istringstream stream("[1}");
+
+    JsonReader reader(stream);
+
+    reader.expect('[');
+    reader.readInteger();
+
+    ASSERT_THROW(reader.expect(']'), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(JsonReaderTest, shouldThrowIfStringNotTerminated)
+{
+    std::istringstream stream("\"abc");
+
+    JsonReader reader(stream);
+
+    ASSERT_THROW(reader.readString(), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
@@ -40,6 +40,9 @@ TEST(MathUtilTest, shouldRoundDownToNearestInteger)
     // Round towards positive infinity
     ASSERT_THAT(MathUtil::roundDownToNearest(-5.5, 3), Eq(-3));
 
+    // Beyond the range of int
+    ASSERT_THAT(MathUtil::roundDownToNearest(3000000005.5, 10), Eq(3000000000LL));
+
     ASSERT_THAT(MathUtil::roundDownToNearest(5.5, 0), Eq(0));
 }
 
@@ -54,6 +57,9 @@ TEST(MathUtilTest, shouldRoundUpToNearestInteger)
     // Round towards negative infinity
     ASSERT_THAT(MathUtil::roundUpToNearest(-5.5, 3), Eq(-6));
 
+    // Beyond the range of int
+    ASSERT_THAT(MathUtil::roundUpToNearest(3000000005.5, 10), Eq(3000000010LL));
+
     ASSERT_THAT(MathUtil::roundUpToNearest(5.5, 0), Eq(0));
 }
 
@@ -86,7 +86,7 @@ TEST_F(Mp3AudioFileReaderTest, shouldFailToProcessIfFileNotOpen)
 {
     StrictMock<MockAudioProcessor> processor;
 
-    EXPECT_CALL(processor, init(_, _, _)).Times(0);
+    EXPECT_CALL(processor, init(_, _)).Times(0);
     EXPECT_CALL(processor, process(_, _)).Times(0);
     EXPECT_CALL(processor, done()).Times(0);
 
@@ -108,7 +108,7 @@ TEST_F(Mp3AudioFileReaderTest, shouldProcessStereoMp3File)
 
     InSequence sequence; // Calls expected in the order listed below.
 
-    EXPECT_CALL(processor, init(16000, 2, 8192)).WillOnce(Return(true));
+    EXPECT_CALL(processor, init(StreamInfo(16000, 2), 8192)).WillOnce(Return(true));
 
     // TODO: Audacity reports length = 114624 samples
     // Total number of frames: 115200, 28 x 4096 frames then 1 x 512
@@ -148,7 +148,7 @@ TEST_F(Mp3AudioFileReaderTest, shouldProcessMonoMp3File)
 
     InSequence sequence; // Calls expected in the order listed below.
 
-    EXPECT_CALL(processor, init(16000, 1, 8192)).WillOnce(Return(true));
+    EXPECT_CALL(processor, init(StreamInfo(16000, 1), 8192)).WillOnce(Return(true));
 
     // Total number of frames: 116352, which is 14 x 8192 frames then 1 x 1664
     EXPECT_CALL(processor, process(_, 8192)).Times(14).WillRepeatedly(Return(true));
@@ -187,7 +187,7 @@ TEST_F(Mp3AudioFileReaderTest, shouldNotProcessFileMoreThanOnce)
 
     InSequence sequence; // Calls expected in the order listed below.
 
-    EXPECT_CALL(processor, init(16000, 2, 8192)).WillOnce(Return(true));
+    EXPECT_CALL(processor, init(StreamInfo(16000, 2), 8192)).WillOnce(Return(true));
 
     // TODO: Audacity reports length = 114624 samples
     // Total number of frames: 115200, 28 x 4096 frames then 1 x 512
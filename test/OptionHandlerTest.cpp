@@ -24,17 +24,28 @@
 #include "OptionHandler.h"
 #include "Options.h"
 #include "Array.h"
+#include "SndFileAudioFileReader.h"
+#include "WavFileWriter.h"
+#include "WaveformBuffer.h"
+#include "WaveformGenerator.h"
 #include "util/FileDeleter.h"
 #include "util/FileUtil.h"
 #include "util/Streams.h"
 
 #include "gmock/gmock.h"
 
+#include <cstdlib>
+#include <fstream>
+
 //------------------------------------------------------------------------------
 
 using testing::StartsWith;
 using testing::EndsWith;
 using testing::Eq;
+using testing::Ge;
+using testing::HasSubstr;
+using testing::Le;
+using testing::Ne;
 using testing::StrEq;
 using testing::Test;
 
@@ -255,16 +266,114 @@ TEST_F(OptionHandlerTest, shouldConvertBinaryWaveformDataToText)
 
 //------------------------------------------------------------------------------
 
-TEST_F(OptionHandlerTest, shouldNotConvertJsonWaveformDataToBinary)
+TEST_F(OptionHandlerTest, shouldConvertBinaryWaveformDataToGzipCompressedJson)
+{
+    const boost::filesystem::path output_filename = FileUtil::getTempFilename(".json.gz");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(output_filename);
+
+    std::vector<const char*> argv{
+        "appname",
+        "-i", "../test/data/test_file_stereo_8bit_64spp.dat",
+        "-o", output_filename.string().c_str()
+    };
+
+    Options options;
+
+    bool success = options.parseCommandLine(static_cast<int>(argv.size()), const_cast<char **>(&argv[0]));
+    ASSERT_TRUE(success);
+
+    OptionHandler option_handler;
+
+    success = option_handler.run(options);
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_THAT(
+        FileUtil::readGzipFile(output_filename),
+        StrEq(FileUtil::readTextFile("../test/data/test_file_stereo_8bit_64spp.json"))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldNotConvertBinaryWaveformDataToGzipCompressedBinary)
+{
+    runTest("test_file_stereo_8bit_64spp.dat", ".dat.gz", nullptr, false);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldConvertBinaryWaveformDataToMessagePack)
+{
+    runTest("test_file_stereo_8bit_64spp.dat", ".msgpack", nullptr, true);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldConvertBinaryWaveformDataToCbor)
+{
+    runTest("test_file_stereo_8bit_64spp.dat", ".cbor", nullptr, true);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldCompressBinaryWaveformData)
+{
+    const boost::filesystem::path input_filename =
+        "../test/data/test_file_stereo_8bit_64spp.dat";
+
+    const boost::filesystem::path output_filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(output_filename);
+
+    std::vector<const char*> argv{
+        "appname",
+        "-i", input_filename.string().c_str(),
+        "-o", output_filename.string().c_str(),
+        "--compress"
+    };
+
+    Options options;
+
+    bool success = options.parseCommandLine(static_cast<int>(argv.size()), const_cast<char **>(&argv[0]));
+    ASSERT_TRUE(success);
+
+    OptionHandler option_handler;
+
+    success = option_handler.run(options);
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer expected;
+    ASSERT_TRUE(expected.load(input_filename.string().c_str()));
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load(output_filename.string().c_str()));
+
+    ASSERT_THAT(buffer.getBits(), Eq(8));
+    ASSERT_THAT(buffer.getSize(), Eq(expected.getSize()));
+
+    for (int i = 0; i < expected.getSize(); ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Eq(expected.getMinSample(i)));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(expected.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldConvertJsonWaveformDataToBinary)
 {
-    runTest("test_file_stereo_8bit_64spp.json", ".dat", nullptr, false);
+    runTest("test_file_stereo_8bit_64spp.json", ".dat", nullptr, true, "test_file_stereo_8bit_64spp.dat");
 }
 
 //------------------------------------------------------------------------------
 
-TEST_F(OptionHandlerTest, shouldNotConvertJsonWaveformDataToText)
+TEST_F(OptionHandlerTest, shouldConvertJsonWaveformDataToText)
 {
-    runTest("test_file_stereo_8bit_64spp.json", ".txt", nullptr, false);
+    runTest("test_file_stereo_8bit_64spp.json", ".txt", nullptr, true, "test_file_stereo_8bit_64spp.txt");
 }
 
 //------------------------------------------------------------------------------
@@ -319,9 +428,38 @@ TEST_F(OptionHandlerTest, shouldRenderWaveformImageFromFlacAudio)
 
 //------------------------------------------------------------------------------
 
-TEST_F(OptionHandlerTest, shouldNotRenderWaveformImageFromJsonWaveformData)
+TEST_F(OptionHandlerTest, shouldRenderWaveformImageFromJsonWaveformData)
 {
-    runTest("test_file_stereo.json", ".png", nullptr, false);
+    const boost::filesystem::path dat_image_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path json_image_filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter dat_image_deleter(dat_image_filename);
+    FileDeleter json_image_deleter(json_image_filename);
+
+    auto render = [](const char* input_filename, const boost::filesystem::path& output_filename) {
+        std::vector<const char*> argv{
+            "appname",
+            "-i", input_filename,
+            "-o", output_filename.string().c_str(),
+            "-z", "128"
+        };
+
+        Options options;
+
+        bool success = options.parseCommandLine(static_cast<int>(argv.size()), const_cast<char **>(&argv[0]));
+
+        OptionHandler option_handler;
+
+        return success && option_handler.run(options);
+    };
+
+    ASSERT_TRUE(render("../test/data/test_file_stereo_8bit_64spp.dat", dat_image_filename));
+    ASSERT_TRUE(render("../test/data/test_file_stereo_8bit_64spp.json", json_image_filename));
+    ASSERT_TRUE(error.str().empty());
+
+    // Same image as from the binary waveform data
+    compareFiles(json_image_filename, dat_image_filename);
 }
 
 //------------------------------------------------------------------------------
@@ -333,6 +471,849 @@ TEST_F(OptionHandlerTest, shouldNotRenderWaveformImageFromTextWaveformData)
 
 //------------------------------------------------------------------------------
 
+static bool runOptionHandler(const std::vector<const char*>& args)
+{
+    Options options;
+
+    bool success = options.parseCommandLine(static_cast<int>(args.size()), const_cast<char **>(&args[0]));
+
+    if (success) {
+        OptionHandler option_handler;
+        success = option_handler.run(options);
+    }
+
+    return success;
+}
+
+//------------------------------------------------------------------------------
+
+// The 24-bit and float WAV files hold the first second of test_file_stereo.wav,
+// converted exactly, so give the same points as the start of its reference
+// data. These are read with sf_readf_int() and sf_readf_float().
+
+static void testGenerateFromConvertedWavAudio(const char* input_filename)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(data_filename);
+
+    boost::filesystem::path input_pathname = "../test/data";
+    input_pathname /= input_filename;
+
+    bool success = runOptionHandler({
+        "appname", "-i", input_pathname.string().c_str(),
+        "-o", data_filename.string().c_str(), "-b", "8", "-z", "64"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer expected;
+    ASSERT_TRUE(expected.load("../test/data/test_file_stereo_8bit_64spp.dat"));
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load(data_filename.string().c_str()));
+
+    ASSERT_THAT(buffer.getBits(), Eq(8));
+    ASSERT_THAT(buffer.getSize(), Eq(250));
+
+    for (long long i = 0; i < buffer.getSize(); ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Eq(expected.getMinSample(i)));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(expected.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldGenerateBinaryWaveformDataFrom24BitWavAudio)
+{
+    testGenerateFromConvertedWavAudio("test_file_stereo_24bit.wav");
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldGenerateBinaryWaveformDataFromFloatWavAudio)
+{
+    testGenerateFromConvertedWavAudio("test_file_stereo_float.wav");
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldRenderWaveformImageUsingIndex)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+    const boost::filesystem::path index_filename = data_filename.string() + ".idx";
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path actual_filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter data_deleter(data_filename);
+    FileDeleter index_deleter(index_filename);
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter actual_deleter(actual_filename);
+
+    boost::filesystem::copy_file("../test/data/test_file_stereo_8bit_64spp.dat", data_filename);
+
+    bool success = runOptionHandler({
+        "appname", "-i", data_filename.string().c_str(),
+        "-o", expected_filename.string().c_str(), "-z", "200"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_FALSE(boost::filesystem::exists(index_filename));
+
+    // The first run with --index creates the index file, the second uses it
+    for (int i = 0; i < 2; ++i) {
+        success = runOptionHandler({
+            "appname", "-i", data_filename.string().c_str(),
+            "-o", actual_filename.string().c_str(), "-z", "200", "--index"
+        });
+
+        ASSERT_TRUE(success);
+        ASSERT_TRUE(boost::filesystem::is_regular_file(index_filename));
+
+        compareFiles(actual_filename, expected_filename);
+    }
+
+    ASSERT_THAT(output.str(), HasSubstr("Writing index file"));
+    ASSERT_THAT(output.str(), HasSubstr("Reading index file"));
+    ASSERT_TRUE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldRenderWaveformImageUsingIndexThatCannotBeSaved)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+    const boost::filesystem::path index_filename = data_filename.string() + ".idx";
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path actual_filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter data_deleter(data_filename);
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter actual_deleter(actual_filename);
+
+    boost::filesystem::copy_file("../test/data/test_file_stereo_8bit_64spp.dat", data_filename);
+
+    // A directory in place of the index file, older than the data file, so
+    // that the index is built but can't be saved
+    boost::filesystem::create_directory(index_filename);
+    boost::filesystem::last_write_time(
+        index_filename,
+        boost::filesystem::last_write_time(data_filename) - 60
+    );
+
+    bool success = runOptionHandler({
+        "appname", "-i", data_filename.string().c_str(),
+        "-o", expected_filename.string().c_str(), "-z", "200"
+    });
+
+    ASSERT_TRUE(success);
+
+    success = runOptionHandler({
+        "appname", "-i", data_filename.string().c_str(),
+        "-o", actual_filename.string().c_str(), "-z", "200", "--index"
+    });
+
+    boost::filesystem::remove(index_filename);
+
+    ASSERT_TRUE(success);
+    ASSERT_THAT(error.str(), HasSubstr("Failed to write index file"));
+    ASSERT_THAT(error.str(), HasSubstr("Continuing without saving the index file\n"));
+
+    compareFiles(actual_filename, expected_filename);
+}
+
+//------------------------------------------------------------------------------
+
+// Renders at a finer zoom level than the .dat file, by reading the part of the
+// linked audio file shown in the image.
+
+TEST_F(OptionHandlerTest, shouldRenderFineZoomWaveformImageFromWavAudio)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+    const boost::filesystem::path source_filename = data_filename.string() + ".src";
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path actual_filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter data_deleter(data_filename);
+    FileDeleter source_deleter(source_filename);
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter actual_deleter(actual_filename);
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", data_filename.string().c_str(), "-z", "256", "--link-audio"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(boost::filesystem::is_regular_file(source_filename));
+
+    success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", expected_filename.string().c_str(), "-z", "64", "-s", "2.5"
+    });
+
+    ASSERT_TRUE(success);
+
+    success = runOptionHandler({
+        "appname", "-i", data_filename.string().c_str(),
+        "-o", actual_filename.string().c_str(), "-z", "64", "-s", "2.5"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    compareFiles(actual_filename, expected_filename);
+}
+
+//------------------------------------------------------------------------------
+
+// The data read from the linked audio file has the same channels as the .dat
+// file, without needing --split-channels when rendering.
+
+TEST_F(OptionHandlerTest, shouldRenderFineZoomWaveformImageWithSplitChannelsFromWavAudio)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+    const boost::filesystem::path source_filename = data_filename.string() + ".src";
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path actual_filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter data_deleter(data_filename);
+    FileDeleter source_deleter(source_filename);
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter actual_deleter(actual_filename);
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", data_filename.string().c_str(), "-z", "256", "--split-channels",
+        "--link-audio"
+    });
+
+    ASSERT_TRUE(success);
+
+    success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", expected_filename.string().c_str(), "-z", "64", "-s", "2.5",
+        "--split-channels"
+    });
+
+    ASSERT_TRUE(success);
+
+    success = runOptionHandler({
+        "appname", "-i", data_filename.string().c_str(),
+        "-o", actual_filename.string().c_str(), "-z", "64", "-s", "2.5"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    compareFiles(actual_filename, expected_filename);
+}
+
+// Generates a .dat file from the start of a WAV file, then resumes from the
+// rest of the file, as if the file had grown, which should give the same
+// result as generating the .dat file in one go.
+
+TEST_F(OptionHandlerTest, shouldResumeBinaryWaveformDataFromWavAudio)
+{
+    const boost::filesystem::path audio_filename = FileUtil::getTempFilename(".wav");
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+    const boost::filesystem::path resume_filename = data_filename.string() + ".resume";
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter audio_deleter(audio_filename);
+    FileDeleter data_deleter(data_filename);
+    FileDeleter resume_deleter(resume_filename);
+    FileDeleter expected_deleter(expected_filename);
+
+    // Write the first 50000 frames, which isn't a whole number of points
+    {
+        SndFileAudioFileReader reader;
+        ASSERT_TRUE(reader.open("../test/data/test_file_stereo.wav"));
+
+        WavFileWriter writer(audio_filename.string().c_str());
+        ASSERT_TRUE(reader.runRange(writer, 0, 50000));
+    }
+
+    bool success = runOptionHandler({
+        "appname", "-i", audio_filename.string().c_str(),
+        "-o", data_filename.string().c_str(), "-z", "256", "--resume"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(boost::filesystem::is_regular_file(resume_filename));
+
+    boost::filesystem::remove(audio_filename);
+    boost::filesystem::copy_file("../test/data/test_file_stereo.wav", audio_filename);
+
+    output.str(std::string());
+
+    success = runOptionHandler({
+        "appname", "-i", audio_filename.string().c_str(),
+        "-o", data_filename.string().c_str(), "-z", "256", "--resume"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_THAT(output.str(), HasSubstr("Appending to output file"));
+    ASSERT_THAT(output.str(), HasSubstr("Read 65200 frames"));
+
+    success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", expected_filename.string().c_str(), "-z", "256"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    compareFiles(data_filename, expected_filename);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldNotResumeWithRms)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", data_filename.string().c_str(), "-z", "256", "--resume", "--rms"
+    });
+
+    ASSERT_FALSE(success);
+    ASSERT_THAT(error.str(), StrEq("Can't use --rms with --resume or a playlist input file\n"));
+    ASSERT_FALSE(boost::filesystem::exists(data_filename));
+}
+
+//------------------------------------------------------------------------------
+
+// The RMS values don't change the min and max values, and are no greater than
+// the larger of their magnitudes.
+
+TEST_F(OptionHandlerTest, shouldGenerateBinaryWaveformDataWithRmsFromWavAudio)
+{
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".dat");
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter deleter(data_filename);
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", expected_filename.string().c_str(), "-b", "16", "-z", "64"
+    });
+
+    ASSERT_TRUE(success);
+
+    success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", data_filename.string().c_str(), "-b", "16", "-z", "64", "--rms"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer expected;
+    ASSERT_TRUE(expected.load(expected_filename.string().c_str()));
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load(data_filename.string().c_str()));
+
+    ASSERT_TRUE(buffer.hasRms());
+    ASSERT_THAT(buffer.getSize(), Eq(expected.getSize()));
+
+    for (long long i = 0; i < expected.getSize(); ++i) {
+        const short min = buffer.getMinSample(i);
+        const short max = buffer.getMaxSample(i);
+
+        ASSERT_THAT(min, Eq(expected.getMinSample(i)));
+        ASSERT_THAT(max, Eq(expected.getMaxSample(i)));
+        ASSERT_THAT(buffer.getRmsSample(i), Le(std::max(-min, static_cast<int>(max))));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Checks that --output-image and --tile-zoom render the same image from WAV
+// audio as rendering a single image, with the given option.
+
+static void testOutputImagesAndTilesFromWavAudio(const char* option)
+{
+    const boost::filesystem::path expected_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path image_filename = FileUtil::getTempFilename(".png");
+    const boost::filesystem::path tile_directory = FileUtil::getTempFilename(nullptr);
+    const boost::filesystem::path tile_filename = tile_directory / "128" / "0.png";
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter expected_deleter(expected_filename);
+    FileDeleter image_deleter(image_filename);
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", expected_filename.string().c_str(),
+        "-z", "128", "-w", "256", "-h", "100", option
+    });
+
+    ASSERT_TRUE(success);
+
+    const std::string spec = "256x100x128:" + image_filename.string();
+
+    success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "--output-image", spec.c_str(), option
+    });
+
+    ASSERT_TRUE(success);
+
+    compareFiles(image_filename, expected_filename);
+
+    success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", tile_directory.string().c_str(),
+        "--tile-zoom", "128", "--tile-width", "256", "-h", "100", option
+    });
+
+    const bool tile_exists = boost::filesystem::is_regular_file(tile_filename);
+
+    if (tile_exists) {
+        compareFiles(tile_filename, expected_filename);
+    }
+
+    boost::filesystem::remove_all(tile_directory);
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(tile_exists);
+    ASSERT_TRUE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldRenderOutputImagesAndTilesWithRmsFromWavAudio)
+{
+    testOutputImagesAndTilesFromWavAudio("--rms");
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldRenderOutputImagesAndTilesWithSplitChannelsFromWavAudio)
+{
+    testOutputImagesAndTilesFromWavAudio("--split-channels");
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldNotResumeWithSplitChannels)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", data_filename.string().c_str(), "-z", "256", "--resume", "--split-channels"
+    });
+
+    ASSERT_FALSE(success);
+    ASSERT_THAT(error.str(), StrEq("Can't use --split-channels with --resume, --rms, --index, or a playlist input file\n"));
+    ASSERT_FALSE(boost::filesystem::exists(data_filename));
+}
+
+//------------------------------------------------------------------------------
+
+// Each sample summed to mono lies between the left and right samples, so the
+// mono min and max values lie within the range of the two channels' values.
+
+TEST_F(OptionHandlerTest, shouldGenerateBinaryWaveformDataWithSplitChannelsFromWavAudio)
+{
+    const boost::filesystem::path data_filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(data_filename);
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", data_filename.string().c_str(), "-b", "16", "-z", "64", "--split-channels"
+    });
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer expected;
+    ASSERT_TRUE(expected.load("../test/data/test_file_stereo_16bit_64spp.dat"));
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load(data_filename.string().c_str()));
+
+    ASSERT_THAT(buffer.getChannels(), Eq(2));
+    ASSERT_THAT(buffer.getSize(), Eq(expected.getSize()));
+
+    for (long long i = 0; i < expected.getSize(); ++i) {
+        const short min = std::min(buffer.getMinSample(0, i), buffer.getMinSample(1, i));
+        const short max = std::max(buffer.getMaxSample(0, i), buffer.getMaxSample(1, i));
+
+        ASSERT_THAT(min, Le(expected.getMinSample(i)));
+        ASSERT_THAT(max, Ge(expected.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+static void generateWaveformData(
+    const std::vector<short>& samples,
+    const size_t start,
+    const size_t end,
+    WaveformBuffer& buffer)
+{
+    SamplesPerPixelScaleFactor scale_factor(64);
+    WaveformGenerator generator(buffer, scale_factor);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(16000, 1), 1000));
+    ASSERT_TRUE(generator.process(&samples[start], static_cast<int>(end - start)));
+    generator.done();
+}
+
+//------------------------------------------------------------------------------
+
+// Writes a .dat file for each segment of the given samples, with a resume
+// file that gives the number of frames, and a playlist that lists them.
+
+static void writeDataFileSegments(
+    const std::vector<short>& samples,
+    const std::vector<size_t>& lengths,
+    const boost::filesystem::path& directory,
+    const boost::filesystem::path& playlist_filename)
+{
+    std::ofstream playlist(playlist_filename.string().c_str());
+
+    size_t start = 0;
+
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        const boost::filesystem::path filename =
+            directory / (std::to_string(i) + ".dat");
+
+        WaveformBuffer buffer;
+        generateWaveformData(samples, start, start + lengths[i], buffer);
+        ASSERT_TRUE(buffer.save(filename.string().c_str()));
+
+        std::ofstream resume_file(filename.string() + ".resume");
+        resume_file << buffer.getSize() << ' ' << lengths[i] << " 0 0 0\n";
+
+        playlist << filename.filename().string() << '\n';
+
+        start += lengths[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+
+class OptionHandlerMergeTest : public OptionHandlerTest
+{
+    protected:
+        virtual void SetUp()
+        {
+            OptionHandlerTest::SetUp();
+
+            directory_ = FileUtil::getTempFilename(nullptr);
+            boost::filesystem::create_directory(directory_);
+
+            playlist_filename_ = directory_ / "test.m3u";
+            output_filename_   = directory_ / "output.dat";
+
+            srand(2);
+
+            for (int i = 0; i < 4000; ++i) {
+                samples_.push_back(static_cast<short>(rand() % 65536 - 32768));
+            }
+
+            generateWaveformData(samples_, 0, samples_.size(), expected_);
+        }
+
+        virtual void TearDown()
+        {
+            boost::filesystem::remove_all(directory_);
+        }
+
+        bool merge()
+        {
+            return runOptionHandler({
+                "appname", "-i", playlist_filename_.string().c_str(),
+                "-o", output_filename_.string().c_str()
+            });
+        }
+
+        boost::filesystem::path directory_;
+        boost::filesystem::path playlist_filename_;
+        boost::filesystem::path output_filename_;
+        std::vector<short> samples_;
+        WaveformBuffer expected_;
+};
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerMergeTest, shouldMergeBinaryWaveformDataSameAsSingleFile)
+{
+    // Each segment ends on a point boundary, except the last
+    writeDataFileSegments(samples_, { 640, 1280, 2080 }, directory_, playlist_filename_);
+
+    ASSERT_TRUE(merge());
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load(output_filename_.string().c_str()));
+
+    ASSERT_THAT(buffer.getSampleRate(), Eq(16000));
+    ASSERT_THAT(buffer.getSamplesPerPixel(), Eq(64));
+    ASSERT_THAT(buffer.getSize(), Eq(expected_.getSize()));
+
+    for (long long i = 0; i < expected_.getSize(); ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Eq(expected_.getMinSample(i)));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(expected_.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerMergeTest, shouldMergeBinaryWaveformDataWithPartialLastPoints)
+{
+    writeDataFileSegments(samples_, { 1000, 30, 2970 }, directory_, playlist_filename_);
+
+    ASSERT_TRUE(merge());
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load(output_filename_.string().c_str()));
+
+    // The points cover the same audio as the single file, so there are the
+    // same number, and each includes the min and max of the single file's
+    // point
+    ASSERT_THAT(buffer.getSize(), Eq(expected_.getSize()));
+
+    for (long long i = 0; i < expected_.getSize(); ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Le(expected_.getMinSample(i)));
+        ASSERT_THAT(buffer.getMaxSample(i), Ge(expected_.getMaxSample(i)));
+    }
+
+    // Points before the end of the first segment are unchanged
+    for (long long i = 0; i < 1000 / 64; ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Eq(expected_.getMinSample(i)));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(expected_.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// The .dat files are created without --resume, so the number of frames in each
+// comes from the resume file saved because its last point is incomplete.
+
+TEST_F(OptionHandlerMergeTest, shouldMergeBinaryWaveformDataFromUnalignedAudioFiles)
+{
+    const long long frame_counts[] = { 50000, 65200 };
+
+    std::ofstream playlist(playlist_filename_.string().c_str());
+
+    long long start = 0;
+
+    for (size_t i = 0; i < 2; ++i) {
+        const boost::filesystem::path audio_filename =
+            directory_ / (std::to_string(i) + ".wav");
+
+        const boost::filesystem::path data_filename =
+            directory_ / (std::to_string(i) + ".dat");
+
+        {
+            SndFileAudioFileReader reader;
+            ASSERT_TRUE(reader.open("../test/data/test_file_stereo.wav"));
+
+            WavFileWriter writer(audio_filename.string().c_str());
+            ASSERT_TRUE(reader.runRange(writer, start, frame_counts[i]));
+        }
+
+        bool success = runOptionHandler({
+            "appname", "-i", audio_filename.string().c_str(),
+            "-o", data_filename.string().c_str(), "-z", "256"
+        });
+
+        ASSERT_TRUE(success);
+
+        playlist << data_filename.filename().string() << '\n';
+
+        start += frame_counts[i];
+    }
+
+    playlist.close();
+
+    bool success = runOptionHandler({
+        "appname", "-i", "../test/data/test_file_stereo.wav",
+        "-o", (directory_ / "expected.dat").string().c_str(), "-z", "256"
+    });
+
+    ASSERT_TRUE(success);
+
+    ASSERT_TRUE(merge());
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer expected;
+    ASSERT_TRUE(expected.load((directory_ / "expected.dat").string().c_str()));
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load(output_filename_.string().c_str()));
+
+    ASSERT_THAT(buffer.getSize(), Eq(expected.getSize()));
+
+    for (long long i = 0; i < expected.getSize(); ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Le(expected.getMinSample(i)));
+        ASSERT_THAT(buffer.getMaxSample(i), Ge(expected.getMaxSample(i)));
+    }
+
+    // Points before the end of the first file are unchanged
+    for (long long i = 0; i < 50000 / 256; ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Eq(expected.getMinSample(i)));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(expected.getMaxSample(i)));
+    }
+}
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerMergeTest, shouldNotMergeBinaryWaveformDataWithDifferentZoom)
+{
+    writeDataFileSegments(samples_, { 640, 640 }, directory_, playlist_filename_);
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load((directory_ / "1.dat").string().c_str()));
+
+    buffer.setSamplesPerPixel(128);
+    ASSERT_TRUE(buffer.save((directory_ / "1.dat").string().c_str()));
+
+    ASSERT_FALSE(merge());
+    ASSERT_THAT(error.str(), HasSubstr("Sample rate or zoom level does not match previous files"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerMergeTest, shouldNotMergeBinaryWaveformDataWithRms)
+{
+    writeDataFileSegments(samples_, { 640, 640 }, directory_, playlist_filename_);
+
+    WaveformBuffer buffer;
+    ASSERT_TRUE(buffer.load((directory_ / "1.dat").string().c_str()));
+
+    buffer.setRms(true);
+    ASSERT_TRUE(buffer.save((directory_ / "1.dat").string().c_str()));
+
+    ASSERT_FALSE(merge());
+    ASSERT_THAT(error.str(), HasSubstr("Can't merge waveform data files with RMS values"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerMergeTest, shouldNotMergeMultiChannelBinaryWaveformData)
+{
+    writeDataFileSegments(samples_, { 640, 640 }, directory_, playlist_filename_);
+
+    WaveformBuffer buffer;
+    buffer.setSampleRate(16000);
+    buffer.setSamplesPerPixel(64);
+    buffer.setChannels(2);
+
+    for (int i = 0; i < 10; ++i) {
+        buffer.appendSamples(-100, 100);
+        buffer.appendSamples(-200, 200);
+    }
+
+    ASSERT_TRUE(buffer.save((directory_ / "1.dat").string().c_str()));
+
+    ASSERT_FALSE(merge());
+    ASSERT_THAT(error.str(), HasSubstr("Can't merge multi-channel waveform data files"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldRenderMultipleWaveformImagesFromBinaryWaveformData)
+{
+    const boost::filesystem::path filenames[] = {
+        FileUtil::getTempFilename(".png"),
+        FileUtil::getTempFilename(".png"),
+        FileUtil::getTempFilename(".png")
+    };
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter deleter_0(filenames[0]);
+    FileDeleter deleter_1(filenames[1]);
+    FileDeleter deleter_2(filenames[2]);
+
+    const std::string specs[] = {
+        "200x40x256:" + filenames[0].string(),
+        "800x150x128:" + filenames[1].string(),
+        "1000x280x256:" + filenames[2].string()
+    };
+
+    std::vector<const char*> argv{
+        "appname",
+        "-i", "../test/data/test_file_stereo_8bit_64spp.dat",
+        "--output-image", specs[0].c_str(), specs[1].c_str(), specs[2].c_str()
+    };
+
+    Options options;
+
+    bool success = options.parseCommandLine(static_cast<int>(argv.size()), const_cast<char **>(&argv[0]));
+    ASSERT_TRUE(success);
+
+    OptionHandler option_handler;
+
+    success = option_handler.run(options);
+    ASSERT_TRUE(success);
+
+    for (const auto& filename : filenames) {
+        ASSERT_TRUE(boost::filesystem::is_regular_file(filename));
+    }
+
+    ASSERT_TRUE(error.str().empty());
+
+    // The data should be rescaled once for each distinct zoom level
+    const std::string str = output.str();
+
+    const std::string::size_type pos = str.find("Rescaling to 256 samples/pixel");
+    ASSERT_THAT(pos, Ne(std::string::npos));
+    ASSERT_THAT(str.find("Rescaling to 256 samples/pixel", pos + 1), Eq(std::string::npos));
+    ASSERT_THAT(str.find("Rescaling to 128 samples/pixel"), Ne(std::string::npos));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionHandlerTest, shouldNotRenderOutputImageIfZoomIsLessThanInputZoom)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    const std::string spec = "200x40x32:" + filename.string();
+
+    std::vector<const char*> argv{
+        "appname",
+        "-i", "../test/data/test_file_stereo_8bit_64spp.dat",
+        "--output-image", spec.c_str()
+    };
+
+    Options options;
+
+    bool success = options.parseCommandLine(static_cast<int>(argv.size()), const_cast<char **>(&argv[0]));
+    ASSERT_TRUE(success);
+
+    OptionHandler option_handler;
+
+    success = option_handler.run(options);
+    ASSERT_FALSE(success);
+
+    ASSERT_FALSE(boost::filesystem::is_regular_file(filename));
+    ASSERT_THAT(error.str(), StrEq("Invalid zoom, minimum: 64\n"));
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(OptionHandlerTest, shouldFailIfZoomIsZero)
 {
     std::vector<const char*> args{ "-z", "0" };
@@ -748,6 +748,470 @@ TEST_F(OptionsTest, shouldEnableAxisLabelRenderingByDefault)
 
 //------------------------------------------------------------------------------
 
+TEST_F(OptionsTest, shouldEnablePngPalette)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png", "--png-palette"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getPngPalette());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldDisablePngPaletteByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getPngPalette());
+    ASSERT_THAT(options_.getPngCompressionLevel(), Eq(-1));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnPngCompressionLevel)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png", "--png-compression", "9"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_THAT(options_.getPngCompressionLevel(), Eq(9));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldDisplayErrorIfPngCompressionLevelInvalid)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png", "--png-compression", "10"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_FALSE(result);
+
+    ASSERT_TRUE(output.str().empty());
+    ASSERT_FALSE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnPngFilterAndThreads)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png",
+        "--png-filter", "paeth", "--png-threads", "4"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.hasPngFilter());
+    ASSERT_THAT(options_.getPngFilter(), StrEq("paeth"));
+    ASSERT_THAT(options_.getPngThreads(), Eq(4));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnDefaultPngFilterAndThreads)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.hasPngFilter());
+    ASSERT_THAT(options_.getPngThreads(), Eq(0));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldDisplayErrorIfPngThreadsNegative)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png", "--png-threads", "-1"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_FALSE(result);
+    ASSERT_FALSE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnPngStreamFlag)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png", "--png-stream"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getPngStream());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotStreamPngByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getPngStream());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnTileZoomLevelsAndWidth)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "tiles",
+        "--tile-zoom", "256", "1024", "--tile-zoom", "4096", "--tile-width", "512"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    const std::vector<int>& zoom_levels = options_.getTileZoomLevels();
+
+    ASSERT_THAT(zoom_levels.size(), Eq(3U));
+    ASSERT_THAT(zoom_levels[0], Eq(256));
+    ASSERT_THAT(zoom_levels[1], Eq(1024));
+    ASSERT_THAT(zoom_levels[2], Eq(4096));
+    ASSERT_THAT(options_.getTileWidth(), Eq(512));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnDefaultTileOptions)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getTileZoomLevels().empty());
+    ASSERT_THAT(options_.getTileWidth(), Eq(256));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldDisplayErrorIfTileZoomInvalid)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "tiles", "--tile-zoom", "1"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_FALSE(result);
+    ASSERT_FALSE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnOutputImages)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat",
+        "--output-image", "200x40x4096:thumb.png", "800x150x1024:card.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    const std::vector<ImageSpec>& images = options_.getOutputImages();
+
+    ASSERT_THAT(images.size(), Eq(2U));
+    ASSERT_THAT(images[0].width, Eq(200));
+    ASSERT_THAT(images[0].height, Eq(40));
+    ASSERT_THAT(images[0].samples_per_pixel, Eq(4096));
+    ASSERT_THAT(images[0].filename, StrEq("thumb.png"));
+    ASSERT_THAT(images[1].width, Eq(800));
+    ASSERT_THAT(images[1].height, Eq(150));
+    ASSERT_THAT(images[1].samples_per_pixel, Eq(1024));
+    ASSERT_THAT(images[1].filename, StrEq("card.png"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldDisplayErrorIfOutputImageInvalid)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "--output-image", "200x40:thumb.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_FALSE(result);
+    ASSERT_FALSE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldDisplayErrorIfOutputFilenameAndOutputImagesGiven)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png",
+        "--output-image", "200x40x4096:thumb.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_FALSE(result);
+    ASSERT_FALSE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnIndexFlag)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png", "--index"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getIndex());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotUseIndexByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.png"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getIndex());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnLinkAudioFlag)
+{
+    char *argv[] = {
+        "appname", "-i", "test.mp3", "-o", "test.dat", "--link-audio"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getLinkAudio());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotLinkAudioByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.mp3", "-o", "test.dat"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getLinkAudio());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnResumeFlag)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat", "--resume"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getResume());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotResumeByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getResume());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnCompressFlag)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat", "--compress"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getCompress());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotCompressByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getCompress());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnGzipCompressionLevel)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.json.gz", "--gzip-compression", "9"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_THAT(options_.getGzipCompressionLevel(), Eq(9));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnDefaultGzipCompressionLevel)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.json.gz"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_THAT(options_.getGzipCompressionLevel(), Eq(-1));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldDisplayErrorIfGzipCompressionLevelInvalid)
+{
+    char *argv[] = {
+        "appname", "-i", "test.dat", "-o", "test.json.gz", "--gzip-compression", "-2"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_FALSE(result);
+
+    ASSERT_TRUE(output.str().empty());
+    ASSERT_FALSE(error.str().empty());
+}
+
+TEST_F(OptionsTest, shouldReturnSegmentCacheDirectory)
+{
+    char *argv[] = {
+        "appname", "-i", "test.m3u", "-o", "test.dat", "--segment-cache", "cache"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.hasSegmentCache());
+    ASSERT_THAT(options_.getSegmentCache(), StrEq("cache"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotUseSegmentCacheByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.m3u", "-o", "test.dat"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.hasSegmentCache());
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(OptionsTest, shouldReturnHelpFlag)
 {
     char *argv[] = { "appname", "--help" };
@@ -834,3 +1298,67 @@ TEST_F(OptionsTest, shouldOutputUsageInfo)
 }
 
 //------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnRmsFlag)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat", "--rms"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getRms());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotOutputRmsByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getRms());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldReturnSplitChannelsFlag)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat", "--split-channels"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_TRUE(options_.getSplitChannels());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(OptionsTest, shouldNotSplitChannelsByDefault)
+{
+    char *argv[] = {
+        "appname", "-i", "test.wav", "-o", "test.dat"
+    };
+
+    bool result = options_.parseCommandLine(ARRAY_LENGTH(argv), argv);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_FALSE(options_.getSplitChannels());
+}
+
+//------------------------------------------------------------------------------
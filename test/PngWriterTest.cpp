@@ -0,0 +1,342 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "PngWriter.h"
+#include "util/FileDeleter.h"
+#include "util/FileUtil.h"
+#include "util/Streams.h"
+
+#include "gmock/gmock.h"
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::Gt;
+using testing::HasSubstr;
+using testing::StartsWith;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class PngWriterTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            output.str(std::string());
+            error.str(std::string());
+
+            image_ = nullptr;
+        }
+
+        virtual void TearDown()
+        {
+            if (image_ != nullptr) {
+                gdImageDestroy(image_);
+                image_ = nullptr;
+            }
+        }
+
+        void createTrueColorImage(int width, int height, bool alpha);
+        void createPaletteImage(int width, int height);
+
+        void testWriteImage(PngWriter& writer);
+        void testWriteImageRows(PngWriter& writer);
+
+        void checkImage(const boost::filesystem::path& filename);
+
+        gdImagePtr image_;
+};
+
+//------------------------------------------------------------------------------
+
+void PngWriterTest::createTrueColorImage(int width, int height, bool alpha)
+{
+    image_ = gdImageCreateTrueColor(width, height);
+    ASSERT_TRUE(image_ != nullptr);
+
+    if (alpha) {
+        gdImageSaveAlpha(image_, 1);
+        gdImageAlphaBlending(image_, 0);
+    }
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const int color = gdImageColorAllocateAlpha(
+                image_,
+                (x * 7) % 256,
+                (y * 3) % 256,
+                (x + y) % 256,
+                alpha ? (x % 128) : 0
+            );
+
+            gdImageSetPixel(image_, x, y, color);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void PngWriterTest::createPaletteImage(int width, int height)
+{
+    image_ = gdImageCreate(width, height);
+    ASSERT_TRUE(image_ != nullptr);
+
+    const int background = gdImageColorAllocate(image_, 0xe4, 0xe4, 0xe4);
+    const int waveform   = gdImageColorAllocate(image_, 0x3f, 0x3f, 0xff);
+    const int border     = gdImageColorAllocate(image_, 0x00, 0x00, 0x00);
+
+    gdImageFilledRectangle(image_, 0, 0, width - 1, height - 1, background);
+    gdImageRectangle(image_, 0, 0, width - 1, height - 1, border);
+
+    for (int x = 1; x < width - 1; ++x) {
+        const int amplitude = (x * 37) % (height / 2);
+        gdImageLine(image_, x, height / 2 - amplitude, x, height / 2 + amplitude, waveform);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void PngWriterTest::testWriteImage(PngWriter& writer)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    bool result = writer.write(image_, filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(output.str(), StartsWith("Writing PNG file"));
+    ASSERT_TRUE(error.str().empty());
+
+    checkImage(filename);
+}
+
+//------------------------------------------------------------------------------
+
+void PngWriterTest::testWriteImageRows(PngWriter& writer)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".png");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    const int height = gdImageSY(image_);
+
+    bool result = writer.open(filename.string().c_str(), image_, height);
+    ASSERT_TRUE(result);
+
+    for (int y = 0; y < height; ++y) {
+        result = writer.writeRow(image_->pixels[y]);
+        ASSERT_TRUE(result);
+    }
+
+    result = writer.close();
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(output.str(), StartsWith("Writing PNG file"));
+    ASSERT_TRUE(error.str().empty());
+
+    checkImage(filename);
+}
+
+//------------------------------------------------------------------------------
+
+// Reads the image back with libgd and checks every pixel matches.
+
+void PngWriterTest::checkImage(const boost::filesystem::path& filename)
+{
+    gdImagePtr image = FileUtil::readPngFile(filename);
+
+    ASSERT_TRUE(image != nullptr);
+    ASSERT_THAT(gdImageSX(image), Eq(gdImageSX(image_)));
+    ASSERT_THAT(gdImageSY(image), Eq(gdImageSY(image_)));
+
+    int mismatches = 0;
+
+    for (int y = 0; y < gdImageSY(image_); ++y) {
+        for (int x = 0; x < gdImageSX(image_); ++x) {
+            if (gdImageGetTrueColorPixel(image, x, y) !=
+                gdImageGetTrueColorPixel(image_, x, y)) {
+                mismatches++;
+            }
+        }
+    }
+
+    gdImageDestroy(image);
+
+    ASSERT_THAT(mismatches, Eq(0));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldWriteTrueColorImage)
+{
+    createTrueColorImage(200, 100, false);
+
+    PngWriter writer(-1, PngWriter::FILTER_DEFAULT, 1);
+
+    ASSERT_THAT(writer.getSegmentCount(image_), Eq(1));
+
+    testWriteImage(writer);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldWriteTrueColorImageWithAlpha)
+{
+    createTrueColorImage(200, 100, true);
+
+    PngWriter writer(-1, PngWriter::FILTER_DEFAULT, 1);
+    testWriteImage(writer);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldWritePaletteImage)
+{
+    createPaletteImage(1000, 250);
+
+    PngWriter writer(9, PngWriter::FILTER_DEFAULT, 1);
+    testWriteImage(writer);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldWriteImageWithEachFilter)
+{
+    createTrueColorImage(100, 50, true);
+
+    const PngWriter::Filter filters[] = {
+        PngWriter::FILTER_NONE,
+        PngWriter::FILTER_SUB,
+        PngWriter::FILTER_UP,
+        PngWriter::FILTER_AVERAGE,
+        PngWriter::FILTER_PAETH,
+        PngWriter::FILTER_ADAPTIVE
+    };
+
+    for (const auto filter : filters) {
+        output.str(std::string());
+
+        PngWriter writer(6, filter, 1);
+        testWriteImage(writer);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldCompressWideImageOnMultipleThreads)
+{
+    createTrueColorImage(6000, 256, false);
+
+    PngWriter writer(1, PngWriter::FILTER_DEFAULT, 4);
+
+    ASSERT_THAT(writer.getSegmentCount(image_), Eq(4));
+
+    testWriteImage(writer);
+
+    ASSERT_THAT(output.str(), HasSubstr("PNG encoder threads: 4"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldNotUseMoreThreadsThanSegments)
+{
+    createTrueColorImage(1000, 600, false);
+
+    PngWriter writer(-1, PngWriter::FILTER_DEFAULT, 8);
+
+    // 1000 x 600 x 3 bytes of image data is less than two 1 MB segments
+    ASSERT_THAT(writer.getSegmentCount(image_), Eq(1));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldWritePaletteImageRowByRow)
+{
+    createPaletteImage(1000, 250);
+
+    PngWriter writer(-1, PngWriter::FILTER_DEFAULT, 1);
+    testWriteImageRows(writer);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldWritePaletteImageRowByRowWithFilter)
+{
+    createPaletteImage(333, 100);
+
+    PngWriter writer(9, PngWriter::FILTER_PAETH, 1);
+    testWriteImageRows(writer);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldWriteLargePaletteImageRowByRow)
+{
+    // Compressed data spans more than one IDAT chunk
+    createPaletteImage(2000, 2000);
+
+    for (int y = 0; y < 2000; ++y) {
+        for (int x = 0; x < 2000; ++x) {
+            image_->pixels[y][x] = static_cast<unsigned char>((x * 7 + y * 13 + x * y) % 3);
+        }
+    }
+
+    PngWriter writer(0, PngWriter::FILTER_DEFAULT, 1);
+    testWriteImageRows(writer);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldReportErrorIfFileCannotBeCreated)
+{
+    createPaletteImage(100, 50);
+
+    PngWriter writer(-1, PngWriter::FILTER_DEFAULT, 1);
+
+    bool result = writer.write(image_, "/nonexistent/directory/test.png");
+
+    ASSERT_FALSE(result);
+    ASSERT_TRUE(output.str().empty());
+    ASSERT_THAT(error.str(), StartsWith("Failed to write PNG file"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(PngWriterTest, shouldReportErrorIfRowFileCannotBeCreated)
+{
+    createPaletteImage(100, 50);
+
+    PngWriter writer(-1, PngWriter::FILTER_DEFAULT, 1);
+
+    bool result = writer.open("/nonexistent/directory/test.png", image_, 50);
+
+    ASSERT_FALSE(result);
+    ASSERT_TRUE(output.str().empty());
+    ASSERT_THAT(error.str(), StartsWith("Failed to write PNG file"));
+}
+
+//------------------------------------------------------------------------------
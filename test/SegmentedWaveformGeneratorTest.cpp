@@ -0,0 +1,442 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "SegmentedWaveformGenerator.h"
+#include "AudioFileReader.h"
+#include "AudioProcessor.h"
+#include "WaveformBuffer.h"
+#include "WaveformGenerator.h"
+#include "util/FileUtil.h"
+#include "util/Streams.h"
+
+#include "gmock/gmock.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::HasSubstr;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+// Reads raw 16-bit mono samples, so that segments can be tested without
+// encoding or decoding audio files.
+
+class RawAudioFileReader : public AudioFileReader
+{
+    public:
+        virtual bool open(const char* filename)
+        {
+            filename_ = filename;
+
+            std::ifstream stream(filename, std::ios::in | std::ios::binary);
+
+            short sample;
+
+            while (stream.read(reinterpret_cast<char*>(&sample), sizeof(sample))) {
+                samples_.push_back(sample);
+            }
+
+            return !samples_.empty();
+        }
+
+        virtual bool run(AudioProcessor& processor)
+        {
+            ++run_count;
+
+            if (filename_ == failing_filename) {
+                getErrorStream() << "Failed to decode: " << filename_ << '\n';
+                return false;
+            }
+
+            AudioStreamInfo info(16000, 1);
+            info.frame_count = static_cast<long long>(samples_.size());
+            info.frame_count_exact = true;
+
+            if (!processor.init(info, BUFFER_SIZE)) {
+                return false;
+            }
+
+            for (size_t i = 0; i < samples_.size(); i += BUFFER_SIZE) {
+                const size_t count = std::min<size_t>(BUFFER_SIZE, samples_.size() - i);
+
+                if (!processor.process(&samples_[i], static_cast<int>(count))) {
+                    return false;
+                }
+            }
+
+            processor.done();
+
+            return true;
+        }
+
+        virtual long long getFrameCount() const
+        {
+            return known_length ? static_cast<long long>(samples_.size()) : -1;
+        }
+
+        static const int BUFFER_SIZE = 1000;
+
+        static std::atomic<int> run_count;
+        static bool known_length;
+
+        // run() reports an error for this file
+        static std::string failing_filename;
+
+    private:
+        std::string filename_;
+        std::vector<short> samples_;
+};
+
+std::atomic<int> RawAudioFileReader::run_count(0);
+bool RawAudioFileReader::known_length = true;
+std::string RawAudioFileReader::failing_filename;
+
+//------------------------------------------------------------------------------
+
+static std::unique_ptr<AudioFileReader> createRawAudioFileReader(
+    const boost::filesystem::path& /* filename */)
+{
+    return std::unique_ptr<AudioFileReader>(new RawAudioFileReader);
+}
+
+//------------------------------------------------------------------------------
+
+class SegmentedWaveformGeneratorTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            output.str(std::string());
+            error.str(std::string());
+
+            directory_ = FileUtil::getTempFilename(nullptr);
+            boost::filesystem::create_directory(directory_);
+
+            RawAudioFileReader::run_count = 0;
+            RawAudioFileReader::known_length = true;
+            RawAudioFileReader::failing_filename.clear();
+
+            srand(1);
+        }
+
+        virtual void TearDown()
+        {
+            boost::filesystem::remove_all(directory_);
+        }
+
+        boost::filesystem::path writeSegment(const std::string& name, int length);
+
+        void generateExpected(WaveformBuffer& buffer, int bits);
+
+        boost::filesystem::path directory_;
+        std::vector<boost::filesystem::path> filenames_;
+        std::vector<short> samples_;
+};
+
+//------------------------------------------------------------------------------
+
+// Writes a segment of random samples, and keeps a copy of all samples written
+// so far, as one stream.
+
+boost::filesystem::path SegmentedWaveformGeneratorTest::writeSegment(
+    const std::string& name,
+    const int length)
+{
+    const boost::filesystem::path filename = directory_ / name;
+
+    std::ofstream stream(filename.string().c_str(), std::ios::out | std::ios::binary);
+
+    for (int i = 0; i < length; ++i) {
+        const short sample = static_cast<short>(rand() % 65536 - 32768);
+
+        stream.write(reinterpret_cast<const char*>(&sample), sizeof(sample));
+        samples_.push_back(sample);
+    }
+
+    filenames_.push_back(filename);
+
+    return filename;
+}
+
+//------------------------------------------------------------------------------
+
+void SegmentedWaveformGeneratorTest::generateExpected(
+    WaveformBuffer& buffer,
+    const int bits)
+{
+    buffer.setBits(bits);
+
+    SamplesPerPixelScaleFactor scale_factor(64);
+    WaveformGenerator generator(buffer, scale_factor);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(16000, 1), 1000));
+    ASSERT_TRUE(generator.process(&samples_[0], static_cast<int>(samples_.size())));
+    generator.done();
+}
+
+//------------------------------------------------------------------------------
+
+static void checkBuffersEqual(const WaveformBuffer& actual, const WaveformBuffer& expected)
+{
+    ASSERT_THAT(actual.getSampleRate(), Eq(expected.getSampleRate()));
+    ASSERT_THAT(actual.getSamplesPerPixel(), Eq(expected.getSamplesPerPixel()));
+    ASSERT_THAT(actual.getBits(), Eq(expected.getBits()));
+    ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+
+    for (long long i = 0; i < expected.getSize(); ++i) {
+        ASSERT_THAT(actual.getMinSample(i), Eq(expected.getMinSample(i)));
+        ASSERT_THAT(actual.getMaxSample(i), Eq(expected.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(SegmentedWaveformGeneratorTest, shouldGenerateSameDataAsSingleStream)
+{
+    // Segments that start and end part way through a point, including one
+    // shorter than a point, and one that ends on a point boundary
+    const int lengths[] = { 1000, 37, 5, 2502, 64, 3000 };
+
+    for (int i = 0; i < 6; ++i) {
+        writeSegment(std::to_string(i) + ".raw", lengths[i]);
+    }
+
+    for (const int bits : { 16, 8 }) {
+        for (const bool known_length : { true, false }) {
+            RawAudioFileReader::known_length = known_length;
+
+            WaveformBuffer expected;
+            generateExpected(expected, bits);
+
+            WaveformBuffer buffer;
+            buffer.setBits(bits);
+
+            SamplesPerPixelScaleFactor scale_factor(64);
+            SegmentedWaveformGenerator generator(
+                createRawAudioFileReader,
+                scale_factor,
+                4
+            );
+
+            ASSERT_TRUE(generator.generate(filenames_, buffer));
+            ASSERT_THAT(generator.getFrameCount(), Eq(6608));
+
+            checkBuffersEqual(buffer, expected);
+        }
+    }
+
+    ASSERT_TRUE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+// Segments of unknown length are decoded together, and only those that don't
+// start at the assumed offset from the point boundaries are decoded again.
+
+TEST_F(SegmentedWaveformGeneratorTest, shouldDecodeSegmentsOfUnknownLengthTogether)
+{
+    // The last two segments start part way through a point
+    writeSegment("0.raw", 640);
+    writeSegment("1.raw", 1000);
+    writeSegment("2.raw", 2000);
+    writeSegment("3.raw", 24);
+
+    RawAudioFileReader::known_length = false;
+
+    WaveformBuffer buffer;
+
+    SamplesPerPixelScaleFactor scale_factor(64);
+    SegmentedWaveformGenerator generator(createRawAudioFileReader, scale_factor, 4);
+
+    ASSERT_TRUE(generator.generate(filenames_, buffer));
+
+    ASSERT_THAT(output.str(), HasSubstr("Decoding segments: 4\n"));
+    ASSERT_THAT(output.str(), HasSubstr("Decoding segments: 2\n"));
+    ASSERT_THAT(RawAudioFileReader::run_count.load(), Eq(6));
+
+    WaveformBuffer expected;
+    generateExpected(expected, 16);
+
+    checkBuffersEqual(buffer, expected);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(SegmentedWaveformGeneratorTest, shouldReportErrorIfSegmentCannotBeDecoded)
+{
+    for (int i = 0; i < 4; ++i) {
+        writeSegment(std::to_string(i) + ".raw", 1000);
+    }
+
+    RawAudioFileReader::failing_filename = filenames_[2].string();
+
+    WaveformBuffer buffer;
+
+    SamplesPerPixelScaleFactor scale_factor(64);
+    SegmentedWaveformGenerator generator(createRawAudioFileReader, scale_factor, 4);
+
+    ASSERT_FALSE(generator.generate(filenames_, buffer));
+
+    ASSERT_THAT(
+        error.str(),
+        Eq("Failed to decode: " + filenames_[2].string() + "\n")
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(SegmentedWaveformGeneratorTest, shouldDecodeOnlyNewSegmentsWhenCached)
+{
+    const boost::filesystem::path cache_directory = directory_ / "cache";
+
+    writeSegment("0.raw", 1000);
+    writeSegment("1.raw", 2030);
+    writeSegment("2.raw", 517);
+
+    SamplesPerPixelScaleFactor scale_factor(64);
+
+    {
+        WaveformBuffer buffer;
+
+        SegmentedWaveformGenerator generator(createRawAudioFileReader, scale_factor, 2);
+        generator.setCacheDirectory(cache_directory);
+
+        ASSERT_TRUE(generator.generate(filenames_, buffer));
+        ASSERT_THAT(RawAudioFileReader::run_count.load(), Eq(3));
+    }
+
+    writeSegment("3.raw", 4000);
+
+    RawAudioFileReader::run_count = 0;
+
+    WaveformBuffer buffer;
+
+    SegmentedWaveformGenerator generator(createRawAudioFileReader, scale_factor, 2);
+    generator.setCacheDirectory(cache_directory);
+
+    ASSERT_TRUE(generator.generate(filenames_, buffer));
+    ASSERT_THAT(RawAudioFileReader::run_count.load(), Eq(1));
+
+    WaveformBuffer expected;
+    generateExpected(expected, 16);
+
+    checkBuffersEqual(buffer, expected);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(SegmentedWaveformGeneratorTest, shouldNotUseCachedDataForChangedSegment)
+{
+    const boost::filesystem::path cache_directory = directory_ / "cache";
+
+    writeSegment("0.raw", 1000);
+    writeSegment("1.raw", 2030);
+
+    SamplesPerPixelScaleFactor scale_factor(64);
+
+    {
+        WaveformBuffer buffer;
+
+        SegmentedWaveformGenerator generator(createRawAudioFileReader, scale_factor, 2);
+        generator.setCacheDirectory(cache_directory);
+
+        ASSERT_TRUE(generator.generate(filenames_, buffer));
+    }
+
+    // Replace the first segment with a longer one, which moves the start of
+    // the second segment
+    samples_.clear();
+    filenames_.clear();
+
+    writeSegment("0.raw", 1001);
+    writeSegment("1.raw", 2030);
+
+    RawAudioFileReader::run_count = 0;
+
+    WaveformBuffer buffer;
+
+    SegmentedWaveformGenerator generator(createRawAudioFileReader, scale_factor, 2);
+    generator.setCacheDirectory(cache_directory);
+
+    ASSERT_TRUE(generator.generate(filenames_, buffer));
+    ASSERT_THAT(RawAudioFileReader::run_count.load(), Eq(2));
+
+    WaveformBuffer expected;
+    generateExpected(expected, 16);
+
+    checkBuffersEqual(buffer, expected);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(SegmentedWaveformGeneratorTest, shouldReadPlaylist)
+{
+    const boost::filesystem::path filename = directory_ / "test.m3u";
+
+    std::ofstream stream(filename.string().c_str());
+
+    stream << "#EXTM3U\r\n"
+           << "#EXTINF:10,First\r\n"
+           << "first.mp3\r\n"
+           << "\r\n"
+           << "  segments/second.wav\n"
+           << "/audio/third.flac\n";
+
+    stream.close();
+
+    std::vector<boost::filesystem::path> filenames;
+
+    bool result = SegmentedWaveformGenerator::readPlaylist(filename, filenames);
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(filenames.size(), Eq(3U));
+    ASSERT_THAT(filenames[0], Eq(directory_ / "first.mp3"));
+    ASSERT_THAT(filenames[1], Eq(directory_ / "segments/second.wav"));
+    ASSERT_THAT(filenames[2], Eq(boost::filesystem::path("/audio/third.flac")));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(SegmentedWaveformGeneratorTest, shouldReportErrorIfPlaylistIsEmpty)
+{
+    const boost::filesystem::path filename = directory_ / "test.m3u";
+
+    std::ofstream stream(filename.string().c_str());
+    stream << "#EXTM3U\n";
+    stream.close();
+
+    std::vector<boost::filesystem::path> filenames;
+
+    bool result = SegmentedWaveformGenerator::readPlaylist(filename, filenames);
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), HasSubstr("No audio files listed in playlist"));
+}
+
+//------------------------------------------------------------------------------
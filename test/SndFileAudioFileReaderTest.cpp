@@ -34,6 +34,8 @@
 //------------------------------------------------------------------------------
 
 using testing::_;
+using testing::AllOf;
+using testing::Field;
 using testing::EndsWith;
 using testing::Eq;
 using testing::HasSubstr;
@@ -89,6 +91,18 @@ TEST_F(SndFileAudioFileReaderTest, shouldOpenFlacFile)
 
 //------------------------------------------------------------------------------
 
+TEST_F(SndFileAudioFileReaderTest, shouldReturnFrameCountFromFileHeader)
+{
+    ASSERT_THAT(reader_.getFrameCount(), Eq(-1));
+
+    bool result = reader_.open("../test/data/test_file_stereo.wav");
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(reader_.getFrameCount(), Eq(115200));
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(SndFileAudioFileReaderTest, shouldReportErrorIfFileNotFound)
 {
     const char* filename = "../test/data/unknown.wav";
@@ -107,7 +121,7 @@ TEST_F(SndFileAudioFileReaderTest, shouldFailToProcessIfFileNotOpen)
 {
     StrictMock<MockAudioProcessor> processor;
 
-    EXPECT_CALL(processor, init(_, _, _)).Times(0);
+    EXPECT_CALL(processor, init(_, _)).Times(0);
     EXPECT_CALL(processor, process(_, _)).Times(0);
     EXPECT_CALL(processor, done()).Times(0);
 
@@ -134,7 +148,14 @@ static void testProcessStereo(const std::string& filename, const std::string& fo
 
     InSequence sequence; // Calls expected in the order listed below.
 
-    EXPECT_CALL(processor, init(16000, 2, 16384)).WillOnce(Return(true));
+    EXPECT_CALL(processor, init(
+        AllOf(
+            StreamInfo(16000, 2),
+            Field(&AudioStreamInfo::frame_count, 115200),
+            Field(&AudioStreamInfo::sample_format, SAMPLE_FORMAT_PCM_16)
+        ),
+        16384
+    )).WillOnce(Return(true));
 
     // Total number of frames: 115200, 14 x 8192 frames then 1 x 512
     EXPECT_CALL(processor, process(_, 8192)).Times(14).WillRepeatedly(Return(true));
@@ -206,7 +227,7 @@ static void testProcessMono(const std::string& filename, const std::string& form
 
     InSequence sequence; // Calls expected in the order listed below.
 
-    EXPECT_CALL(processor, init(16000, 1, 16384)).WillOnce(Return(true));
+    EXPECT_CALL(processor, init(StreamInfo(16000, 1), 16384)).WillOnce(Return(true));
 
     // Total number of frames: 115190, 7 x 16384 frames then 1 x 502
     EXPECT_CALL(processor, process(_, 16384)).Times(7).WillRepeatedly(Return(true));
@@ -264,7 +285,7 @@ TEST_F(SndFileAudioFileReaderTest, shouldNotProcessFileMoreThanOnce)
 
     InSequence sequence; // Calls expected in the order listed below.
 
-    EXPECT_CALL(processor, init(16000, 2, 16384)).WillOnce(Return(true));
+    EXPECT_CALL(processor, init(StreamInfo(16000, 2), 16384)).WillOnce(Return(true));
 
     // Total number of frames: 115200, 14 x 8192 frames then 1 x 512
     EXPECT_CALL(processor, process(_, 8192)).Times(14).WillRepeatedly(Return(true));
@@ -285,6 +306,37 @@ TEST_F(SndFileAudioFileReaderTest, shouldNotProcessFileMoreThanOnce)
 
 //------------------------------------------------------------------------------
 
+TEST_F(SndFileAudioFileReaderTest, shouldProcessRangeOfWavFile)
+{
+    bool result = reader_.open("../test/data/test_file_stereo.wav");
+    ASSERT_TRUE(result);
+
+    StrictMock<MockAudioProcessor> processor;
+
+    InSequence sequence; // Calls expected in the order listed below.
+
+    EXPECT_CALL(processor, init(
+        AllOf(
+            StreamInfo(16000, 2),
+            Field(&AudioStreamInfo::frame_count, 15200)
+        ),
+        16384
+    )).WillOnce(Return(true));
+
+    // Frames 100000 to 115199 (end of file), 1 x 8192 frames then 1 x 7008
+    EXPECT_CALL(processor, process(_, 8192)).Times(1).WillOnce(Return(true));
+    EXPECT_CALL(processor, process(_, 7008)).Times(1).WillOnce(Return(true));
+    EXPECT_CALL(processor, done()).Times(1);
+
+    result = reader_.runRange(processor, 100000, 20000);
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output.str(), HasSubstr("Read 15200 frames"));
+    ASSERT_TRUE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(SndFileAudioFileReaderTest, shouldReportErrorIfNotAWavFile)
 {
     const char* filename = "../test/data/test_file_stereo.mp3";
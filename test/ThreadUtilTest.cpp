@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2013, 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+
+#include "ThreadUtil.h"
+#include "util/Streams.h"
+
+#include "gmock/gmock.h"
+
+#include <atomic>
+#include <ostream>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::StrEq;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class ThreadUtilTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            output.str(std::string());
+            error.str(std::string());
+        }
+};
+
+//------------------------------------------------------------------------------
+
+TEST_F(ThreadUtilTest, shouldRunEachTaskOnce)
+{
+    std::vector<std::atomic<int>> counts(100);
+
+    for (auto& count : counts) {
+        count = 0;
+    }
+
+    bool success = ThreadUtil::runTasks(
+        100,
+        4,
+        [&counts](const int index, std::ostream& /* errors */) {
+            ++counts[static_cast<size_t>(index)];
+            return true;
+        }
+    );
+
+    ASSERT_TRUE(success);
+    ASSERT_TRUE(error.str().empty());
+
+    for (const auto& count : counts) {
+        ASSERT_THAT(count.load(), Eq(1));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(ThreadUtilTest, shouldReportErrorIfTaskFails)
+{
+    std::atomic<int> task_count(0);
+
+    bool success = ThreadUtil::runTasks(
+        100,
+        1,
+        [&task_count](const int index, std::ostream& errors) {
+            ++task_count;
+
+            if (index == 2) {
+                errors << "Task failed: " << index << '\n';
+                return false;
+            }
+
+            return true;
+        }
+    );
+
+    ASSERT_FALSE(success);
+    ASSERT_THAT(error.str(), StrEq("Task failed: 2\n"));
+
+    // No more tasks are started after one fails
+    ASSERT_THAT(task_count.load(), Eq(3));
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,206 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "TileRenderer.h"
+#include "GdImageRenderer.h"
+#include "WaveformBuffer.h"
+#include "WaveformColors.h"
+#include "util/FileUtil.h"
+#include "util/Streams.h"
+
+#include "gmock/gmock.h"
+
+//------------------------------------------------------------------------------
+
+using testing::EndsWith;
+using testing::Eq;
+using testing::HasSubstr;
+using testing::StartsWith;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class TileRendererTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            output.str(std::string());
+            error.str(std::string());
+
+            directory_ = FileUtil::getTempFilename(nullptr);
+        }
+
+        virtual void TearDown()
+        {
+            boost::filesystem::remove_all(directory_);
+        }
+
+        boost::filesystem::path directory_;
+        WaveformBuffer buffer_;
+};
+
+//------------------------------------------------------------------------------
+
+TEST_F(TileRendererTest, shouldRenderTilesAtEachZoomLevel)
+{
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    TileRenderer renderer(
+        256, 100, audacity_waveform_colors, true, true, -1, PngWriter::FILTER_DEFAULT, 4
+    );
+
+    const std::vector<int> zoom_levels = { 64, 256 };
+
+    result = renderer.render(buffer_, zoom_levels, directory_);
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+    ASSERT_THAT(output.str(), HasSubstr("Rendering tiles"));
+
+    // 64 samples per pixel: 1 tile per 256 points, rounded up
+    const long long tile_count = (buffer_.getSize() + 255) / 256;
+
+    for (long long i = 0; i < tile_count; ++i) {
+        const boost::filesystem::path filename =
+            directory_ / "64" / (std::to_string(i) + ".png");
+
+        ASSERT_TRUE(boost::filesystem::exists(filename));
+    }
+
+    ASSERT_FALSE(boost::filesystem::exists(
+        directory_ / "64" / (std::to_string(tile_count) + ".png")
+    ));
+
+    ASSERT_TRUE(boost::filesystem::exists(directory_ / "256" / "0.png"));
+
+    gdImagePtr image = FileUtil::readPngFile(directory_ / "256" / "0.png");
+    ASSERT_TRUE(image != nullptr);
+
+    ASSERT_THAT(gdImageSX(image), Eq(256));
+    ASSERT_THAT(gdImageSY(image), Eq(100));
+
+    gdImageDestroy(image);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(TileRendererTest, shouldRenderSameImageAsGdImageRenderer)
+{
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    const int zoom = 64;
+
+    TileRenderer renderer(
+        100, 80, audacity_waveform_colors, true, false, -1, PngWriter::FILTER_DEFAULT, 2
+    );
+
+    result = renderer.render(buffer_, std::vector<int>(1, zoom), directory_);
+    ASSERT_TRUE(result);
+
+    gdImagePtr tile = FileUtil::readPngFile(directory_ / "64" / "3.png");
+    ASSERT_TRUE(tile != nullptr);
+
+    // Render the same region, starting at pixel 300
+    const boost::filesystem::path filename = directory_ / "expected.png";
+
+    GdImageRenderer image_renderer;
+
+    const double start_time = 300.0 * zoom / buffer_.getSampleRate();
+
+    result = image_renderer.create(buffer_, start_time, 100, 80, audacity_waveform_colors, true);
+    ASSERT_TRUE(result);
+
+    result = image_renderer.saveAsPng(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    gdImagePtr expected = FileUtil::readPngFile(filename);
+    ASSERT_TRUE(expected != nullptr);
+
+    int mismatches = 0;
+
+    for (int y = 0; y < 80; ++y) {
+        for (int x = 0; x < 100; ++x) {
+            if (gdImageGetTrueColorPixel(tile, x, y) !=
+                gdImageGetTrueColorPixel(expected, x, y)) {
+                mismatches++;
+            }
+        }
+    }
+
+    gdImageDestroy(tile);
+    gdImageDestroy(expected);
+
+    ASSERT_THAT(mismatches, Eq(0));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(TileRendererTest, shouldReportErrorIfZoomIsLessThanInputZoom)
+{
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    output.str(std::string());
+
+    TileRenderer renderer(
+        256, 100, audacity_waveform_colors, true, false, -1, PngWriter::FILTER_DEFAULT, 1
+    );
+
+    result = renderer.render(buffer_, std::vector<int>(1, 32), directory_);
+
+    ASSERT_FALSE(result);
+    ASSERT_TRUE(output.str().empty());
+
+    std::string str = error.str();
+    ASSERT_THAT(str, StartsWith("Invalid zoom, minimum: 64"));
+    ASSERT_THAT(str, EndsWith("\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(TileRendererTest, shouldReportErrorIfTileCannotBeWritten)
+{
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    // A directory in place of the first tile makes it fail to open
+    boost::filesystem::create_directories(directory_ / "64" / "0.png");
+
+    TileRenderer renderer(
+        256, 100, audacity_waveform_colors, true, false, -1, PngWriter::FILTER_DEFAULT, 4
+    );
+
+    result = renderer.render(buffer_, std::vector<int>(1, 64), directory_);
+
+    ASSERT_FALSE(result);
+
+    std::string str = error.str();
+    ASSERT_THAT(str, StartsWith("Failed to write PNG file: "));
+    ASSERT_THAT(str, HasSubstr("0.png\n"));
+    ASSERT_THAT(str, EndsWith("\n"));
+}
+
+//------------------------------------------------------------------------------
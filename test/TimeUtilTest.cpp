@@ -61,6 +61,10 @@ TEST(TimeUtilTest, shouldConvertSecondsToString)
     ASSERT_THAT(str, StrEq("169:01:01"));
     ASSERT_THAT(result, Eq(9));
 
+    result = TimeUtil::secondsToString(str, ARRAY_LENGTH(str), 3000000000LL);
+    ASSERT_THAT(str, StrEq("833333:20:00"));
+    ASSERT_THAT(result, Eq(12));
+
     char short_str[3];
     result = TimeUtil::secondsToString(short_str, ARRAY_LENGTH(short_str), 121);
     ASSERT_THAT(short_str, StrEq("02"));
@@ -30,9 +30,12 @@
 
 #include <boost/filesystem.hpp>
 
+#include <sys/stat.h>
+
 //------------------------------------------------------------------------------
 
 using testing::Eq;
+using testing::Lt;
 
 //------------------------------------------------------------------------------
 
@@ -65,7 +68,7 @@ TEST_F(WavFileWriterTest, shouldCreateEmptyWavFile)
     const int channels    = 1;
     const int BUFFER_SIZE = 1024;
 
-    bool success = writer.init(sample_rate, channels, BUFFER_SIZE);
+    bool success = writer.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
     ASSERT_TRUE(success);
 
     writer.done();
@@ -98,7 +101,7 @@ TEST_F(WavFileWriterTest, shouldCreateMonoWavFile)
     const int channels    = 1;
     const int BUFFER_SIZE = 1024;
 
-    bool success = writer.init(sample_rate, channels, BUFFER_SIZE);
+    bool success = writer.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
     ASSERT_TRUE(success);
 
     short samples[BUFFER_SIZE];
@@ -128,6 +131,50 @@ TEST_F(WavFileWriterTest, shouldCreateMonoWavFile)
 
 //------------------------------------------------------------------------------
 
+TEST_F(WavFileWriterTest, shouldReleasePreallocatedSpaceWhenDone)
+{
+    boost::filesystem::path filename = FileUtil::getTempFilename();
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    WavFileWriter writer(filename.string().c_str());
+
+    const int BUFFER_SIZE = 1024;
+
+    // Expect more frames than are written, as for an estimated length.
+    AudioStreamInfo info(44100, 1);
+    info.frame_count = 100000;
+
+    bool success = writer.init(info, BUFFER_SIZE);
+    ASSERT_TRUE(success);
+
+    short samples[BUFFER_SIZE];
+    memset(samples, 0, sizeof(samples));
+
+    success = writer.process(samples, BUFFER_SIZE);
+    ASSERT_TRUE(success);
+
+    writer.done();
+
+    boost::uintmax_t size = boost::filesystem::file_size(filename);
+
+    // Check file size: 44 byte WAV header + 1024 * 2 bytes waveform data
+    ASSERT_THAT(size, Eq(44U + 1024 * 2));
+
+    // The space reserved for 100000 frames doesn't change the file size, so
+    // check the allocated blocks, which should be well under the 200044 bytes
+    // reserved
+    struct stat stat_buf;
+    ASSERT_THAT(stat(filename.string().c_str(), &stat_buf), Eq(0));
+
+    ASSERT_THAT(static_cast<long long>(stat_buf.st_blocks) * 512, Lt(100000));
+
+    ASSERT_TRUE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(WavFileWriterTest, shouldReportErrorIfUnableToCreateFile)
 {
     // Attempt to create wav file in a directory that does not exist.
@@ -140,7 +187,7 @@ TEST_F(WavFileWriterTest, shouldReportErrorIfUnableToCreateFile)
     const int channels    = 1;
     const int BUFFER_SIZE = 1024;
 
-    bool success = writer.init(sample_rate, channels, BUFFER_SIZE);
+    bool success = writer.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
     ASSERT_FALSE(success);
 
     // Check error is reported.
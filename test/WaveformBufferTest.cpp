@@ -28,6 +28,8 @@
 
 #include "gmock/gmock.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 
 //------------------------------------------------------------------------------
@@ -36,6 +38,7 @@ using testing::EndsWith;
 using testing::Eq;
 using testing::Gt;
 using testing::HasSubstr;
+using testing::Lt;
 using testing::Ne;
 using testing::StrEq;
 using testing::Test;
@@ -131,9 +134,65 @@ TEST_F(WaveformBufferTest, shouldLoadValid8BitDataFile)
 
 //------------------------------------------------------------------------------
 
-TEST_F(WaveformBufferTest, shouldNotLoadDataFileIfNotVersion1)
+TEST_F(WaveformBufferTest, shouldStore8BitDataAsLoaded)
 {
-    const char* filename = "../test/data/version2.dat";
+    bool result = buffer_.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(buffer_.getBits(), Eq(8));
+
+    const int8_t* samples;
+    ASSERT_THAT(buffer_.getSamples8(0, samples), Eq(1800));
+
+    for (int i = 0; i < buffer_.getSize(); ++i) {
+        ASSERT_THAT(buffer_.getMinSample(i), Eq(samples[2 * i] * 256));
+        ASSERT_THAT(buffer_.getMaxSample(i), Eq(samples[2 * i + 1] * 256));
+    }
+
+    // Saving at 8 bits writes the data unchanged
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    result = buffer_.save(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(
+        FileUtil::readFile(filename),
+        Eq(FileUtil::readFile("../test/data/test_file_stereo_8bit_64spp.dat"))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferTest, shouldLoadVersion2DataFile)
+{
+    // As test_file_stereo_8bit_64spp.dat, with a channels field
+    bool result = buffer_.load("../test/data/version2.dat");
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(buffer_.getSampleRate(), Eq(16000));
+    ASSERT_THAT(buffer_.getSamplesPerPixel(), Eq(64));
+    ASSERT_THAT(buffer_.getBits(), Eq(8));
+    ASSERT_THAT(buffer_.getSize(), Eq(1800));
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer expected;
+    result = expected.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    for (int i = 0; i < expected.getSize(); ++i) {
+        ASSERT_THAT(buffer_.getMinSample(i), Eq(expected.getMinSample(i)));
+        ASSERT_THAT(buffer_.getMaxSample(i), Eq(expected.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferTest, shouldNotLoadDataFileWithUnsupportedVersion)
+{
+    const char* filename = "../test/data/unsupported_version.dat";
 
     bool result = buffer_.load(filename);
     ASSERT_FALSE(result);
@@ -143,7 +202,7 @@ TEST_F(WaveformBufferTest, shouldNotLoadDataFileIfNotVersion1)
 
     str = error.str();
     ASSERT_THAT(str, HasSubstr(filename));
-    ASSERT_THAT(str, HasSubstr("Cannot load data file version: 2"));
+    ASSERT_THAT(str, HasSubstr("Cannot load data file version: 99"));
     ASSERT_THAT(str, EndsWith("\n"));
 }
 
@@ -226,6 +285,130 @@ TEST_F(WaveformBufferTest, shouldLoadDataFileIfSizeIsZero)
 
 //------------------------------------------------------------------------------
 
+TEST_F(WaveformBufferTest, shouldLoadJsonDataFile)
+{
+    bool result = buffer_.loadJson("../test/data/test_file_stereo_8bit_64spp.json");
+    ASSERT_TRUE(result);
+
+    std::string expected_output(
+        "Reading waveform data file: ../test/data/test_file_stereo_8bit_64spp.json\n"
+        "Sample rate: 16000 Hz\n"
+        "Bits: 8\n"
+        "Samples per pixel: 64\n"
+        "Length: 1800 points\n"
+    );
+
+    ASSERT_THAT(output.str(), StrEq(expected_output));
+    ASSERT_TRUE(error.str().empty());
+
+    WaveformBuffer expected;
+    result = expected.load("../test/data/test_file_stereo_8bit_64spp.dat");
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(buffer_.getBits(), Eq(8));
+    ASSERT_THAT(buffer_.getSize(), Eq(expected.getSize()));
+
+    for (int i = 0; i < expected.getSize(); ++i) {
+        ASSERT_THAT(buffer_.getMinSample(i), Eq(expected.getMinSample(i)));
+        ASSERT_THAT(buffer_.getMaxSample(i), Eq(expected.getMaxSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+static void writeTextFile(const boost::filesystem::path& filename, const char* text)
+{
+    std::ofstream file(filename.string().c_str());
+    file << text;
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferTest, shouldLoadJsonDataFileWithFieldsInAnyOrder)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".json");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    writeTextFile(
+        filename,
+        "{\n"
+        "  \"bits\": 16,\n"
+        "  \"data\": [ -10, 10, -20000, 20000 ],\n"
+        "  \"description\": { \"title\": \"test\", \"tags\": [ 1, true ] },\n"
+        "  \"length\": 2,\n"
+        "  \"sample_rate\": 48000,\n"
+        "  \"samples_per_pixel\": 512\n"
+        "}\n"
+    );
+
+    bool result = buffer_.loadJson(filename.string().c_str());
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_THAT(buffer_.getSampleRate(), Eq(48000));
+    ASSERT_THAT(buffer_.getSamplesPerPixel(), Eq(512));
+    ASSERT_THAT(buffer_.getBits(), Eq(16));
+    ASSERT_THAT(buffer_.getSize(), Eq(2));
+    ASSERT_THAT(buffer_.getMinSample(0), Eq(-10));
+    ASSERT_THAT(buffer_.getMaxSample(0), Eq(10));
+    ASSERT_THAT(buffer_.getMinSample(1), Eq(-20000));
+    ASSERT_THAT(buffer_.getMaxSample(1), Eq(20000));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferTest, shouldReportErrorIfJsonDataFileInvalid)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".json");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    const char* files[] = {
+        "",
+        "[]",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[-1,1]",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[-1,1]}}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[-1,200]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[-1,1,2]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[-1,1.5]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":12,\"length\":1,\"data\":[-1,1]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"data\":[-1,1],\"bits\":8,\"length\":1}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":1,\"bits\":8,\"length\":1,\"data\":[-1,1]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[-1,1],\"rms\":[1,1]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[-1,1],\"rms\":[-1]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"data\":[[-1,1],[-2,2,-3,3]]}",
+        "{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":1,\"channels\":3,\"data\":[[-1,1],[-2,2]]}"
+    };
+
+    for (const char* text : files) {
+        writeTextFile(filename, text);
+
+        error.str(std::string());
+
+        bool result = buffer_.loadJson(filename.string().c_str());
+        ASSERT_FALSE(result);
+
+        ASSERT_THAT(error.str(), HasSubstr("Failed to read data file"));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferTest, shouldReportErrorIfJsonFileNotFound)
+{
+    const char* filename = "../test/data/unknown.json";
+
+    bool result = buffer_.loadJson(filename);
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), HasSubstr(filename));
+}
+
+//------------------------------------------------------------------------------
+
 TEST_F(WaveformBufferSaveTest, shouldSaveEmptyDataFile)
 {
     const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
@@ -296,19 +479,43 @@ TEST_F(WaveformBufferSaveTest, shouldSave8BitDataFile)
 
 //------------------------------------------------------------------------------
 
-TEST_F(WaveformBufferSaveTest, shouldReportErrorIfNot8Or16Bits)
+TEST_F(WaveformBufferSaveTest, shouldConvertDataWhenBitsChanged)
 {
-    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
 
-    bool result = buffer_.save(filename.string().c_str(), 10);
-    ASSERT_FALSE(result);
+    buffer_.appendSamples(-1000, 1000);
+    buffer_.appendSamples(-32768, 32767);
 
-    ASSERT_FALSE(error.str().empty());
+    buffer_.setBits(8);
+
+    ASSERT_THAT(buffer_.getBits(), Eq(8));
+    ASSERT_THAT(buffer_.getSize(), Eq(2));
+    ASSERT_THAT(buffer_.getMinSample(0), Eq(-768));
+    ASSERT_THAT(buffer_.getMaxSample(0), Eq(768));
+    ASSERT_THAT(buffer_.getMinSample(1), Eq(-32768));
+    ASSERT_THAT(buffer_.getMaxSample(1), Eq(32512));
+
+    buffer_.appendSamples(-2048, 2048);
+
+    ASSERT_THAT(buffer_.getSize(), Eq(3));
+
+    const int8_t* samples;
+    ASSERT_THAT(buffer_.getSamples8(2, samples), Eq(1));
+    ASSERT_THAT(samples[0], Eq(-8));
+    ASSERT_THAT(samples[1], Eq(8));
+
+    buffer_.setBits(16);
+
+    ASSERT_THAT(buffer_.getBits(), Eq(16));
+    ASSERT_THAT(buffer_.getSize(), Eq(3));
+    ASSERT_THAT(buffer_.getMinSample(0), Eq(-768));
+    ASSERT_THAT(buffer_.getMaxSample(2), Eq(2048));
 }
 
 //------------------------------------------------------------------------------
 
-TEST_F(WaveformBufferSaveTest, shouldSave16BitTextFile)
+TEST_F(WaveformBufferSaveTest, shouldSave8BitDataAs16Bit)
 {
     const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
 
@@ -317,27 +524,26 @@ TEST_F(WaveformBufferSaveTest, shouldSave16BitTextFile)
 
     buffer_.setSampleRate(44100);
     buffer_.setSamplesPerPixel(256);
+    buffer_.setBits(8);
 
     buffer_.appendSamples(-1024, 1024);
-    buffer_.appendSamples(-2048, 2048);
 
-    bool result = buffer_.saveAsText(filename.string().c_str());
+    bool result = buffer_.save(filename.string().c_str(), 16);
     ASSERT_TRUE(result);
 
-    // Check file was created.
-    //boost::system::error_code error_code;
-    boost::uintmax_t size = boost::filesystem::file_size(filename);
-
-    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
-    ASSERT_THAT(size, Gt(0U));
+    WaveformBuffer buffer;
+    result = buffer.load(filename.string().c_str());
+    ASSERT_TRUE(result);
 
-    const std::string data = FileUtil::readTextFile(filename.string().c_str());
-    ASSERT_THAT(data, StrEq("-1024,1024\n-2048,2048\n"));
+    ASSERT_THAT(buffer.getBits(), Eq(16));
+    ASSERT_THAT(buffer.getSize(), Eq(1));
+    ASSERT_THAT(buffer.getMinSample(0), Eq(-1024));
+    ASSERT_THAT(buffer.getMaxSample(0), Eq(1024));
 }
 
 //------------------------------------------------------------------------------
 
-TEST_F(WaveformBufferSaveTest, shouldSave8BitTextFile)
+TEST_F(WaveformBufferSaveTest, shouldAppendToDataFile)
 {
     const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
 
@@ -347,26 +553,45 @@ TEST_F(WaveformBufferSaveTest, shouldSave8BitTextFile)
     buffer_.setSampleRate(44100);
     buffer_.setSamplesPerPixel(256);
 
-    buffer_.appendSamples(-1024, 1024);
-    buffer_.appendSamples(-2048, 2048);
+    buffer_.appendSamples(-100, 100);
+    buffer_.appendSamples(-200, 200);
+    buffer_.appendSamples(-300, 300);
 
-    bool result = buffer_.saveAsText(filename.string().c_str(), 8);
+    bool result = buffer_.save(filename.string().c_str());
     ASSERT_TRUE(result);
 
-    // Check file was created.
-    //boost::system::error_code error_code;
-    boost::uintmax_t size = boost::filesystem::file_size(filename);
+    // Replace the last point and add two more
+    WaveformBuffer append_buffer;
+    append_buffer.setSampleRate(44100);
+    append_buffer.setSamplesPerPixel(256);
 
-    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
-    ASSERT_THAT(size, Gt(0U));
+    append_buffer.appendSamples(-301, 301);
+    append_buffer.appendSamples(-400, 400);
+    append_buffer.appendSamples(-500, 500);
 
-    const std::string data = FileUtil::readTextFile(filename);
-    ASSERT_THAT(data, StrEq("-4,4\n-8,8\n"));
+    result = append_buffer.appendToFile(filename.string().c_str(), 2);
+    ASSERT_TRUE(result);
+
+    // 20 byte header + 5 points * 4 bytes
+    ASSERT_THAT(boost::filesystem::file_size(filename), Eq(40U));
+
+    WaveformBuffer buffer;
+    result = buffer.load(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(buffer.getSize(), Eq(5));
+
+    const short expected[] = { 100, 200, 301, 400, 500 };
+
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Eq(-expected[i]));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(expected[i]));
+    }
 }
 
 //------------------------------------------------------------------------------
 
-TEST_F(WaveformBufferSaveTest, shouldSave16BitJsonFile)
+TEST_F(WaveformBufferSaveTest, shouldNotAppendToDataFileWithDifferentScale)
 {
     const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
 
@@ -375,27 +600,178 @@ TEST_F(WaveformBufferSaveTest, shouldSave16BitJsonFile)
 
     buffer_.setSampleRate(44100);
     buffer_.setSamplesPerPixel(256);
+    buffer_.appendSamples(-100, 100);
 
-    buffer_.appendSamples(-1024, 1024);
-    buffer_.appendSamples(-2048, 2048);
+    bool result = buffer_.save(filename.string().c_str());
+    ASSERT_TRUE(result);
 
-    bool result = buffer_.saveAsJson(filename.string().c_str());
+    WaveformBuffer append_buffer;
+    append_buffer.setSampleRate(44100);
+    append_buffer.setSamplesPerPixel(512);
+    append_buffer.appendSamples(-200, 200);
+
+    result = append_buffer.appendToFile(filename.string().c_str(), 1);
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), HasSubstr("Data file does not match waveform data"));
+    ASSERT_THAT(boost::filesystem::file_size(filename), Eq(24U));
+}
+
+//------------------------------------------------------------------------------
+
+// Fills the buffer with a slowly changing waveform, like real audio, so that
+// compression is effective.
+
+static void appendWaveform(WaveformBuffer& buffer, const int size)
+{
+    srand(3);
+
+    int value = 0;
+
+    for (int i = 0; i < size; ++i) {
+        value = std::max(0, std::min(30000, value + rand() % 201 - 100));
+
+        const short max = static_cast<short>(value);
+        const short min = static_cast<short>(-value + rand() % 16);
+
+        buffer.appendSamples(min, max);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveAndLoadCompressedDataFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+    const boost::filesystem::path uncompressed_filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary files are deleted at end of test.
+    FileDeleter deleter(filename);
+    FileDeleter uncompressed_deleter(uncompressed_filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    // More than two blocks
+    appendWaveform(buffer_, 10000);
+
+    for (const int bits : { 16, 8 }) {
+        bool result = buffer_.save(filename.string().c_str(), bits, true);
+        ASSERT_TRUE(result);
+
+        result = buffer_.save(uncompressed_filename.string().c_str(), bits);
+        ASSERT_TRUE(result);
+
+        ASSERT_THAT(
+            boost::filesystem::file_size(filename),
+            Lt(boost::filesystem::file_size(uncompressed_filename))
+        );
+
+        WaveformBuffer buffer;
+        result = buffer.load(filename.string().c_str());
+        ASSERT_TRUE(result);
+
+        WaveformBuffer expected;
+        result = expected.load(uncompressed_filename.string().c_str());
+        ASSERT_TRUE(result);
+
+        ASSERT_THAT(buffer.getSampleRate(), Eq(44100));
+        ASSERT_THAT(buffer.getSamplesPerPixel(), Eq(256));
+        ASSERT_THAT(buffer.getBits(), Eq(bits));
+        ASSERT_THAT(buffer.getSize(), Eq(10000));
+
+        for (int i = 0; i < 10000; ++i) {
+            ASSERT_THAT(buffer.getMinSample(i), Eq(expected.getMinSample(i)));
+            ASSERT_THAT(buffer.getMaxSample(i), Eq(expected.getMaxSample(i)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldLoadRangeOfDataFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    appendWaveform(buffer_, 10000);
+
+    // Ranges within a block, spanning blocks, and past the end of the data
+    const long long ranges[][2] = {
+        { 0, 10 }, { 4000, 200 }, { 8191, 2 }, { 9990, 100 }, { 20000, 5 }
+    };
+
+    for (const bool compress : { false, true }) {
+        bool result = buffer_.save(filename.string().c_str(), 16, compress);
+        ASSERT_TRUE(result);
+
+        for (const auto& range : ranges) {
+            const long long start = range[0];
+            const long long count = std::max(
+                std::min(range[1], buffer_.getSize() - start),
+                0LL
+            );
+
+            WaveformBuffer buffer;
+            result = buffer.load(filename.string().c_str(), start, range[1]);
+            ASSERT_TRUE(result);
+
+            ASSERT_THAT(buffer.getSize(), Eq(count));
+
+            for (long long i = 0; i < count; ++i) {
+                ASSERT_THAT(buffer.getMinSample(i), Eq(buffer_.getMinSample(start + i)));
+                ASSERT_THAT(buffer.getMaxSample(i), Eq(buffer_.getMaxSample(start + i)));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldNotAppendToCompressedDataFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.appendSamples(-100, 100);
+
+    bool result = buffer_.save(filename.string().c_str(), 16, true);
     ASSERT_TRUE(result);
 
-    // Check file was created.
-    //boost::system::error_code error_code;
-    boost::uintmax_t size = boost::filesystem::file_size(filename);
+    error.str(std::string());
 
-    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
-    ASSERT_THAT(size, Gt(0U));
+    result = buffer_.appendToFile(filename.string().c_str(), 1);
+    ASSERT_FALSE(result);
 
-    const std::string data = FileUtil::readTextFile(filename);
-    ASSERT_THAT(data, StrEq("{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":16,\"length\":2,\"data\":[-1024,1024,-2048,2048]}\n"));
+    ASSERT_THAT(error.str(), HasSubstr("Cannot append to a compressed data file"));
 }
 
 //------------------------------------------------------------------------------
 
-TEST_F(WaveformBufferSaveTest, shouldSave8BitJsonFile)
+// Overwrites the length in the header of a data file, which is 32-bit in
+// versions 1 and 2, or 64-bit in later versions.
+
+template <typename T>
+static void writeLength(const boost::filesystem::path& filename, const T length)
+{
+    std::fstream file(filename.string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+
+    file.seekp(16);
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldReportErrorIfCompressedDataFileLengthTooLarge)
 {
     const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
 
@@ -404,22 +780,711 @@ TEST_F(WaveformBufferSaveTest, shouldSave8BitJsonFile)
 
     buffer_.setSampleRate(44100);
     buffer_.setSamplesPerPixel(256);
+    buffer_.appendSamples(-100, 100);
 
-    buffer_.appendSamples(-1024, 1024);
-    buffer_.appendSamples(-2048, 2048);
+    bool result = buffer_.save(filename.string().c_str(), 16, true);
+    ASSERT_TRUE(result);
 
-    bool result = buffer_.saveAsJson(filename.string().c_str(), 8);
+    writeLength(filename, static_cast<uint64_t>(1ULL << 62));
+
+    WaveformBuffer buffer;
+    result = buffer.load(filename.string().c_str());
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), HasSubstr("length too large for file size"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldLoadTruncatedDataFileWithLargeLength)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.appendSamples(-100, 100);
+    buffer_.appendSamples(-200, 200);
+
+    bool result = buffer_.save(filename.string().c_str());
     ASSERT_TRUE(result);
 
-    // Check file was created.
-    //boost::system::error_code error_code;
-    boost::uintmax_t size = boost::filesystem::file_size(filename);
+    writeLength(filename, static_cast<uint32_t>(0xffffffffU));
 
-    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
-    ASSERT_THAT(size, Gt(0U));
+    WaveformBuffer buffer;
+    buffer.load(filename.string().c_str());
 
-    const std::string data = FileUtil::readTextFile(filename);
+    ASSERT_THAT(buffer.getSize(), Eq(2));
+    ASSERT_THAT(error.str(), HasSubstr("Expected 4294967295 points, read 2"));
+}
+
+//------------------------------------------------------------------------------
+
+// Reads the version number from the header of a data file.
+
+static int readVersion(const boost::filesystem::path& filename)
+{
+    std::ifstream file(filename.string().c_str(), std::ios::in | std::ios::binary);
+
+    int32_t version = 0;
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+
+    return version;
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveAndLoadDataFileWithRms)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setRms(true);
+
+    srand(5);
+
+    for (int i = 0; i < 10000; ++i) {
+        const short max = static_cast<short>(rand() % 30000);
+        const short rms = static_cast<short>(max / 2 + rand() % 100);
+
+        buffer_.appendSamples(static_cast<short>(-max), max, rms);
+    }
+
+    for (const bool compress : { false, true }) {
+        for (const int bits : { 16, 8 }) {
+            bool result = buffer_.save(filename.string().c_str(), bits, compress);
+            ASSERT_TRUE(result);
+
+            ASSERT_THAT(readVersion(filename), Eq(4));
+
+            WaveformBuffer buffer;
+            result = buffer.load(filename.string().c_str());
+            ASSERT_TRUE(result);
+
+            ASSERT_TRUE(buffer.hasRms());
+            ASSERT_THAT(buffer.getBits(), Eq(bits));
+            ASSERT_THAT(buffer.getSize(), Eq(10000));
+
+            const int divisor = bits == 8 ? 256 : 1;
+
+            for (int i = 0; i < 10000; ++i) {
+                ASSERT_THAT(buffer.getMinSample(i), Eq(buffer_.getMinSample(i) / divisor * divisor));
+                ASSERT_THAT(buffer.getMaxSample(i), Eq(buffer_.getMaxSample(i) / divisor * divisor));
+                ASSERT_THAT(buffer.getRmsSample(i), Eq(buffer_.getRmsSample(i) / divisor * divisor));
+            }
+
+            // Points are read from the middle of the file
+            WaveformBuffer range_buffer;
+            result = range_buffer.load(filename.string().c_str(), 4000, 200);
+            ASSERT_TRUE(result);
+
+            ASSERT_THAT(range_buffer.getSize(), Eq(200));
+
+            for (int i = 0; i < 200; ++i) {
+                ASSERT_THAT(range_buffer.getMaxSample(i), Eq(buffer.getMaxSample(4000 + i)));
+                ASSERT_THAT(range_buffer.getRmsSample(i), Eq(buffer.getRmsSample(4000 + i)));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldNotAppendToDataFileWithRms)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setRms(true);
+    buffer_.appendSamples(-100, 100, 50);
+
+    bool result = buffer_.save(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    error.str(std::string());
+
+    result = buffer_.appendToFile(filename.string().c_str(), 1);
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), HasSubstr("Cannot append to a data file with RMS values"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveAndLoadMultiChannelDataFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setChannels(3);
+
+    srand(6);
+
+    for (int i = 0; i < 10000; ++i) {
+        for (int channel = 0; channel < 3; ++channel) {
+            const short max = static_cast<short>(rand() % 30000);
+            buffer_.appendSamples(static_cast<short>(-max), max);
+        }
+    }
+
+    for (const bool compress : { false, true }) {
+        for (const int bits : { 16, 8 }) {
+            bool result = buffer_.save(filename.string().c_str(), bits, compress);
+            ASSERT_TRUE(result);
+
+            // Uncompressed data is saved as version 2, with a 24 byte header
+            if (compress) {
+                ASSERT_THAT(readVersion(filename), Eq(3));
+            }
+            else {
+                ASSERT_THAT(readVersion(filename), Eq(2));
+                ASSERT_THAT(
+                    boost::filesystem::file_size(filename),
+                    Eq(24U + 10000U * 3U * 2U * static_cast<unsigned>(bits / 8))
+                );
+            }
+
+            WaveformBuffer buffer;
+            result = buffer.load(filename.string().c_str());
+            ASSERT_TRUE(result);
+
+            ASSERT_THAT(buffer.getChannels(), Eq(3));
+            ASSERT_THAT(buffer.getBits(), Eq(bits));
+            ASSERT_THAT(buffer.getSize(), Eq(10000));
+
+            const int divisor = bits == 8 ? 256 : 1;
+
+            for (int i = 0; i < 10000; ++i) {
+                for (int channel = 0; channel < 3; ++channel) {
+                    ASSERT_THAT(
+                        buffer.getMinSample(channel, i),
+                        Eq(buffer_.getMinSample(channel, i) / divisor * divisor)
+                    );
+
+                    ASSERT_THAT(
+                        buffer.getMaxSample(channel, i),
+                        Eq(buffer_.getMaxSample(channel, i) / divisor * divisor)
+                    );
+                }
+            }
+
+            // Points are read from the middle of the file
+            WaveformBuffer range_buffer;
+            result = range_buffer.load(filename.string().c_str(), 4000, 200);
+            ASSERT_TRUE(result);
+
+            ASSERT_THAT(range_buffer.getSize(), Eq(200));
+
+            for (int i = 0; i < 200; ++i) {
+                ASSERT_THAT(range_buffer.getMaxSample(2, i), Eq(buffer.getMaxSample(2, 4000 + i)));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldNotAppendToMultiChannelDataFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setChannels(2);
+    buffer_.appendSamples(-100, 100);
+    buffer_.appendSamples(-200, 200);
+
+    bool result = buffer_.save(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    error.str(std::string());
+
+    result = buffer_.appendToFile(filename.string().c_str(), 1);
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), HasSubstr("Cannot append to a multi-channel data file"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldReportErrorIfNot8Or16Bits)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    bool result = buffer_.save(filename.string().c_str(), 10);
+    ASSERT_FALSE(result);
+
+    ASSERT_FALSE(error.str().empty());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave16BitTextFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsText(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    // Check file was created.
+    //boost::system::error_code error_code;
+    boost::uintmax_t size = boost::filesystem::file_size(filename);
+
+    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
+    ASSERT_THAT(size, Gt(0U));
+
+    const std::string data = FileUtil::readTextFile(filename.string().c_str());
+    ASSERT_THAT(data, StrEq("-1024,1024\n-2048,2048\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave8BitTextFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsText(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    // Check file was created.
+    //boost::system::error_code error_code;
+    boost::uintmax_t size = boost::filesystem::file_size(filename);
+
+    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
+    ASSERT_THAT(size, Gt(0U));
+
+    const std::string data = FileUtil::readTextFile(filename);
+    ASSERT_THAT(data, StrEq("-4,4\n-8,8\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave16BitJsonFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsJson(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    // Check file was created.
+    //boost::system::error_code error_code;
+    boost::uintmax_t size = boost::filesystem::file_size(filename);
+
+    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
+    ASSERT_THAT(size, Gt(0U));
+
+    const std::string data = FileUtil::readTextFile(filename);
+    ASSERT_THAT(data, StrEq("{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":16,\"length\":2,\"data\":[-1024,1024,-2048,2048]}\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave8BitJsonFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsJson(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    // Check file was created.
+    //boost::system::error_code error_code;
+    boost::uintmax_t size = boost::filesystem::file_size(filename);
+
+    //ASSERT_THAT(error_code, Eq(boost::system::errc::success));
+    ASSERT_THAT(size, Gt(0U));
+
+    const std::string data = FileUtil::readTextFile(filename);
     ASSERT_THAT(data, StrEq("{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":8,\"length\":2,\"data\":[-4,4,-8,8]}\n"));
 }
 
 //------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveGzipCompressedJsonFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".json.gz");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsJson(filename.string().c_str(), 16, 9);
+    ASSERT_TRUE(result);
+
+    const std::string data = FileUtil::readGzipFile(filename);
+    ASSERT_THAT(data, StrEq("{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":16,\"length\":2,\"data\":[-1024,1024,-2048,2048]}\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveGzipCompressedTextFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".txt.gz");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsText(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    const std::string data = FileUtil::readGzipFile(filename);
+    ASSERT_THAT(data, StrEq("-4,4\n-8,8\n"));
+}
+
+//------------------------------------------------------------------------------
+
+static std::string readBinaryFile(const boost::filesystem::path& filename)
+{
+    const std::vector<uint8_t> data = FileUtil::readFile(filename);
+
+    return std::string(data.begin(), data.end());
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave16BitMsgPackFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsMsgPack(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    const char expected[] =
+        "\x85"
+        "\xab" "sample_rate" "\xcd\xac\x44"
+        "\xb1" "samples_per_pixel" "\xcd\x01\x00"
+        "\xa4" "bits" "\x10"
+        "\xa6" "length" "\x02"
+        "\xa4" "data" "\xc6\x00\x00\x00\x08"
+        "\x00\xfc\x00\x04\x00\xf8\x00\x08";
+
+    ASSERT_THAT(
+        readBinaryFile(filename),
+        Eq(std::string(expected, sizeof(expected) - 1))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave8BitMsgPackFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsMsgPack(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    const char expected[] =
+        "\x85"
+        "\xab" "sample_rate" "\xcd\xac\x44"
+        "\xb1" "samples_per_pixel" "\xcd\x01\x00"
+        "\xa4" "bits" "\x08"
+        "\xa6" "length" "\x02"
+        "\xa4" "data" "\xc6\x00\x00\x00\x04"
+        "\xfc\x04\xf8\x08";
+
+    ASSERT_THAT(
+        readBinaryFile(filename),
+        Eq(std::string(expected, sizeof(expected) - 1))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave16BitCborFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsCbor(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    const char expected[] =
+        "\xa5"
+        "\x6b" "sample_rate" "\x19\xac\x44"
+        "\x71" "samples_per_pixel" "\x19\x01\x00"
+        "\x64" "bits" "\x10"
+        "\x66" "length" "\x02"
+        "\x64" "data" "\xd8\x4d\x48"
+        "\x00\xfc\x00\x04\x00\xf8\x00\x08";
+
+    ASSERT_THAT(
+        readBinaryFile(filename),
+        Eq(std::string(expected, sizeof(expected) - 1))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSave8BitCborFile)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-2048, 2048);
+
+    bool result = buffer_.saveAsCbor(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    const char expected[] =
+        "\xa5"
+        "\x6b" "sample_rate" "\x19\xac\x44"
+        "\x71" "samples_per_pixel" "\x19\x01\x00"
+        "\x64" "bits" "\x08"
+        "\x66" "length" "\x02"
+        "\x64" "data" "\xd8\x48\x44"
+        "\xfc\x04\xf8\x08";
+
+    ASSERT_THAT(
+        readBinaryFile(filename),
+        Eq(std::string(expected, sizeof(expected) - 1))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveTextFileWithRms)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".txt");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setRms(true);
+
+    buffer_.appendSamples(-1024, 1024, 512);
+    buffer_.appendSamples(-2048, 2048, 1536);
+
+    bool result = buffer_.saveAsText(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    const std::string data = FileUtil::readTextFile(filename);
+    ASSERT_THAT(data, StrEq("-4,4,2\n-8,8,6\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveAndLoadJsonFileWithRms)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".json");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setRms(true);
+
+    buffer_.appendSamples(-1024, 1024, 512);
+    buffer_.appendSamples(-2048, 2048, 1536);
+
+    bool result = buffer_.saveAsJson(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    const std::string data = FileUtil::readTextFile(filename);
+    ASSERT_THAT(data, StrEq("{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":16,\"length\":2,\"data\":[-1024,1024,-2048,2048],\"rms\":[512,1536]}\n"));
+
+    WaveformBuffer buffer;
+    result = buffer.loadJson(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    ASSERT_TRUE(buffer.hasRms());
+    ASSERT_THAT(buffer.getSize(), Eq(2));
+    ASSERT_THAT(buffer.getRmsSample(0), Eq(512));
+    ASSERT_THAT(buffer.getRmsSample(1), Eq(1536));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveMsgPackFileWithRms)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".dat");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setRms(true);
+
+    buffer_.appendSamples(-1024, 1024, 512);
+    buffer_.appendSamples(-2048, 2048, 1536);
+
+    bool result = buffer_.saveAsMsgPack(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    const char expected[] =
+        "\x86"
+        "\xab" "sample_rate" "\xcd\xac\x44"
+        "\xb1" "samples_per_pixel" "\xcd\x01\x00"
+        "\xa4" "bits" "\x10"
+        "\xa6" "length" "\x02"
+        "\xa4" "data" "\xc6\x00\x00\x00\x08"
+        "\x00\xfc\x00\x04\x00\xf8\x00\x08"
+        "\xa3" "rms" "\xc6\x00\x00\x00\x04"
+        "\x00\x02\x00\x06";
+
+    ASSERT_THAT(
+        readBinaryFile(filename),
+        Eq(std::string(expected, sizeof(expected) - 1))
+    );
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveTextFileWithMultipleChannels)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".txt");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setChannels(2);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-512, 256);
+    buffer_.appendSamples(-2048, 2048);
+    buffer_.appendSamples(-768, 1280);
+
+    bool result = buffer_.saveAsText(filename.string().c_str(), 8);
+    ASSERT_TRUE(result);
+
+    const std::string data = FileUtil::readTextFile(filename);
+    ASSERT_THAT(data, StrEq("-4,4,-2,1\n-8,8,-3,5\n"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformBufferSaveTest, shouldSaveAndLoadJsonFileWithMultipleChannels)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".json");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    buffer_.setSampleRate(44100);
+    buffer_.setSamplesPerPixel(256);
+    buffer_.setChannels(2);
+
+    buffer_.appendSamples(-1024, 1024);
+    buffer_.appendSamples(-512, 256);
+    buffer_.appendSamples(-2048, 2048);
+    buffer_.appendSamples(-768, 1280);
+
+    bool result = buffer_.saveAsJson(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    const std::string data = FileUtil::readTextFile(filename);
+    ASSERT_THAT(data, StrEq("{\"sample_rate\":44100,\"samples_per_pixel\":256,\"bits\":16,\"length\":2,\"channels\":2,\"data\":[[-1024,1024,-2048,2048],[-512,256,-768,1280]]}\n"));
+
+    WaveformBuffer buffer;
+    result = buffer.loadJson(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    ASSERT_THAT(buffer.getChannels(), Eq(2));
+    ASSERT_THAT(buffer.getSize(), Eq(2));
+    ASSERT_THAT(buffer.getMinSample(0, 1), Eq(-2048));
+    ASSERT_THAT(buffer.getMaxSample(0, 1), Eq(2048));
+    ASSERT_THAT(buffer.getMinSample(1, 0), Eq(-512));
+    ASSERT_THAT(buffer.getMaxSample(1, 1), Eq(1280));
+}
+
+//------------------------------------------------------------------------------
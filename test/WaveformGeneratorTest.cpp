@@ -27,8 +27,11 @@
 
 #include "gmock/gmock.h"
 
+#include <algorithm>
 #include <climits>
+#include <cmath>
 #include <stdexcept>
+#include <vector>
 
 //------------------------------------------------------------------------------
 
@@ -61,6 +64,16 @@ TEST(DurationScaleFactorTest, shouldThrowIfWidthIsNegative)
 
 //------------------------------------------------------------------------------
 
+TEST(DurationScaleFactorTest, shouldComputeScaleForMultiDayDuration)
+{
+    // 72 hours at 48 kHz is more than 2^31 samples
+    DurationScaleFactor scale_factor(0.0, 72 * 60 * 60, 1000);
+
+    ASSERT_THAT(scale_factor.getSamplesPerPixel(48000), Eq(12441600));
+}
+
+//------------------------------------------------------------------------------
+
 TEST(PixelsPerSecondScaleFactorTest, shouldThrowIfZero)
 {
     ASSERT_THROW(PixelsPerSecondScaleFactor(0), std::runtime_error);
@@ -111,7 +124,7 @@ TEST_F(WaveformGeneratorTest, shouldFailIfSamplesPerPixelIsNegative)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_FALSE(result);
     ASSERT_THAT(error.str(), StrEq("Invalid zoom: minimum 2\n"));
@@ -129,7 +142,7 @@ TEST_F(WaveformGeneratorTest, shouldFailIfSamplesPerPixelIsZero)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_FALSE(result);
     ASSERT_THAT(error.str(), StrEq("Invalid zoom: minimum 2\n"));
@@ -147,7 +160,7 @@ TEST_F(WaveformGeneratorTest, shouldFailIfSamplesPerPixelIsOne)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_FALSE(result);
     ASSERT_THAT(error.str(), StrEq("Invalid zoom: minimum 2\n"));
@@ -165,7 +178,7 @@ TEST_F(WaveformGeneratorTest, shouldSucceedIfSamplesPerPixelIsTwo)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_TRUE(result);
     ASSERT_TRUE(error.str().empty());
@@ -183,7 +196,7 @@ TEST_F(WaveformGeneratorTest, shouldSucceedIfSamplesPerPixelIsLarge)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_TRUE(result);
     ASSERT_TRUE(error.str().empty());
@@ -202,7 +215,7 @@ TEST_F(WaveformGeneratorTest, shouldSucceedIfEndTimeGreaterThanStartTime)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_TRUE(result);
     ASSERT_TRUE(error.str().empty());
@@ -225,7 +238,7 @@ TEST_F(WaveformGeneratorTest, shouldFailIfSamplesPerPixelIsTooSmall)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_FALSE(result);
     ASSERT_THAT(error.str(), StrEq("Invalid zoom: minimum 2\n"));
@@ -246,7 +259,7 @@ TEST_F(WaveformGeneratorTest, shouldSetBufferAttributes)
     const int channels    = 2;
     const int BUFFER_SIZE = 1024;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_TRUE(result);
     ASSERT_TRUE(error.str().empty());
@@ -275,7 +288,7 @@ TEST_F(WaveformGeneratorTest, shouldComputeMaxAndMinValuesFromStereoInput)
 
     const int frames = BUFFER_SIZE / channels;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_TRUE(result);
     ASSERT_TRUE(error.str().empty());
@@ -338,7 +351,7 @@ TEST_F(WaveformGeneratorTest, shouldComputeMaxAndMinValuesFromMonoInput)
 
     const int frames = BUFFER_SIZE / channels;
 
-    bool result = generator.init(sample_rate, channels, BUFFER_SIZE);
+    bool result = generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE);
 
     ASSERT_TRUE(result);
     ASSERT_TRUE(error.str().empty());
@@ -375,3 +388,441 @@ TEST_F(WaveformGeneratorTest, shouldComputeMaxAndMinValuesFromMonoInput)
 }
 
 //------------------------------------------------------------------------------
+
+// Generating from two halves of the input, the second resumed from the first's
+// partial last point, gives the same points as generating in one go.
+
+TEST_F(WaveformGeneratorTest, shouldResumeFromPartialPoint)
+{
+    const int sample_rate = 44100;
+    const int channels    = 1;
+    const int BUFFER_SIZE = 1000;
+
+    short samples[BUFFER_SIZE];
+
+    srand(4);
+
+    for (int i = 0; i < BUFFER_SIZE; ++i) {
+        samples[i] = static_cast<short>(rand() % 65536 - 32768);
+    }
+
+    SamplesPerPixelScaleFactor scale_factor(300);
+
+    WaveformBuffer expected;
+    WaveformGenerator generator(expected, scale_factor);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE));
+    ASSERT_TRUE(generator.process(samples, BUFFER_SIZE));
+    generator.done();
+
+    WaveformBuffer first;
+    WaveformGenerator first_generator(first, scale_factor);
+
+    ASSERT_TRUE(first_generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE));
+    ASSERT_TRUE(first_generator.process(samples, 450));
+    first_generator.done();
+
+    int min;
+    int max;
+    int count;
+
+    first_generator.getPartialPoint(min, max, count);
+
+    ASSERT_THAT(first.getSize(), Eq(2));
+    ASSERT_THAT(count, Eq(150));
+
+    WaveformBuffer second;
+    WaveformGenerator second_generator(second, scale_factor);
+
+    second_generator.setPartialPoint(min, max, count);
+
+    ASSERT_TRUE(second_generator.init(AudioStreamInfo(sample_rate, channels), BUFFER_SIZE));
+    ASSERT_TRUE(second_generator.process(samples + 450, BUFFER_SIZE - 450));
+    second_generator.done();
+
+    // The second buffer replaces the first buffer's partial last point
+    ASSERT_THAT(expected.getSize(), Eq(4));
+    ASSERT_THAT(second.getSize(), Eq(3));
+
+    ASSERT_THAT(first.getMinSample(0), Eq(expected.getMinSample(0)));
+    ASSERT_THAT(first.getMaxSample(0), Eq(expected.getMaxSample(0)));
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_THAT(second.getMinSample(i), Eq(expected.getMinSample(i + 1)));
+        ASSERT_THAT(second.getMaxSample(i), Eq(expected.getMaxSample(i + 1)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Each RMS value is the root mean square of the point's mono samples, rounded
+// to the nearest integer.
+
+TEST_F(WaveformGeneratorTest, shouldComputeRmsValues)
+{
+    const int sample_rate = 44100;
+    const int channels    = 2;
+    const int frames      = 1000;
+
+    std::vector<short> samples(frames * channels);
+
+    srand(7);
+
+    for (auto& sample : samples) {
+        sample = static_cast<short>(rand() % 65536 - 32768);
+    }
+
+    // All samples of the last point are the minimum value, whose RMS is
+    // limited to the maximum value
+    std::fill(samples.begin() + 900 * channels, samples.end(), SHRT_MIN);
+
+    WaveformBuffer buffer;
+    buffer.setRms(true);
+
+    SamplesPerPixelScaleFactor scale_factor(300);
+    WaveformGenerator generator(buffer, scale_factor);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(sample_rate, channels), frames));
+
+    // Process in uneven parts, so points span calls
+    ASSERT_TRUE(generator.process(&samples[0], 333));
+    ASSERT_TRUE(generator.process(&samples[333 * channels], frames - 333));
+    generator.done();
+
+    ASSERT_THAT(buffer.getSize(), Eq(4));
+
+    for (int i = 0; i < 3; ++i) {
+        double sum_squares = 0.0;
+
+        for (int j = i * 300; j < (i + 1) * 300; ++j) {
+            const int sample = (samples[j * 2] + samples[j * 2 + 1]) / 2;
+            sum_squares += static_cast<double>(sample) * sample;
+        }
+
+        const long expected = std::lround(std::sqrt(sum_squares / 300));
+
+        ASSERT_THAT(buffer.getRmsSample(i), Eq(expected));
+    }
+
+    ASSERT_THAT(buffer.getMinSample(3), Eq(SHRT_MIN));
+    ASSERT_THAT(buffer.getMaxSample(3), Eq(SHRT_MIN));
+    ASSERT_THAT(buffer.getRmsSample(3), Eq(SHRT_MAX));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldFailIfPartialPointHasTooManySamples)
+{
+    WaveformBuffer buffer;
+    SamplesPerPixelScaleFactor scale_factor(300);
+    WaveformGenerator generator(buffer, scale_factor);
+
+    generator.setPartialPoint(0, 0, 300);
+
+    bool result = generator.init(AudioStreamInfo(44100, 1), 1024);
+
+    ASSERT_FALSE(result);
+    ASSERT_THAT(error.str(), StrEq("Invalid partial point: too many samples for zoom\n"));
+}
+
+//------------------------------------------------------------------------------
+
+static void testSplitChannels(const int channels)
+{
+    const int frames = 1000;
+
+    std::vector<short> samples(frames * channels);
+
+    srand(11);
+
+    for (auto& sample : samples) {
+        sample = static_cast<short>(rand() % 65536 - 32768);
+    }
+
+    WaveformBuffer buffer;
+
+    SamplesPerPixelScaleFactor scale_factor(300);
+    WaveformGenerator generator(buffer, scale_factor);
+    generator.setSplitChannels(true);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(44100, channels), frames));
+
+    // Process in uneven parts, so points span calls
+    ASSERT_TRUE(generator.process(&samples[0], 333));
+    ASSERT_TRUE(generator.process(&samples[333 * channels], frames - 333));
+    generator.done();
+
+    ASSERT_THAT(buffer.getChannels(), Eq(channels));
+    ASSERT_THAT(buffer.getSize(), Eq(4));
+
+    for (int i = 0; i < 4; ++i) {
+        for (int channel = 0; channel < channels; ++channel) {
+            short expected_min = SHRT_MAX;
+            short expected_max = SHRT_MIN;
+
+            for (int j = i * 300; j < std::min((i + 1) * 300, frames); ++j) {
+                expected_min = std::min(expected_min, samples[j * channels + channel]);
+                expected_max = std::max(expected_max, samples[j * channels + channel]);
+            }
+
+            ASSERT_THAT(buffer.getMinSample(channel, i), Eq(expected_min));
+            ASSERT_THAT(buffer.getMaxSample(channel, i), Eq(expected_max));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldComputeMaxAndMinValuesOfEachStereoChannel)
+{
+    testSplitChannels(2);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldComputeMaxAndMinValuesOfEachChannel)
+{
+    testSplitChannels(3);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldNotComputeRmsValuesWithSplitChannels)
+{
+    WaveformBuffer buffer;
+    buffer.setRms(true);
+
+    SamplesPerPixelScaleFactor scale_factor(300);
+    WaveformGenerator generator(buffer, scale_factor);
+    generator.setSplitChannels(true);
+
+    bool result = generator.init(AudioStreamInfo(44100, 2), 1024);
+
+    ASSERT_FALSE(result);
+    ASSERT_THAT(error.str(), StrEq("Can't generate RMS values with split channels\n"));
+}
+
+//------------------------------------------------------------------------------
+
+// Each frame's samples are summed and divided by the number of channels,
+// rounding towards zero, however many channels there are.
+
+static void testDownmix(const int channels)
+{
+    const int frames = 1001;
+
+    std::vector<short> samples(frames * channels);
+
+    srand(13);
+
+    for (auto& sample : samples) {
+        sample = static_cast<short>(rand() % 65536 - 32768);
+    }
+
+    // Frames with all samples at the minimum or maximum value
+    std::fill(samples.begin(), samples.begin() + 4 * channels, SHRT_MIN);
+    std::fill(samples.begin() + 4 * channels, samples.begin() + 8 * channels, SHRT_MAX);
+
+    WaveformBuffer buffer;
+
+    SamplesPerPixelScaleFactor scale_factor(2);
+    WaveformGenerator generator(buffer, scale_factor);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(44100, channels), frames));
+
+    // Process in uneven parts, so blocks of frames span calls
+    ASSERT_TRUE(generator.process(&samples[0], 333));
+    ASSERT_TRUE(generator.process(&samples[333 * channels], frames - 333));
+    generator.done();
+
+    ASSERT_THAT(buffer.getSize(), Eq(501));
+
+    std::vector<short> expected(frames);
+
+    for (int i = 0; i < frames; ++i) {
+        int sum = 0;
+
+        for (int channel = 0; channel < channels; ++channel) {
+            sum += samples[i * channels + channel];
+        }
+
+        expected[i] = static_cast<short>(sum / channels);
+    }
+
+    for (int i = 0; i < 501; ++i) {
+        const int end = std::min(2 * i + 2, frames);
+
+        const auto range = std::minmax_element(&expected[2 * i], &expected[0] + end);
+
+        ASSERT_THAT(buffer.getMinSample(i), Eq(*range.first));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(*range.second));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldDownmixStereoInput)
+{
+    testDownmix(2);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldDownmixSurroundInput)
+{
+    testDownmix(6);
+    testDownmix(8);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+static void generate(
+    const std::vector<T>& samples,
+    const int channels,
+    const bool split_channels,
+    WaveformBuffer& buffer)
+{
+    const int frames = static_cast<int>(samples.size()) / channels;
+
+    SamplesPerPixelScaleFactor scale_factor(3);
+    WaveformGenerator generator(buffer, scale_factor);
+    generator.setSplitChannels(split_channels);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(44100, channels), frames));
+
+    // Process in uneven parts, so blocks of frames span calls
+    ASSERT_TRUE(generator.process(&samples[0], 333));
+    ASSERT_TRUE(generator.process(&samples[333 * channels], frames - 333));
+    generator.done();
+}
+
+//------------------------------------------------------------------------------
+
+// 32-bit integer and float input should give the same waveform data as the
+// equivalent 16-bit input, as converted by libsndfile.
+
+static void testSampleFormats(const int channels, const bool split_channels)
+{
+    const int frames = 1001;
+
+    std::vector<short> short_samples(frames * channels);
+    std::vector<int> int_samples(frames * channels);
+    std::vector<float> float_samples(frames * channels);
+
+    srand(17);
+
+    for (size_t i = 0; i < short_samples.size(); ++i) {
+        const short sample = static_cast<short>(rand() % 65536 - 32768);
+
+        short_samples[i] = sample;
+
+        // Random lower 16 bits, which are discarded
+        int_samples[i] = sample * 65536 + rand() % 65536;
+
+        float_samples[i] = sample / 32767.0f;
+    }
+
+    WaveformBuffer short_buffer;
+    generate(short_samples, channels, split_channels, short_buffer);
+
+    WaveformBuffer int_buffer;
+    generate(int_samples, channels, split_channels, int_buffer);
+
+    WaveformBuffer float_buffer;
+    generate(float_samples, channels, split_channels, float_buffer);
+
+    const int output_channels = split_channels ? channels : 1;
+
+    ASSERT_THAT(short_buffer.getSize(), Eq(334));
+    ASSERT_THAT(int_buffer.getSize(), Eq(334));
+    ASSERT_THAT(float_buffer.getSize(), Eq(334));
+
+    for (int i = 0; i < 334; ++i) {
+        for (int channel = 0; channel < output_channels; ++channel) {
+            const short min = short_buffer.getMinSample(channel, i);
+            const short max = short_buffer.getMaxSample(channel, i);
+
+            ASSERT_THAT(int_buffer.getMinSample(channel, i), Eq(min));
+            ASSERT_THAT(int_buffer.getMaxSample(channel, i), Eq(max));
+            ASSERT_THAT(float_buffer.getMinSample(channel, i), Eq(min));
+            ASSERT_THAT(float_buffer.getMaxSample(channel, i), Eq(max));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldAcceptInt32AndFloatSamples)
+{
+    WaveformBuffer buffer;
+
+    SamplesPerPixelScaleFactor scale_factor(2);
+    WaveformGenerator generator(buffer, scale_factor);
+
+    ASSERT_TRUE(generator.acceptsSampleFormat(SAMPLE_FORMAT_PCM_16));
+    ASSERT_TRUE(generator.acceptsSampleFormat(SAMPLE_FORMAT_PCM_32));
+    ASSERT_TRUE(generator.acceptsSampleFormat(SAMPLE_FORMAT_FLOAT));
+    ASSERT_FALSE(generator.acceptsSampleFormat(SAMPLE_FORMAT_PCM_24));
+    ASSERT_FALSE(generator.acceptsSampleFormat(SAMPLE_FORMAT_DOUBLE));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldConvertMonoInt32AndFloatSamples)
+{
+    testSampleFormats(1, false);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldDownmixInt32AndFloatSamples)
+{
+    testSampleFormats(2, false);
+    testSampleFormats(6, false);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldSplitChannelsOfInt32AndFloatSamples)
+{
+    testSampleFormats(2, true);
+    testSampleFormats(3, true);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformGeneratorTest, shouldClampFloatSamples)
+{
+    const std::vector<float> samples{
+        2.0f, -2.0f, 1.0f, -1.0f, 0.5f, -0.5f, 1e10f, -1e10f,
+        0.0f, 0.0f, 1.5f, -1.5f
+    };
+
+    WaveformBuffer buffer;
+
+    SamplesPerPixelScaleFactor scale_factor(2);
+    WaveformGenerator generator(buffer, scale_factor);
+
+    ASSERT_TRUE(generator.init(AudioStreamInfo(44100, 1), 12));
+    ASSERT_TRUE(generator.process(&samples[0], 12));
+    generator.done();
+
+    ASSERT_THAT(buffer.getSize(), Eq(6));
+
+    const short expected[][2] = {
+        { -32768, 32767 },
+        { -32767, 32767 },
+        { -16384, 16384 },
+        { -32768, 32767 },
+        { 0, 0 },
+        { -32768, 32767 }
+    };
+
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_THAT(buffer.getMinSample(i), Eq(expected[i][0]));
+        ASSERT_THAT(buffer.getMaxSample(i), Eq(expected[i][1]));
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------
+//
+// Copyright 2014 BBC Research and Development
+//
+// Author: Chris Needham
+//
+// This file is part of Audio Waveform Image Generator.
+//
+// Audio Waveform Image Generator is free software: you can redistribute it
+// and/or modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation, either version 3 of the License,
+// or (at your option) any later version.
+//
+// Audio Waveform Image Generator is distributed in the hope that it will be
+// useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// Audio Waveform Image Generator.  If not, see <http://www.gnu.org/licenses/>.
+//
+//------------------------------------------------------------------------------
+
+#include "WaveformIndex.h"
+#include "WaveformBuffer.h"
+#include "WaveformRescaler.h"
+#include "util/FileDeleter.h"
+#include "util/FileUtil.h"
+#include "util/Streams.h"
+
+#include "gmock/gmock.h"
+
+#include <cstdlib>
+
+//------------------------------------------------------------------------------
+
+using testing::Eq;
+using testing::StartsWith;
+using testing::Test;
+
+//------------------------------------------------------------------------------
+
+class WaveformIndexTest : public Test
+{
+    protected:
+        virtual void SetUp()
+        {
+            output.str(std::string());
+            error.str(std::string());
+
+            buffer_.setSampleRate(44100);
+            buffer_.setSamplesPerPixel(64);
+
+            srand(1);
+
+            for (int i = 0; i < 10000; ++i) {
+                const short a = static_cast<short>(rand() % 65536 - 32768);
+                const short b = static_cast<short>(rand() % 65536 - 32768);
+
+                buffer_.appendSamples(std::min(a, b), std::max(a, b));
+            }
+        }
+
+        virtual void TearDown()
+        {
+        }
+
+        void checkMinMax(const WaveformIndex& index, int start, int end);
+
+        WaveformBuffer buffer_;
+};
+
+//------------------------------------------------------------------------------
+
+void WaveformIndexTest::checkMinMax(const WaveformIndex& index, int start, int end)
+{
+    short expected_min = buffer_.getMinSample(start);
+    short expected_max = buffer_.getMaxSample(start);
+
+    for (int i = start + 1; i < end; ++i) {
+        expected_min = std::min(expected_min, buffer_.getMinSample(i));
+        expected_max = std::max(expected_max, buffer_.getMaxSample(i));
+    }
+
+    short min;
+    short max;
+
+    index.getMinMax(start, end, min, max);
+
+    ASSERT_THAT(min, Eq(expected_min));
+    ASSERT_THAT(max, Eq(expected_max));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformIndexTest, shouldBuildLevels)
+{
+    WaveformIndex index(buffer_);
+    index.build();
+
+    // 10000 -> 625 -> 40 -> 3
+    ASSERT_THAT(index.getLevelCount(), Eq(3));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformIndexTest, shouldReturnMinAndMaxOverAnyRange)
+{
+    WaveformIndex index(buffer_);
+    index.build();
+
+    const int ranges[][2] = {
+        { 0, 1 }, { 0, 10000 }, { 15, 17 }, { 16, 32 }, { 5, 4999 },
+        { 255, 257 }, { 1000, 9001 }, { 9999, 10000 }, { 4096, 8192 }
+    };
+
+    for (const auto& range : ranges) {
+        checkMinMax(index, range[0], range[1]);
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        const int start = rand() % 10000;
+        const int end   = start + 1 + rand() % (10000 - start);
+
+        checkMinMax(index, start, end);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformIndexTest, shouldRescaleSameAsLinearRescaler)
+{
+    WaveformIndex index(buffer_);
+    index.build();
+
+    const int zoom_levels[] = { 65, 128, 100, 1000, 64 * 16, 64 * 333, 1000000 };
+
+    for (const int zoom : zoom_levels) {
+        WaveformBuffer expected;
+        WaveformBuffer actual;
+
+        WaveformRescaler rescaler;
+        ASSERT_TRUE(rescaler.rescale(buffer_, expected, zoom));
+        ASSERT_TRUE(rescaler.rescale(buffer_, index, actual, zoom));
+
+        ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+        ASSERT_THAT(actual.getSamplesPerPixel(), Eq(zoom));
+
+        for (int i = 0; i < expected.getSize(); ++i) {
+            ASSERT_THAT(actual.getMinSample(i), Eq(expected.getMinSample(i)));
+            ASSERT_THAT(actual.getMaxSample(i), Eq(expected.getMaxSample(i)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformIndexTest, shouldRescaleRangeSameAsLinearRescaler)
+{
+    WaveformIndex index(buffer_);
+    index.build();
+
+    WaveformBuffer expected;
+
+    WaveformRescaler rescaler;
+    ASSERT_TRUE(rescaler.rescale(buffer_, expected, 100));
+
+    const int ranges[][2] = { { 0, 10 }, { 37, 800 }, { 6000, 400 } };
+
+    for (const auto& range : ranges) {
+        const int start = range[0];
+        const long long count = std::min<long long>(range[1], expected.getSize() - start);
+
+        WaveformBuffer actual;
+        ASSERT_TRUE(rescaler.rescale(buffer_, index, actual, 100, range[0], range[1]));
+
+        ASSERT_THAT(actual.getSize(), Eq(count));
+
+        for (long long i = 0; i < count; ++i) {
+            ASSERT_THAT(actual.getMinSample(i), Eq(expected.getMinSample(start + i)));
+            ASSERT_THAT(actual.getMaxSample(i), Eq(expected.getMaxSample(start + i)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformIndexTest, shouldSaveAndLoadIndex)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".idx");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    WaveformIndex index(buffer_);
+    index.build();
+
+    bool result = index.save(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    WaveformIndex loaded_index(buffer_);
+
+    result = loaded_index.load(filename.string().c_str());
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(error.str().empty());
+
+    ASSERT_THAT(loaded_index.getLevelCount(), Eq(3));
+
+    checkMinMax(loaded_index, 3, 9876);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformIndexTest, shouldReportErrorIfIndexDoesNotMatchBuffer)
+{
+    const boost::filesystem::path filename = FileUtil::getTempFilename(".idx");
+
+    // Ensure temporary file is deleted at end of test.
+    FileDeleter deleter(filename);
+
+    WaveformIndex index(buffer_);
+    index.build();
+
+    bool result = index.save(filename.string().c_str());
+    ASSERT_TRUE(result);
+
+    buffer_.appendSamples(0, 0);
+
+    WaveformIndex loaded_index(buffer_);
+
+    result = loaded_index.load(filename.string().c_str());
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), StartsWith("Failed to read index file"));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformIndexTest, shouldReportErrorIfFileNotFound)
+{
+    WaveformIndex index(buffer_);
+
+    bool result = index.load("../test/data/unknown.dat.idx");
+    ASSERT_FALSE(result);
+
+    ASSERT_THAT(error.str(), StartsWith("Failed to read index file"));
+}
+
+//------------------------------------------------------------------------------
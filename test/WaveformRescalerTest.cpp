@@ -26,6 +26,10 @@
 
 #include "gmock/gmock.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
 //------------------------------------------------------------------------------
 
 using testing::Eq;
@@ -123,3 +127,498 @@ TEST_F(WaveformRescalerTest, shouldRescale16BitWaveformData)
 }
 
 //------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescaleRangeOfWaveformData)
+{
+    WaveformBuffer input_buffer;
+    bool result = input_buffer.load("../test/data/test_file_stereo_16bit_64spp.dat");
+
+    ASSERT_TRUE(result);
+
+    WaveformBuffer expected;
+
+    result = rescaler_.rescale(input_buffer, expected, 300);
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(expected.getSize(), Eq(384));
+
+    WaveformBuffer output_buffer;
+
+    result = rescaler_.rescale(input_buffer, output_buffer, 300, 100, 50);
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output_buffer.getSize(), Eq(50));
+    ASSERT_THAT(output_buffer.getSampleRate(), Eq(16000));
+    ASSERT_THAT(output_buffer.getSamplesPerPixel(), Eq(300));
+
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_THAT(output_buffer.getMinSample(i), Eq(expected.getMinSample(100 + i)));
+        ASSERT_THAT(output_buffer.getMaxSample(i), Eq(expected.getMaxSample(100 + i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldStopRangeAtEndOfWaveformData)
+{
+    WaveformBuffer input_buffer;
+    bool result = input_buffer.load("../test/data/test_file_stereo_16bit_64spp.dat");
+
+    ASSERT_TRUE(result);
+
+    WaveformBuffer output_buffer;
+
+    result = rescaler_.rescale(input_buffer, output_buffer, 128, 850, 100);
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output_buffer.getSize(), Eq(50));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescaleByWholeMultipleOfInputScale)
+{
+    WaveformBuffer input_buffer;
+
+    input_buffer.setSampleRate(44100);
+    input_buffer.setSamplesPerPixel(64);
+
+    srand(1);
+
+    for (int i = 0; i < 1001; ++i) {
+        const short a = static_cast<short>(rand() % 65536 - 32768);
+        const short b = static_cast<short>(rand() % 65536 - 32768);
+
+        input_buffer.appendSamples(std::min(a, b), std::max(a, b));
+    }
+
+    const int ratios[] = { 2, 3, 4, 5, 7, 8, 9, 16, 33, 1000, 2000 };
+
+    for (const int ratio : ratios) {
+        WaveformBuffer output_buffer;
+
+        bool result = rescaler_.rescale(input_buffer, output_buffer, 64 * ratio);
+
+        ASSERT_TRUE(result);
+        ASSERT_THAT(output_buffer.getSize(), Eq((1001 + ratio - 1) / ratio));
+
+        for (int x = 0; x < output_buffer.getSize(); ++x) {
+            const int start = x * ratio;
+            const int end   = std::min(start + ratio, 1001);
+
+            short min = input_buffer.getMinSample(start);
+            short max = input_buffer.getMaxSample(start);
+
+            for (int i = start + 1; i < end; ++i) {
+                min = std::min(min, input_buffer.getMinSample(i));
+                max = std::max(max, input_buffer.getMaxSample(i));
+            }
+
+            ASSERT_THAT(output_buffer.getMinSample(x), Eq(min));
+            ASSERT_THAT(output_buffer.getMaxSample(x), Eq(max));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescaleToSeveralZoomLevels)
+{
+    WaveformBuffer input_buffer;
+    bool result = input_buffer.load("../test/data/test_file_stereo_16bit_64spp.dat");
+
+    ASSERT_TRUE(result);
+
+    // 256 and 1024 are rescaled from 128, 3000 from 300, 500 from the input
+    const std::vector<int> zoom_levels{ 128, 256, 300, 500, 1024, 3000 };
+
+    std::vector<const WaveformBuffer*> output_buffers;
+
+    result = rescaler_.rescale(input_buffer, zoom_levels, output_buffers);
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output_buffers.size(), Eq(zoom_levels.size()));
+
+    for (size_t i = 0; i < zoom_levels.size(); ++i) {
+        WaveformBuffer expected;
+
+        result = rescaler_.rescale(input_buffer, expected, zoom_levels[i]);
+        ASSERT_TRUE(result);
+
+        const WaveformBuffer& actual = *output_buffers[i];
+
+        ASSERT_THAT(actual.getSamplesPerPixel(), Eq(zoom_levels[i]));
+        ASSERT_THAT(actual.getSampleRate(), Eq(16000));
+        ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+
+        for (int j = 0; j < expected.getSize(); ++j) {
+            ASSERT_THAT(actual.getMinSample(j), Eq(expected.getMinSample(j)));
+            ASSERT_THAT(actual.getMaxSample(j), Eq(expected.getMaxSample(j)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescaleToZoomLevelsInAnyOrder)
+{
+    WaveformBuffer input_buffer;
+    bool result = input_buffer.load("../test/data/test_file_stereo_16bit_64spp.dat");
+
+    ASSERT_TRUE(result);
+
+    const std::vector<int> zoom_levels{ 512, 64, 128, 512, 256, 64 };
+
+    std::vector<const WaveformBuffer*> output_buffers;
+
+    result = rescaler_.rescale(input_buffer, zoom_levels, output_buffers);
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output_buffers.size(), Eq(zoom_levels.size()));
+
+    // Levels equal to the input scale use the input buffer, and repeated
+    // levels are rescaled once
+    ASSERT_THAT(output_buffers[1], Eq(&input_buffer));
+    ASSERT_THAT(output_buffers[5], Eq(&input_buffer));
+    ASSERT_THAT(output_buffers[3], Eq(output_buffers[0]));
+
+    for (size_t i = 0; i < zoom_levels.size(); ++i) {
+        if (zoom_levels[i] == 64) {
+            continue;
+        }
+
+        WaveformBuffer expected;
+
+        result = rescaler_.rescale(input_buffer, expected, zoom_levels[i]);
+        ASSERT_TRUE(result);
+
+        const WaveformBuffer& actual = *output_buffers[i];
+
+        ASSERT_THAT(actual.getSamplesPerPixel(), Eq(zoom_levels[i]));
+        ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+
+        for (int j = 0; j < expected.getSize(); ++j) {
+            ASSERT_THAT(actual.getMinSample(j), Eq(expected.getMinSample(j)));
+            ASSERT_THAT(actual.getMaxSample(j), Eq(expected.getMaxSample(j)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescale8BitDataWithoutWidening)
+{
+    WaveformBuffer input_buffer;
+    bool result = input_buffer.load("../test/data/test_file_stereo_8bit_64spp.dat");
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(input_buffer.getBits(), Eq(8));
+
+    WaveformBuffer wide_buffer;
+    wide_buffer.setSampleRate(input_buffer.getSampleRate());
+    wide_buffer.setSamplesPerPixel(input_buffer.getSamplesPerPixel());
+
+    for (int i = 0; i < input_buffer.getSize(); ++i) {
+        wide_buffer.appendSamples(input_buffer.getMinSample(i), input_buffer.getMaxSample(i));
+    }
+
+    const int zoom_levels[] = { 128, 300, 64 * 20, 64 * 1000 };
+
+    for (const int zoom : zoom_levels) {
+        WaveformBuffer expected;
+        WaveformBuffer actual;
+
+        ASSERT_TRUE(rescaler_.rescale(wide_buffer, expected, zoom));
+        ASSERT_TRUE(rescaler_.rescale(input_buffer, actual, zoom));
+
+        ASSERT_THAT(actual.getBits(), Eq(8));
+        ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+
+        for (int i = 0; i < expected.getSize(); ++i) {
+            ASSERT_THAT(actual.getMinSample(i), Eq(expected.getMinSample(i)));
+            ASSERT_THAT(actual.getMaxSample(i), Eq(expected.getMaxSample(i)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescaleAcrossStorageChunks)
+{
+    WaveformBuffer input_buffer;
+
+    input_buffer.setSampleRate(44100);
+    input_buffer.setSamplesPerPixel(64);
+
+    srand(2);
+
+    // More points than fit in one chunk of the buffer's storage
+    const int size = 100000;
+
+    for (int i = 0; i < size; ++i) {
+        const short a = static_cast<short>(rand() % 65536 - 32768);
+        const short b = static_cast<short>(rand() % 65536 - 32768);
+
+        input_buffer.appendSamples(std::min(a, b), std::max(a, b));
+    }
+
+    WaveformBuffer output_buffer;
+
+    bool result = rescaler_.rescale(input_buffer, output_buffer, 64 * 7);
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(output_buffer.getSize(), Eq((size + 6) / 7));
+
+    for (int x = 0; x < output_buffer.getSize(); ++x) {
+        short min = input_buffer.getMinSample(x * 7);
+        short max = input_buffer.getMaxSample(x * 7);
+
+        for (int i = x * 7 + 1; i < std::min(x * 7 + 7, size); ++i) {
+            min = std::min(min, input_buffer.getMinSample(i));
+            max = std::max(max, input_buffer.getMaxSample(i));
+        }
+
+        ASSERT_THAT(output_buffer.getMinSample(x), Eq(min));
+        ASSERT_THAT(output_buffer.getMaxSample(x), Eq(max));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescaleMultiDayWaveformData)
+{
+    WaveformBuffer input_buffer;
+
+    // 72 hours at 48 kHz is more than 2^31 samples
+    const int sample_rate = 48000;
+    const int input_samples_per_pixel = 4800;
+    const long long size = 72LL * 60 * 60 * sample_rate / input_samples_per_pixel;
+
+    input_buffer.setSampleRate(sample_rate);
+    input_buffer.setSamplesPerPixel(input_samples_per_pixel);
+
+    srand(3);
+
+    for (long long i = 0; i < size; ++i) {
+        const short a = static_cast<short>(rand() % 65536 - 32768);
+        const short b = static_cast<short>(rand() % 65536 - 32768);
+
+        input_buffer.appendSamples(std::min(a, b), std::max(a, b));
+    }
+
+    // Not a whole multiple of the input scale
+    const int samples_per_pixel = 7000;
+
+    WaveformBuffer output_buffer;
+
+    bool result = rescaler_.rescale(input_buffer, output_buffer, samples_per_pixel);
+
+    ASSERT_TRUE(result);
+
+    const long long output_size =
+        (size * input_samples_per_pixel + samples_per_pixel - 1) / samples_per_pixel;
+
+    ASSERT_THAT(output_buffer.getSize(), Eq(output_size));
+
+    // Check the last hour, where sample offsets exceed 2^31
+    for (long long x = output_size - 60 * 60 * sample_rate / samples_per_pixel; x < output_size; ++x) {
+        const long long start = x * samples_per_pixel / input_samples_per_pixel;
+        const long long end   = std::min(
+            (x + 1) * samples_per_pixel / input_samples_per_pixel,
+            size
+        );
+
+        short min = input_buffer.getMinSample(start);
+        short max = input_buffer.getMaxSample(start);
+
+        for (long long i = start + 1; i < end; ++i) {
+            min = std::min(min, input_buffer.getMinSample(i));
+            max = std::max(max, input_buffer.getMaxSample(i));
+        }
+
+        ASSERT_THAT(output_buffer.getMinSample(x), Eq(min));
+        ASSERT_THAT(output_buffer.getMaxSample(x), Eq(max));
+    }
+
+    // A range from the end of the waveform gives the same points
+    WaveformBuffer range_buffer;
+
+    const long long start_index = output_size - 1000;
+
+    result = rescaler_.rescale(
+        input_buffer,
+        range_buffer,
+        samples_per_pixel,
+        start_index,
+        1000
+    );
+
+    ASSERT_TRUE(result);
+    ASSERT_THAT(range_buffer.getSize(), Eq(1000));
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_THAT(range_buffer.getMinSample(i), Eq(output_buffer.getMinSample(start_index + i)));
+        ASSERT_THAT(range_buffer.getMaxSample(i), Eq(output_buffer.getMaxSample(start_index + i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Each output RMS value is the RMS of the input points' RMS values, which is
+// the RMS of the input samples they cover.
+
+TEST_F(WaveformRescalerTest, shouldRescaleRmsValues)
+{
+    WaveformBuffer input_buffer;
+
+    input_buffer.setSampleRate(48000);
+    input_buffer.setSamplesPerPixel(512);
+    input_buffer.setRms(true);
+
+    input_buffer.appendSamples(-5, 5, 3);
+    input_buffer.appendSamples(-6, 6, 4);
+    input_buffer.appendSamples(-50, 50, 30);
+    input_buffer.appendSamples(-60, 60, 40);
+    input_buffer.appendSamples(-10, 10, 7);
+
+    WaveformBuffer output_buffer;
+
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, output_buffer, 1024));
+
+    ASSERT_TRUE(output_buffer.hasRms());
+    ASSERT_THAT(output_buffer.getSize(), Eq(3));
+    ASSERT_THAT(output_buffer.getRmsSample(0), Eq(4));
+    ASSERT_THAT(output_buffer.getRmsSample(1), Eq(35));
+    ASSERT_THAT(output_buffer.getRmsSample(2), Eq(7));
+
+    // Rescaling a range, and by a scale that isn't a whole multiple of the
+    // input scale, give the same values
+    WaveformBuffer range_buffer;
+
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, range_buffer, 1024, 1, 2));
+
+    ASSERT_TRUE(range_buffer.hasRms());
+    ASSERT_THAT(range_buffer.getSize(), Eq(2));
+    ASSERT_THAT(range_buffer.getRmsSample(0), Eq(35));
+    ASSERT_THAT(range_buffer.getRmsSample(1), Eq(7));
+
+    WaveformBuffer expected;
+    WaveformBuffer actual;
+
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, expected, 768));
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, actual, 768, 0, 10));
+
+    ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+
+    for (long long i = 0; i < expected.getSize(); ++i) {
+        ASSERT_THAT(actual.getRmsSample(i), Eq(expected.getRmsSample(i)));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Cascading between zoom levels would round the RMS values at each level, so
+// these should match rescaling the input directly.
+
+TEST_F(WaveformRescalerTest, shouldRescaleRmsValuesToSeveralZoomLevels)
+{
+    WaveformBuffer input_buffer;
+
+    input_buffer.setSampleRate(48000);
+    input_buffer.setSamplesPerPixel(64);
+    input_buffer.setRms(true);
+
+    srand(1);
+
+    for (int i = 0; i < 10000; ++i) {
+        const short value = static_cast<short>(rand() % 32768);
+        input_buffer.appendSamples(
+            static_cast<short>(-value),
+            value,
+            static_cast<short>(value / 2)
+        );
+    }
+
+    const std::vector<int> zoom_levels{ 128, 256, 768 };
+
+    std::vector<const WaveformBuffer*> output_buffers;
+
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, zoom_levels, output_buffers));
+    ASSERT_THAT(output_buffers.size(), Eq(zoom_levels.size()));
+
+    for (size_t i = 0; i < zoom_levels.size(); ++i) {
+        WaveformBuffer expected;
+        ASSERT_TRUE(rescaler_.rescale(input_buffer, expected, zoom_levels[i]));
+
+        const WaveformBuffer& actual = *output_buffers[i];
+
+        ASSERT_TRUE(actual.hasRms());
+        ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+
+        for (long long j = 0; j < expected.getSize(); ++j) {
+            ASSERT_THAT(actual.getRmsSample(j), Eq(expected.getRmsSample(j)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+TEST_F(WaveformRescalerTest, shouldRescaleEachChannel)
+{
+    WaveformBuffer input_buffer;
+
+    input_buffer.setSampleRate(48000);
+    input_buffer.setSamplesPerPixel(512);
+    input_buffer.setChannels(2);
+
+    const short values[][4] = {
+        { -5, 5, -1, 1 },
+        { -6, 4, -2, 3 },
+        { -50, 50, -9, 20 },
+        { -40, 60, -30, 10 },
+        { -10, 10, -7, 8 }
+    };
+
+    for (const auto& point : values) {
+        input_buffer.appendSamples(point[0], point[1]);
+        input_buffer.appendSamples(point[2], point[3]);
+    }
+
+    WaveformBuffer output_buffer;
+
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, output_buffer, 1024));
+
+    ASSERT_THAT(output_buffer.getChannels(), Eq(2));
+    ASSERT_THAT(output_buffer.getSize(), Eq(3));
+
+    ASSERT_THAT(output_buffer.getMinSample(0, 0), Eq(-6));
+    ASSERT_THAT(output_buffer.getMaxSample(0, 0), Eq(5));
+    ASSERT_THAT(output_buffer.getMinSample(1, 0), Eq(-2));
+    ASSERT_THAT(output_buffer.getMaxSample(1, 0), Eq(3));
+    ASSERT_THAT(output_buffer.getMinSample(0, 1), Eq(-50));
+    ASSERT_THAT(output_buffer.getMaxSample(0, 1), Eq(60));
+    ASSERT_THAT(output_buffer.getMinSample(1, 1), Eq(-30));
+    ASSERT_THAT(output_buffer.getMaxSample(1, 1), Eq(20));
+    ASSERT_THAT(output_buffer.getMinSample(1, 2), Eq(-7));
+    ASSERT_THAT(output_buffer.getMaxSample(1, 2), Eq(8));
+
+    // Rescaling a range, and by a scale that isn't a whole multiple of the
+    // input scale, give the same values
+    WaveformBuffer expected;
+    WaveformBuffer actual;
+
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, expected, 768));
+    ASSERT_TRUE(rescaler_.rescale(input_buffer, actual, 768, 0, 10));
+
+    ASSERT_THAT(actual.getChannels(), Eq(2));
+    ASSERT_THAT(actual.getSize(), Eq(expected.getSize()));
+
+    for (long long i = 0; i < expected.getSize(); ++i) {
+        for (int channel = 0; channel < 2; ++channel) {
+            ASSERT_THAT(actual.getMinSample(channel, i), Eq(expected.getMinSample(channel, i)));
+            ASSERT_THAT(actual.getMaxSample(channel, i), Eq(expected.getMaxSample(channel, i)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
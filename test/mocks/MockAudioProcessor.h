@@ -35,13 +35,20 @@
 class MockAudioProcessor : public AudioProcessor
 {
     public:
-        MOCK_METHOD3(init, bool(int sample_rate, int channels, int buffer_size));
+        MOCK_METHOD2(init, bool(const AudioStreamInfo& info, int buffer_size));
         MOCK_METHOD2(process, bool(const short* buffer, int frame_count));
         MOCK_METHOD0(done, void());
 };
 
 //------------------------------------------------------------------------------
 
+MATCHER_P2(StreamInfo, sample_rate, channels, "")
+{
+    return arg.sample_rate == sample_rate && arg.channels == channels;
+}
+
+//------------------------------------------------------------------------------
+
 #endif // #if !defined(INC_MOCK_AUDIO_PROCESSOR_H)
 
 //------------------------------------------------------------------------------
@@ -23,6 +23,10 @@
 
 #include "FileUtil.h"
 
+#include <zlib.h>
+
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 
 //------------------------------------------------------------------------------
@@ -82,6 +86,59 @@ std::string readTextFile(const boost::filesystem::path& filename)
 
 //------------------------------------------------------------------------------
 
+std::string readGzipFile(const boost::filesystem::path& filename)
+{
+    std::vector<uint8_t> data = readFile(filename);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    std::string str;
+
+    if (data.empty() || inflateInit2(&stream, 15 + 16) != Z_OK) {
+        return str;
+    }
+
+    stream.next_in  = &data[0];
+    stream.avail_in = static_cast<uInt>(data.size());
+
+    char buffer[1024];
+
+    int result;
+
+    do {
+        stream.next_out  = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+
+        result = inflate(&stream, Z_NO_FLUSH);
+
+        str.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    while (result == Z_OK);
+
+    inflateEnd(&stream);
+
+    return result == Z_STREAM_END ? str : std::string();
+}
+
+//------------------------------------------------------------------------------
+
+gdImagePtr readPngFile(const boost::filesystem::path& filename)
+{
+    FILE* file = fopen(filename.string().c_str(), "rb");
+
+    if (file == nullptr) {
+        return nullptr;
+    }
+
+    gdImagePtr image = gdImageCreateFromPng(file);
+    fclose(file);
+
+    return image;
+}
+
+//------------------------------------------------------------------------------
+
 } // namespace FileUtil
 
 //------------------------------------------------------------------------------
@@ -28,6 +28,8 @@
 #include "nullptr.h"
 #include <boost/filesystem.hpp>
 
+#include <gd.h>
+
 #include <vector>
 
 //------------------------------------------------------------------------------
@@ -38,6 +40,14 @@ namespace FileUtil {
     std::vector<uint8_t> readFile(const boost::filesystem::path& filename);
 
     std::string readTextFile(const boost::filesystem::path& filename);
+
+    // Returns the decompressed contents of a gzip file, or an empty string if
+    // the file isn't valid gzip data.
+    std::string readGzipFile(const boost::filesystem::path& filename);
+
+    // Returns the image, which the caller must free with gdImageDestroy(), or
+    // nullptr if the file can't be read.
+    gdImagePtr readPngFile(const boost::filesystem::path& filename);
 }
 
 //------------------------------------------------------------------------------